@@ -0,0 +1,779 @@
+/*
+  ==============================================================================
+
+    BatchChain.cpp
+
+  ==============================================================================
+*/
+
+#include "BatchChain.h"
+#include "../DSP/SIMDLadderFilter.h"
+
+BatchChain::Parameters BatchChain::Parameters::fromProcessor (const MultieffectsAudioProcessor& processor)
+{
+    Parameters p;
+
+    p.phaserRateHz = processor.phaserRateHz->get();
+    p.phaserCenterFreqHz = processor.phaserCenterFreqHz->get();
+    p.phaserDepth = processor.phaserDepthPercent->get();
+    p.phaserFeedback = processor.phaserFeedbackPercent->get();
+    p.phaserMix = processor.phaserMixPercent->get();
+    p.phaserModulation = processor.phaserModulation->getIndex();
+
+    p.chorusRateHz = processor.chorusRateHz->get();
+    p.chorusDepth = processor.chorusDepthPercent->get();
+    p.chorusCenterDelayMs = processor.chorusCenterDelayMs->get();
+    p.chorusFeedback = processor.chorusFeedbackPercent->get();
+    p.chorusMix = processor.chorusMixPercent->get();
+    p.chorusModulation = processor.chorusModulation->getIndex();
+
+    p.overdriveSaturation = processor.overdriveSaturation->get();
+
+    p.ladderMode = processor.ladderFilterMode->getIndex();
+    p.ladderCutoffHz = processor.ladderFilterCutoffHz->get();
+    p.ladderResonance = processor.ladderFilterResonance->get();
+    p.ladderDrive = processor.ladderFilterDrive->get();
+
+    p.filterMode = processor.generalFilterMode->getIndex();
+    p.filterFreqHz = processor.generalFilterFreqHz->get();
+    p.filterQuality = processor.generalFilterQuality->get();
+    p.filterGain = processor.generalFilterGain->get();
+
+    p.delayTimeMs = processor.getDelayTimeMs();
+    p.delayFeedback = processor.delayFeedbackPercent->get();
+    p.delayMix = processor.delayMixPercent->get();
+
+    return p;
+}
+
+double BatchChain::Parameters::getTailSeconds() const
+{
+    //every stage once in a row, so the tails add up. nothing is oversampled, so the
+    //overdrive doesn't ring and the ladder has no filters behind it
+    return TailModel::getPhaserSeconds (LFOPhaser::numStages, phaserFeedback)
+         + TailModel::getChorusSeconds (chorusCenterDelayMs, chorusDepth, LFOChorus::maximumDelayModulation, chorusFeedback)
+         + TailModel::getLadderSeconds (ladderCutoffHz, SIMDLadderFilter::getScaledResonance (ladderResonance), 0.0, 0.0)
+         + TailModel::getBiquadSeconds (filterFreqHz, filterQuality, filterGain)
+         + TailModel::getDelaySeconds (delayTimeMs, delayFeedback, FeedbackDelay::glideSeconds);
+}
+
+//==============================================================================
+void BatchChain::LaneSmoother::reset (double rate, double rampLengthSeconds) noexcept
+{
+    stepsToTarget = (int) std::floor (rampLengthSeconds * rate);
+    skip();
+}
+
+void BatchChain::LaneSmoother::setTargetValue (size_t lane, float newTarget) noexcept
+{
+    if (target.get (lane) == newTarget)
+        return;
+
+    target.set (lane, newTarget);
+
+    if (stepsToTarget <= 0)
+    {
+        skip();
+        return;
+    }
+
+    countdown = stepsToTarget;
+    step = (target - current) * (1.f / (float) stepsToTarget);
+}
+
+void BatchChain::LaneSmoother::skip() noexcept
+{
+    current = target;
+    countdown = 0;
+}
+
+BatchChain::Vec BatchChain::LaneSmoother::getNextValue() noexcept
+{
+    if (countdown == 0)
+        return target;
+
+    if (--countdown == 0)
+        current = target;
+    else
+        current += step;
+
+    return current;
+}
+
+//==============================================================================
+BatchChain::BatchChain()
+{
+}
+
+BatchChain::~BatchChain()
+{
+}
+
+void BatchChain::prepare (double newSampleRate, int newNumInstances, int newNumChannels)
+{
+    jassert (newSampleRate > 0.0 && newNumInstances > 0 && newNumChannels > 0);
+
+    sampleRate = newSampleRate;
+    numInstances = juce::jmax (1, newNumInstances);
+    numChannels = juce::jmax (1, newNumChannels);
+
+    const auto channels = (size_t) numChannels;
+    const auto numGroups = ((size_t) numInstances + lanes - 1) / lanes;
+
+    parameters.resize ((size_t) numInstances);
+    groups.assign (numGroups, Group{});
+    frames.resize (channels * chunkSize);
+
+    //per channel modulation gives every channel its own phase, up to the lfo's maximum
+    maxLFOPhases = juce::jmin (numChannels, ControlRateLFO::maxPhases);
+    lfoValues.resize (lanes * (size_t) maxLFOPhases * chunkSize);
+
+    //same maximum as juce::dsp::Chorus: 100 ms centre delay plus 10 ms of modulation
+    const auto delaySize = juce::nextPowerOfTwo ((int) std::ceil (110.0 * sampleRate / 1000.0) + 2);
+    delayMask = delaySize - 1;
+
+    const auto feedbackDelaySize = juce::nextPowerOfTwo ((int) std::ceil (FeedbackDelay::maxDelaySeconds * sampleRate) + 2);
+    feedbackDelayMask = feedbackDelaySize - 1;
+
+    for (auto& group : groups)
+    {
+        for (auto* laneLFOs : { static_cast<LaneLFOs*> (&group.phaser), static_cast<LaneLFOs*> (&group.chorus) })
+        {
+            for (auto& lfo : laneLFOs->lfos)
+            {
+                lfo.prepare (sampleRate);
+                lfo.setControlInterval (controlInterval);
+            }
+        }
+
+        group.phaser.channels.resize (channels);
+        group.phaser.feedback.reset (sampleRate, rampLengthSeconds);
+        group.phaser.mix.reset (sampleRate, rampLengthSeconds);
+
+        group.chorus.lastOutputs.resize (channels);
+        group.chorus.delayLines.resize (channels * (size_t) delaySize);
+        group.chorus.feedback.reset (sampleRate, rampLengthSeconds);
+        group.chorus.mix.reset (sampleRate, rampLengthSeconds);
+
+        group.ladder.channels.resize (channels);
+        group.ladder.cutoffTransform.reset (sampleRate, rampLengthSeconds);
+        group.ladder.scaledResonance.reset (sampleRate, rampLengthSeconds);
+
+        group.filter.channels.resize (channels);
+
+        group.delay.lines.resize (channels * (size_t) feedbackDelaySize);
+        group.delay.time.reset (sampleRate, FeedbackDelay::glideSeconds);
+        group.delay.feedback.reset (sampleRate, rampLengthSeconds);
+        group.delay.mix.reset (sampleRate, rampLengthSeconds);
+    }
+
+    //lanes past the last instance get the defaults, so they run on sane coefficients
+    for (size_t i = 0; i < numGroups * lanes; ++i)
+        applyParameters (i, i < parameters.size() ? parameters[i] : Parameters());
+
+    reset();
+}
+
+void BatchChain::reset()
+{
+    const auto zero = Vec::expand (0.f);
+
+    for (auto& group : groups)
+    {
+        //the depths ramp like LFOPhaser's once per control point and like LFOChorus's every sample
+        auto& phaser = group.phaser;
+        auto& chorus = group.chorus;
+
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            phaser.lfos[lane].reset();
+            phaser.depths[lane].reset (sampleRate / phaser.lfos[lane].getControlInterval(), rampLengthSeconds);
+            chorus.lfos[lane].reset();
+            chorus.depths[lane].reset (sampleRate, rampLengthSeconds);
+        }
+
+        phaser.feedback.skip();
+        phaser.mix.skip();
+
+        for (auto& channel : phaser.channels)
+        {
+            channel.s.fill (zero);
+            channel.lastOutput = zero;
+        }
+
+        chorus.writePosition = 0;
+        chorus.feedback.skip();
+        chorus.mix.skip();
+        std::fill (chorus.lastOutputs.begin(), chorus.lastOutputs.end(), zero);
+        std::fill (chorus.delayLines.begin(), chorus.delayLines.end(), zero);
+
+        auto& ladder = group.ladder;
+        ladder.cutoffTransform.skip();
+        ladder.scaledResonance.skip();
+
+        for (auto& state : ladder.channels)
+            state.fill (zero);
+
+        for (auto& channel : group.filter.channels)
+            channel = { zero, zero };
+
+        auto& delay = group.delay;
+        delay.writePosition = 0;
+        delay.time.skip();
+        delay.feedback.skip();
+        delay.mix.skip();
+        std::fill (delay.lines.begin(), delay.lines.end(), zero);
+    }
+}
+
+//==============================================================================
+void BatchChain::setParameters (int instance, const Parameters& newParameters)
+{
+    jassert (juce::isPositiveAndBelow (instance, numInstances));
+
+    if (! juce::isPositiveAndBelow (instance, numInstances))
+        return;
+
+    parameters[(size_t) instance] = newParameters;
+    applyParameters ((size_t) instance, newParameters);
+}
+
+const BatchChain::Parameters& BatchChain::getParameters (int instance) const
+{
+    jassert (juce::isPositiveAndBelow (instance, numInstances));
+    return parameters[(size_t) instance];
+}
+
+void BatchChain::applyParameters (size_t instance, const Parameters& p)
+{
+    auto& group = groups[instance / lanes];
+    const auto lane = instance % lanes;
+
+    static constexpr auto twoPi = juce::MathConstants<double>::twoPi;
+
+    //phaser, its lfo runs at the control rate
+    auto& phaser = group.phaser;
+    const auto maxPhaserFrequency = (float) juce::jmin (20000.0, 0.49 * sampleRate);
+
+    phaser.lfos[lane].setFrequency (p.phaserRateHz);
+    phaser.depths[lane].setTargetValue (p.phaserDepth * 0.5f);
+    phaser.modulations[lane] = static_cast<ControlRateLFO::Modulation> (p.phaserModulation);
+    phaser.normCentreFrequency.set (lane, juce::mapFromLog10 (p.phaserCenterFreqHz, 20.f, maxPhaserFrequency));
+    phaser.feedback.setTargetValue (lane, p.phaserFeedback);
+    phaser.mix.setTargetValue (lane, p.phaserMix);
+
+    //chorus, rate and centre delay must stay below 100 like in the processor
+    auto& chorus = group.chorus;
+    chorus.lfos[lane].setFrequency (juce::jmin (p.chorusRateHz, 99.99f));
+    chorus.depths[lane].setTargetValue (p.chorusDepth * 0.5f);
+    chorus.modulations[lane] = static_cast<ControlRateLFO::Modulation> (p.chorusModulation);
+    chorus.centreDelayMs.set (lane, juce::jlimit (1.f, (float) LFOChorus::maxCentreDelayMs, juce::jmin (p.chorusCenterDelayMs, 99.9f)));
+    chorus.feedback.setTargetValue (lane, p.chorusFeedback);
+    chorus.mix.setTargetValue (lane, p.chorusMix);
+
+    //overdrive, same drive mapping as the ladder's input
+    const auto overdriveGains = SIMDLadderFilter::getDriveGains (p.overdriveSaturation);
+    group.overdrive.drive.set (lane, overdriveGains.drive);
+    group.overdrive.gain.set (lane, overdriveGains.gain);
+
+    //ladder
+    auto& ladder = group.ladder;
+    const auto modeGains = SIMDLadderFilter::getModeGains (static_cast<SIMDLadderFilter::Mode> (p.ladderMode));
+
+    for (size_t k = 0; k < modeGains.A.size(); ++k)
+        ladder.A[k].set (lane, modeGains.A[k]);
+
+    ladder.comp.set (lane, modeGains.comp);
+    ladder.cutoffTransform.setTargetValue (lane, (float) std::exp (-twoPi * p.ladderCutoffHz / sampleRate));
+    ladder.scaledResonance.setTargetValue (lane, SIMDLadderFilter::getScaledResonance (p.ladderResonance));
+
+    const auto ladderGains = SIMDLadderFilter::getDriveGains (p.ladderDrive);
+    ladder.drive.set (lane, ladderGains.drive);
+    ladder.drive2.set (lane, ladderGains.drive2);
+    ladder.gain.set (lane, ladderGains.gain);
+    ladder.gain2.set (lane, ladderGains.gain2);
+
+    //general filter, coefficients come from the same shared cache as the processor's
+    auto& filter = group.filter;
+    const auto c = filterCoefficientCache->get (static_cast<FilterCoefficientCache::Mode> (p.filterMode),
+                                                sampleRate,
+                                                juce::jmin (p.filterFreqHz, (float) (sampleRate * 0.49)),
+                                                p.filterQuality,
+                                                p.filterGain);
+    const auto a0Inv = c[3] != 0.f ? 1.f / c[3] : 1.f;
+
+    filter.b0.set (lane, c[0] * a0Inv);
+    filter.b1.set (lane, c[1] * a0Inv);
+    filter.b2.set (lane, c[2] * a0Inv);
+    filter.a1.set (lane, c[4] * a0Inv);
+    filter.a2.set (lane, c[5] * a0Inv);
+
+    //delay, clamped like FeedbackDelay
+    auto& delay = group.delay;
+    const auto maxDelaySamples = (float) (FeedbackDelay::maxDelaySeconds * sampleRate);
+    delay.time.setTargetValue (lane, juce::jlimit (1.f, maxDelaySamples, p.delayTimeMs * (float) (sampleRate / 1000.0)));
+    delay.feedback.setTargetValue (lane, p.delayFeedback);
+    delay.mix.setTargetValue (lane, p.delayMix);
+}
+
+void BatchChain::setControlInterval (int numSamples)
+{
+    jassert (numSamples > 0);
+    controlInterval = juce::jmax (1, numSamples);
+
+    //the phaser's depth steps once per control point, so its ramp follows the interval like LFOPhaser's
+    for (auto& group : groups)
+    {
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            group.phaser.lfos[lane].setControlInterval (controlInterval);
+            group.phaser.depths[lane].reset (sampleRate / group.phaser.lfos[lane].getControlInterval(), rampLengthSeconds);
+            group.chorus.lfos[lane].setControlInterval (controlInterval);
+        }
+    }
+}
+
+//==============================================================================
+void BatchChain::process (const juce::dsp::AudioBlock<float>* instanceBlocks, int numBlocks) noexcept
+{
+    jassert (numBlocks == numInstances);
+
+    numBlocks = juce::jmin (numBlocks, numInstances);
+
+    if (numBlocks <= 0)
+        return;
+
+    const auto numSamples = instanceBlocks[0].getNumSamples();
+
+   #if JUCE_DEBUG
+    for (int i = 0; i < numBlocks; ++i)
+    {
+        jassert (instanceBlocks[i].getNumChannels() == (size_t) numChannels);
+        jassert (instanceBlocks[i].getNumSamples() == numSamples);
+    }
+   #endif
+
+    //only the groups that have blocks, the lanes of a group past the last block would read past them
+    const auto numGroups = juce::jmin (groups.size(), ((size_t) numBlocks + lanes - 1) / lanes);
+
+    for (size_t g = 0; g < numGroups; ++g)
+    {
+        auto& group = groups[g];
+        const auto first = g * lanes;
+        const auto* blocks = instanceBlocks + first;
+        const auto groupBlocks = juce::jmin (lanes, (size_t) numBlocks - first);
+
+        for (size_t start = 0; start < numSamples; start += chunkSize)
+        {
+            const auto length = juce::jmin (chunkSize, numSamples - start);
+
+            pack (blocks, groupBlocks, start, length);
+
+            for (auto option : dspOrder)
+            {
+                switch (option)
+                {
+                case DSP_Option::Phase:
+                    processPhaser (group.phaser, length);
+                    break;
+                case DSP_Option::Chorus:
+                    processChorus (group.chorus, length);
+                    break;
+                case DSP_Option::Overdrive:
+                    processOverdrive (group.overdrive, length);
+                    break;
+                case DSP_Option::LadderFilter:
+                    processLadder (group.ladder, length);
+                    break;
+                case DSP_Option::GeneralFilter:
+                    processBiquad (group.filter, length);
+                    break;
+                case DSP_Option::Delay:
+                    processDelay (group.delay, length);
+                    break;
+                case DSP_Option::END_OF_LIST:
+                    jassertfalse;
+                    break;
+                }
+            }
+
+            unpack (blocks, groupBlocks, start, length);
+        }
+    }
+}
+
+void BatchChain::pack (const juce::dsp::AudioBlock<float>* blocks, size_t numBlocks, size_t start, size_t length) noexcept
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* dest = reinterpret_cast<float*> (getFrames (ch));
+
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            //lanes past the last instance just process silence
+            if (lane < numBlocks)
+            {
+                const auto* src = blocks[lane].getChannelPointer ((size_t) ch) + start;
+
+                for (size_t i = 0; i < length; ++i)
+                    dest[i * lanes + lane] = src[i];
+            }
+            else
+            {
+                for (size_t i = 0; i < length; ++i)
+                    dest[i * lanes + lane] = 0.f;
+            }
+        }
+    }
+}
+
+void BatchChain::unpack (const juce::dsp::AudioBlock<float>* blocks, size_t numBlocks, size_t start, size_t length) noexcept
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto* src = reinterpret_cast<const float*> (getFrames (ch));
+
+        for (size_t lane = 0; lane < numBlocks; ++lane)
+        {
+            auto* dest = blocks[lane].getChannelPointer ((size_t) ch) + start;
+
+            for (size_t i = 0; i < length; ++i)
+                dest[i] = src[i * lanes + lane];
+        }
+    }
+}
+
+//==============================================================================
+template <typename MapFn>
+void BatchChain::processLFOs (LaneLFOs& laneLFOs, size_t length, MapFn&& map) noexcept
+{
+    //like LFOPhaser and LFOChorus, per channel only spreads the phases when there's more than one channel
+    for (size_t lane = 0; lane < lanes; ++lane)
+    {
+        auto& lfo = laneLFOs.lfos[lane];
+        const auto perChannel = laneLFOs.modulations[lane] == ControlRateLFO::Modulation::PerChannel && numChannels > 1;
+
+        lfo.setNumPhases (perChannel ? maxLFOPhases : 1);
+        numLFOPhases[lane] = (size_t) lfo.getNumPhases();
+
+        lfo.process (getLFOValues (lane, 0), chunkSize, length, [&map, lane] (const float* sines, float* mapped)
+        {
+            map (lane, sines, mapped);
+        });
+    }
+}
+
+void BatchChain::processPhaser (Phaser& phaser, size_t length) noexcept
+{
+    const auto maxFrequency = (float) juce::jmin (20000.0, 0.49 * sampleRate);
+    const auto piOverSampleRate = juce::MathConstants<float>::pi / (float) sampleRate;
+
+    //lfo -> cutoff -> TPT gain, once per control point like LFOPhaser
+    processLFOs (phaser, length, [&] (size_t lane, const float* sines, float* mapped)
+    {
+        const auto depthValue = phaser.depths[lane].getNextValue();
+        const auto normCentreFrequency = phaser.normCentreFrequency.get (lane);
+
+        for (size_t p = 0; p < numLFOPhases[lane]; ++p)
+        {
+            const auto position = juce::jlimit (0.f, 1.f, sines[p] * depthValue + normCentreFrequency);
+            const auto g = std::tan (piOverSampleRate * juce::mapToLog10 (position, 20.f, maxFrequency));
+            mapped[p] = g / (1.f + g);
+        }
+    });
+
+    const auto perChannel = std::any_of (numLFOPhases.begin(), numLFOPhases.end(), [] (size_t n) { return n > 1; });
+
+    alignas (SIMDHelpers::alignment) float gains[chunkSize * lanes];
+    Vec feedback[chunkSize], mix[chunkSize];
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        feedback[i] = phaser.feedback.getNextValue();
+        mix[i] = phaser.mix.getNextValue();
+    }
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        //every lane reads the phase of this channel, linked they all read the first
+        if (ch == 0 || perChannel)
+        {
+            for (size_t lane = 0; lane < lanes; ++lane)
+            {
+                const auto* values = getLFOValues (lane, ch);
+
+                for (size_t i = 0; i < length; ++i)
+                    gains[i * lanes + lane] = values[i];
+            }
+        }
+
+        auto& state = phaser.channels[(size_t) ch];
+        auto* x = getFrames (ch);
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            const auto g = Vec::fromRawArray (gains + i * lanes);
+            const auto dry = x[i];
+            auto wet = dry - state.lastOutput;
+
+            //first order tpt allpasses
+            for (auto& s : state.s)
+            {
+                const auto v = g * (wet - s);
+                const auto y = v + s;
+                s = y + v;
+                wet = y * 2.f - wet;
+            }
+
+            state.lastOutput = wet * feedback[i];
+            x[i] = dry + (wet - dry) * mix[i];
+        }
+    }
+}
+
+void BatchChain::processChorus (Chorus& chorus, size_t length) noexcept
+{
+    const auto samplesPerMs = (float) (sampleRate / 1000.0);
+
+    //the depth ramps per sample, so only the sines are interpolated like in LFOChorus
+    processLFOs (chorus, length, [this] (size_t lane, const float* sines, float* mapped)
+    {
+        std::copy (sines, sines + numLFOPhases[lane], mapped);
+    });
+
+    for (size_t lane = 0; lane < lanes; ++lane)
+    {
+        auto& depth = chorus.depths[lane];
+        const auto centreDelay = chorus.centreDelayMs.get (lane);
+        const auto numPhases = numLFOPhases[lane];
+        auto* phases = getLFOValues (lane, 0);
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            const auto depthValue = depth.getNextValue();
+
+            for (size_t p = 0; p < numPhases; ++p)
+            {
+                auto& delay = phases[p * chunkSize + i];
+                delay = juce::jmax (1.f, (float) LFOChorus::maximumDelayModulation * delay * depthValue + centreDelay) * samplesPerMs;
+            }
+        }
+    }
+
+    Vec feedback[chunkSize], mix[chunkSize];
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        feedback[i] = chorus.feedback.getNextValue();
+        mix[i] = chorus.mix.getNextValue();
+    }
+
+    const auto delaySize = (size_t) delayMask + 1;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* x = getFrames (ch);
+        auto* line = reinterpret_cast<float*> (chorus.delayLines.data() + (size_t) ch * delaySize);
+        auto& lastOutput = chorus.lastOutputs[(size_t) ch];
+        auto position = chorus.writePosition;
+
+        std::array<const float*, lanes> laneDelays;
+
+        for (size_t lane = 0; lane < lanes; ++lane)
+            laneDelays[lane] = getLFOValues (lane, ch);
+
+        alignas (SIMDHelpers::alignment) float taps[2][lanes];
+        alignas (SIMDHelpers::alignment) float fractions[lanes];
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            const auto dry = x[i];
+            (dry - lastOutput).copyToRawArray (line + (size_t) position * lanes);
+
+            //every lane reads at its own delay, so the taps are gathered one lane at a time. a delay
+            //of 0 reads the sample just written, like LFOChorus
+            for (size_t lane = 0; lane < lanes; ++lane)
+            {
+                const auto delay = laneDelays[lane][i];
+                const auto whole = (int) delay;
+                const auto index = (position - whole) & delayMask;
+
+                taps[0][lane] = line[(size_t) index * lanes + lane];
+                taps[1][lane] = line[(size_t) ((index - 1) & delayMask) * lanes + lane];
+                fractions[lane] = delay - (float) whole;
+            }
+
+            const auto tap1 = Vec::fromRawArray (taps[0]);
+            const auto tap2 = Vec::fromRawArray (taps[1]);
+            const auto wet = tap1 + (tap2 - tap1) * Vec::fromRawArray (fractions);
+
+            lastOutput = wet * feedback[i];
+            x[i] = dry + (wet - dry) * mix[i];
+
+            position = (position + 1) & delayMask;
+        }
+    }
+
+    chorus.writePosition = (chorus.writePosition + (int) length) & delayMask;
+}
+
+void BatchChain::processOverdrive (Overdrive& overdrive, size_t length) noexcept
+{
+    switch (saturationAccuracy)
+    {
+    case SIMDHelpers::TanhAccuracy::Exact:    processOverdriveUsing<SIMDHelpers::TanhAccuracy::Exact> (overdrive, length); break;
+    case SIMDHelpers::TanhAccuracy::Accurate: processOverdriveUsing<SIMDHelpers::TanhAccuracy::Accurate> (overdrive, length); break;
+    case SIMDHelpers::TanhAccuracy::Fast:     processOverdriveUsing<SIMDHelpers::TanhAccuracy::Fast> (overdrive, length); break;
+    }
+}
+
+template <SIMDHelpers::TanhAccuracy accuracy>
+void BatchChain::processOverdriveUsing (Overdrive& overdrive, size_t length) noexcept
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* x = getFrames (ch);
+
+        for (size_t i = 0; i < length; ++i)
+            x[i] = overdrive.gain * SIMDHelpers::tanh<accuracy> (overdrive.drive * x[i]);
+    }
+}
+
+void BatchChain::processLadder (Ladder& ladder, size_t length) noexcept
+{
+    switch (saturationAccuracy)
+    {
+    case SIMDHelpers::TanhAccuracy::Exact:    processLadderUsing<SIMDHelpers::TanhAccuracy::Exact> (ladder, length); break;
+    case SIMDHelpers::TanhAccuracy::Accurate: processLadderUsing<SIMDHelpers::TanhAccuracy::Accurate> (ladder, length); break;
+    case SIMDHelpers::TanhAccuracy::Fast:     processLadderUsing<SIMDHelpers::TanhAccuracy::Fast> (ladder, length); break;
+    }
+}
+
+template <SIMDHelpers::TanhAccuracy accuracy>
+void BatchChain::processLadderUsing (Ladder& ladder, size_t length) noexcept
+{
+    Vec cutoffTransforms[chunkSize], resonances[chunkSize];
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        cutoffTransforms[i] = ladder.cutoffTransform.getNextValue();
+        resonances[i] = ladder.scaledResonance.getNextValue() * -4.f;
+    }
+
+    const auto one = Vec::expand (1.f);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto& state = ladder.channels[(size_t) ch];
+        auto* x = getFrames (ch);
+        auto s0 = state[0], s1 = state[1], s2 = state[2], s3 = state[3], s4 = state[4];
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            const auto a1 = cutoffTransforms[i];
+            const auto g = one - a1;
+            const auto b0 = g * 0.76923076923f;
+            const auto b1 = g * 0.23076923076f;
+
+            const auto dx = ladder.gain * SIMDHelpers::tanh<accuracy> (ladder.drive * x[i]);
+            const auto a = dx + (ladder.gain2 * SIMDHelpers::tanh<accuracy> (ladder.drive2 * s4) - dx * ladder.comp) * resonances[i];
+
+            const auto b = b1 * s0 + a1 * s1 + b0 * a;
+            const auto c = b1 * s1 + a1 * s2 + b0 * b;
+            const auto d = b1 * s2 + a1 * s3 + b0 * c;
+            const auto e = b1 * s3 + a1 * s4 + b0 * d;
+
+            s0 = a;
+            s1 = b;
+            s2 = c;
+            s3 = d;
+            s4 = e;
+
+            x[i] = a * ladder.A[0] + b * ladder.A[1] + c * ladder.A[2] + d * ladder.A[3] + e * ladder.A[4];
+        }
+
+        state = { s0, s1, s2, s3, s4 };
+    }
+}
+
+void BatchChain::processBiquad (Biquad& filter, size_t length) noexcept
+{
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto& state = filter.channels[(size_t) ch];
+        auto* x = getFrames (ch);
+        auto s1 = state.s1, s2 = state.s2;
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            const auto in = x[i];
+            const auto y = filter.b0 * in + s1;
+
+            s1 = filter.b1 * in - filter.a1 * y + s2;
+            s2 = filter.b2 * in - filter.a2 * y;
+
+            x[i] = y;
+        }
+
+        state = { s1, s2 };
+    }
+}
+
+void BatchChain::processDelay (Delay& delay, size_t length) noexcept
+{
+    alignas (SIMDHelpers::alignment) float fractions[chunkSize * lanes];
+    int offsets[chunkSize * lanes];
+    Vec feedback[chunkSize], mix[chunkSize];
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        delay.time.getNextValue().copyToRawArray (fractions + i * lanes);
+
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            auto& d = fractions[i * lanes + lane];
+            const auto whole = (int) d;
+
+            offsets[i * lanes + lane] = whole;
+            d -= (float) whole;
+        }
+
+        feedback[i] = delay.feedback.getNextValue();
+        mix[i] = delay.mix.getNextValue();
+    }
+
+    const auto delaySize = (size_t) feedbackDelayMask + 1;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* x = getFrames (ch);
+        auto* line = reinterpret_cast<float*> (delay.lines.data() + (size_t) ch * delaySize);
+        auto position = delay.writePosition;
+
+        alignas (SIMDHelpers::alignment) float taps[2][lanes];
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            //the delay is at least one sample, so the taps are read before this sample is written
+            for (size_t lane = 0; lane < lanes; ++lane)
+            {
+                const auto index = (position - offsets[i * lanes + lane]) & feedbackDelayMask;
+
+                taps[0][lane] = line[(size_t) index * lanes + lane];
+                taps[1][lane] = line[(size_t) ((index - 1) & feedbackDelayMask) * lanes + lane];
+            }
+
+            const auto tap1 = Vec::fromRawArray (taps[0]);
+            const auto tap2 = Vec::fromRawArray (taps[1]);
+            const auto wet = tap1 + (tap2 - tap1) * Vec::fromRawArray (fractions + i * lanes);
+            const auto dry = x[i];
+
+            (dry + wet * feedback[i]).copyToRawArray (line + (size_t) position * lanes);
+            x[i] = dry + (wet - dry) * mix[i];
+
+            position = (position + 1) & feedbackDelayMask;
+        }
+    }
+
+    delay.writePosition = (delay.writePosition + (int) length) & feedbackDelayMask;
+}
@@ -0,0 +1,294 @@
+/*
+  ==============================================================================
+
+    BatchChain.h
+
+    Many copies of the multieffects chain processed together, one instance
+    per SIMD lane.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../PluginProcessor.h"
+#include "../DSP/SIMDHelpers.h"
+#include "../DSP/FilterCoefficientCache.h"
+#include "../DSP/ControlRateLFO.h"
+#include "../DSP/LFOPhaser.h"
+#include "../DSP/LFOChorus.h"
+#include "../DSP/FeedbackDelay.h"
+
+//==============================================================================
+/**
+    Runs N instances of the MultieffectsAudioProcessor chain side by side.
+
+    Instances are grouped SIMDHelpers::lanes at a time and each group keeps its
+    state as structs of vectors (AoSoA): every filter state, LFO phase and
+    smoother is one register that holds the value for all the instances of the
+    group. A chunk is packed once, runs through every stage in registers and is
+    unpacked again, so a group costs about as much as one scalar instance.
+
+    The stages follow the LFOPhaser, LFOChorus, SIMDOverdrive,
+    SIMDLadderFilter and FeedbackDelay algorithms used by the processor, and
+    every lane runs the phaser and chorus LFOs on the processor's own
+    ControlRateLFO. Every instance has its own Parameters, the DSP_Order, the
+    saturation accuracy and the LFO control interval are shared by all of them.
+
+    Meant for offline render nodes: the setters and process() have to be
+    called from the same thread.
+*/
+class BatchChain
+{
+public:
+    using DSP_Option = MultieffectsAudioProcessor::DSP_Option;
+    using DSP_Order = MultieffectsAudioProcessor::DSP_Order;
+
+    /** Real parameter values of one instance, the defaults match the processor's layout. */
+    struct Parameters
+    {
+        float phaserRateHz = 0.2f;
+        float phaserCenterFreqHz = 1000.f;
+        float phaserDepth = 0.05f;
+        float phaserFeedback = 0.f;
+        float phaserMix = 0.05f;
+        int phaserModulation = 0;
+
+        float chorusRateHz = 0.2f;
+        float chorusDepth = 0.05f;
+        float chorusCenterDelayMs = 7.f;
+        float chorusFeedback = 0.f;
+        float chorusMix = 0.05f;
+        int chorusModulation = 0;
+
+        float overdriveSaturation = 1.f;
+
+        int ladderMode = 0;
+        float ladderCutoffHz = 20000.f;
+        float ladderResonance = 0.f;
+        float ladderDrive = 1.f;
+
+        int filterMode = 0;
+        float filterFreqHz = 750.f;
+        float filterQuality = 1.f;
+        float filterGain = 0.f;
+
+        //already tempo synced, see MultieffectsAudioProcessor::getDelayTimeMs
+        float delayTimeMs = 250.f;
+        float delayFeedback = 0.3f;
+        float delayMix = 0.05f;
+
+        /** Reads the current parameter values of a processor. */
+        static Parameters fromProcessor (const MultieffectsAudioProcessor& processor);
+
+        /** How long an instance rings once its input is silent, from TailModel like
+            MultieffectsAudioProcessor::getTailLengthSeconds. Infinite when it self
+            oscillates.
+        */
+        double getTailSeconds() const;
+    };
+
+    BatchChain();
+    ~BatchChain();
+
+    //==============================================================================
+    /** Allocates the state for numInstances instances with numChannels each.
+        Parameters set before are kept.
+    */
+    void prepare (double sampleRate, int numInstances, int numChannels);
+    void reset();
+
+    void setParameters (int instance, const Parameters& newParameters);
+    const Parameters& getParameters (int instance) const;
+
+    void setDSPOrder (const DSP_Order& newOrder) { dspOrder = newOrder; }
+    const DSP_Order& getDSPOrder() const { return dspOrder; }
+
+    /** The tanh the overdrive and ladder use, a lane can't pick its own. */
+    void setSaturationAccuracy (SIMDHelpers::TanhAccuracy newAccuracy) { saturationAccuracy = newAccuracy; }
+    SIMDHelpers::TanhAccuracy getSaturationAccuracy() const { return saturationAccuracy; }
+
+    /** Samples between two phaser and chorus LFO updates, see MultieffectsAudioProcessor::setModulationInterval. */
+    void setControlInterval (int numSamples);
+    int getControlInterval() const { return controlInterval; }
+
+    /** Processes one block per instance in place. Every block needs the prepared
+        number of channels and all blocks the same number of samples. With fewer blocks
+        than instances, the instances without one get silence when they share a
+        SIMD group with one that has a block, and are left alone otherwise.
+    */
+    void process (const juce::dsp::AudioBlock<float>* instanceBlocks, int numBlocks) noexcept;
+
+    int getNumInstances() const { return numInstances; }
+    int getNumChannels() const { return numChannels; }
+    static constexpr int getNumLanes() { return (int) SIMDHelpers::lanes; }
+
+private:
+    using Vec = SIMDHelpers::Float;
+
+    static constexpr size_t lanes = SIMDHelpers::lanes;
+    static constexpr size_t chunkSize = 64;
+
+    //the parameter smoothing time of the processor's stages
+    static constexpr double rampLengthSeconds = 0.05;
+
+    //==============================================================================
+    /** Linear ramp like juce::SmoothedValue. Every lane has its own target,
+        setting one restarts the ramp for the whole register.
+    */
+    struct LaneSmoother
+    {
+        void reset (double rate, double rampLengthSeconds) noexcept;
+        void setTargetValue (size_t lane, float newTarget) noexcept;
+        void skip() noexcept;
+        Vec getNextValue() noexcept;
+
+        Vec current = Vec::expand (0.f), target = Vec::expand (0.f), step = Vec::expand (0.f);
+        int stepsToTarget = 0, countdown = 0;
+    };
+
+    //every lane has the lfo and depth smoother of an LFOPhaser or LFOChorus, they're scalar
+    //like there and only the audio path runs in registers
+    struct LaneLFOs
+    {
+        std::array<ControlRateLFO, lanes> lfos;
+        std::array<juce::SmoothedValue<float>, lanes> depths;
+        std::array<ControlRateLFO::Modulation, lanes> modulations{};
+    };
+
+    struct Phaser : LaneLFOs
+    {
+        static constexpr int numStages = LFOPhaser::numStages;
+
+        struct Channel
+        {
+            std::array<Vec, numStages> s;
+            Vec lastOutput;
+        };
+
+        Vec normCentreFrequency;
+        LaneSmoother feedback, mix;
+        std::vector<Channel> channels;
+    };
+
+    struct Chorus : LaneLFOs
+    {
+        Vec centreDelayMs;
+        LaneSmoother feedback, mix;
+        std::vector<Vec> lastOutputs;
+
+        //one ring buffer per channel, every slot holds one sample of each lane
+        std::vector<Vec> delayLines;
+        int writePosition = 0;
+    };
+
+    struct Overdrive
+    {
+        Vec drive, gain;
+    };
+
+    struct Ladder
+    {
+        using State = std::array<Vec, 5>;
+
+        LaneSmoother cutoffTransform, scaledResonance;
+        std::array<Vec, 5> A;
+        Vec comp, drive, drive2, gain, gain2;
+        std::vector<State> channels;
+    };
+
+    struct Biquad
+    {
+        struct Channel
+        {
+            Vec s1, s2;
+        };
+
+        Vec b0, b1, b2, a1, a2;
+        std::vector<Channel> channels;
+    };
+
+    struct Delay
+    {
+        //the time is in samples and glides like FeedbackDelay's
+        LaneSmoother time, feedback, mix;
+
+        //one ring buffer per channel, every slot holds one sample of each lane
+        std::vector<Vec> lines;
+        int writePosition = 0;
+    };
+
+    struct Group
+    {
+        Phaser phaser;
+        Chorus chorus;
+        Overdrive overdrive;
+        Ladder ladder;
+        Biquad filter;
+        Delay delay;
+    };
+
+    //==============================================================================
+    void applyParameters (size_t instance, const Parameters&);
+    void pack (const juce::dsp::AudioBlock<float>* blocks, size_t numBlocks, size_t start, size_t length) noexcept;
+    void unpack (const juce::dsp::AudioBlock<float>* blocks, size_t numBlocks, size_t start, size_t length) noexcept;
+
+    void processPhaser (Phaser&, size_t length) noexcept;
+    void processChorus (Chorus&, size_t length) noexcept;
+    void processOverdrive (Overdrive&, size_t length) noexcept;
+    void processLadder (Ladder&, size_t length) noexcept;
+    void processBiquad (Biquad&, size_t length) noexcept;
+    void processDelay (Delay&, size_t length) noexcept;
+
+    template <SIMDHelpers::TanhAccuracy accuracy>
+    void processOverdriveUsing (Overdrive&, size_t length) noexcept;
+
+    template <SIMDHelpers::TanhAccuracy accuracy>
+    void processLadderUsing (Ladder&, size_t length) noexcept;
+
+    Vec* getFrames (int channel) noexcept { return frames.data() + (size_t) channel * chunkSize; }
+
+    //runs the lfo of every lane over a chunk, see getLFOValues
+    template <typename MapFn>
+    void processLFOs (LaneLFOs&, size_t length, MapFn&& map) noexcept;
+
+    //chunkSize values of one phase of a lane's lfo, phases past the lane's last repeat it
+    float* getLFOValues (size_t lane, int channel) noexcept
+    {
+        const auto phase = (size_t) channel % numLFOPhases[lane];
+        return lfoValues.data() + (lane * (size_t) maxLFOPhases + phase) * chunkSize;
+    }
+
+    //==============================================================================
+    double sampleRate = 44100.0;
+    int numInstances = 0, numChannels = 0;
+    int delayMask = 0, feedbackDelayMask = 0;
+
+    DSP_Order dspOrder{
+        DSP_Option::Phase,
+        DSP_Option::Chorus,
+        DSP_Option::Overdrive,
+        DSP_Option::LadderFilter,
+        DSP_Option::GeneralFilter,
+        DSP_Option::Delay,
+    };
+
+    SIMDHelpers::TanhAccuracy saturationAccuracy = SIMDHelpers::TanhAccuracy::Accurate;
+    int controlInterval = ControlRateLFO::defaultControlInterval;
+
+    std::vector<Parameters> parameters;
+    std::vector<Group> groups;
+
+    //the packed chunk of the group being processed, [channel][sample] with one lane per instance
+    std::vector<Vec> frames;
+
+    //what the lfos of the group being processed map to, [lane][phase][sample]
+    std::vector<float> lfoValues;
+    std::array<size_t, lanes> numLFOPhases{};
+    int maxLFOPhases = 1;
+
+    juce::SharedResourcePointer<FilterCoefficientCache> filterCoefficientCache;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BatchChain)
+};
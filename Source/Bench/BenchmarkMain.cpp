@@ -0,0 +1,1018 @@
+/*
+  ==============================================================================
+
+    BenchmarkMain.cpp
+
+    Measures the cost of every DSP_Choice stage, of the whole chain in
+    MultieffectsAudioProcessor::processBlock, of the BatchChain and of the
+    tanh approximations, and writes the results as CSV or JSON so builds can
+    be compared. The mailbox suite also stress tests LatestValueMailbox across
+    two threads and fails the run when a value tears or arrives out of order.
+    The profiled and metered suites repeat the chain suite with the
+    StageProfiler or the StageMeters on, the idle suites run silence once
+    every tail has died out, with and without tail skipping. The sweep suites
+    automate both filters' cutoffs every block, with the coefficients ramping
+    and stepping. The pipeline suite renders through StagePipeline and fails
+    the run when its output isn't bit identical to processBlock's, the batch
+    suite fails it when a lane strays from processBlock by more than rounding.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../PluginProcessor.h"
+#include "../Render/OfflineRenderer.h"
+#include "../Render/StagePipeline.h"
+#include "../Batch/BatchChain.h"
+#include "../Utility/CycleClock.h"
+#include "../Utility/LatestValueMailbox.h"
+#include <thread>
+
+namespace
+{
+    using DSP_Option = MultieffectsAudioProcessor::DSP_Option;
+    using DSP_Order = MultieffectsAudioProcessor::DSP_Order;
+    using DSP_Links = MultieffectsAudioProcessor::DSP_Links;
+
+    struct BenchConfig
+    {
+        juce::Array<int> blockSizes{ 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+        juce::Array<double> sampleRates{ 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+        juce::Array<int> channelCounts{ 1, 2 };
+
+        //the order sweep runs every permutation at one configuration unless --full-orders is given
+        int orderBlockSize = 512;
+        double orderSampleRate = 48000.0;
+        int orderChannels = 2;
+        bool fullOrderSweep = false;
+
+        //0 processes whole blocks, see MultieffectsAudioProcessor::setTileSize
+        int tileSize = 0;
+
+        //see MultieffectsAudioProcessor::setModulationInterval
+        int modulationInterval = ControlRateLFO::defaultControlInterval;
+
+        //the batch suite reports per instance costs, so it compares directly with the chain suite
+        juce::Array<int> batchInstanceCounts{ 1, 8, 32 };
+
+        double secondsPerMeasurement = 1.0;
+        double warmupSeconds = 0.1;
+
+        bool runStages = true;
+        bool runChain = true;
+        bool runOrders = true;
+        bool runBatch = true;
+        bool runTanh = true;
+        bool runParallel = true;
+        bool runMailbox = true;
+        bool runProfiler = true;
+        bool runMeters = true;
+        bool runIdle = true;
+        bool runSweep = true;
+        bool runPipeline = true;
+    };
+
+    struct BenchResult
+    {
+        juce::String suite, name;
+        double sampleRate = 0.0;
+        int blockSize = 0, numChannels = 0;
+        juce::int64 numSamples = 0;
+        double nsPerSample = 0.0, cyclesPerSample = 0.0, realtimeFactor = 0.0;
+
+        //the tanh suite puts the largest difference to std::tanh here, the mailbox suite the
+        //number of torn or out of order values, the pipeline and batch suites the largest
+        //difference to processBlock
+        double maxError = 0.0;
+    };
+
+    //the batch lanes run the processor's kernels, they only round differently where they're vectorised
+    static constexpr double maxBatchError = 1.0e-4;
+
+    //==============================================================================
+    class Benchmark
+    {
+    public:
+        explicit Benchmark (const BenchConfig& c) : config (c)
+        {
+            processor.setTileSize (config.tileSize);
+            processor.setModulationInterval (config.modulationInterval);
+        }
+
+        juce::Array<BenchResult> run()
+        {
+            juce::Array<BenchResult> results;
+
+            if (config.runStages)
+            {
+                for (size_t o = 0; o < static_cast<size_t>(DSP_Option::END_OF_LIST); ++o)
+                {
+                    auto option = static_cast<DSP_Option>(o);
+
+                    forEachConfiguration ([&] (double sr, int bs, int ch)
+                    {
+                        results.add (measure ("stage", OfflineRenderer::getDSPOptionName (option), sr, bs, ch,
+                                              [this, option] (juce::AudioBuffer<float>& buffer)
+                                              {
+                                                  auto block = juce::dsp::AudioBlock<float> (buffer);
+                                                  auto context = juce::dsp::ProcessContextReplacing<float> (block);
+                                                  processor.getStage (option)->process (context);
+                                              }));
+                    });
+                }
+            }
+
+            if (config.runChain)
+            {
+                auto order = getDefaultOrder();
+
+                forEachConfiguration ([&] (double sr, int bs, int ch)
+                {
+                    results.add (measureChain ("chain", order, sr, bs, ch));
+                });
+            }
+
+            if (config.runOrders)
+            {
+                auto order = getDefaultOrder();
+                std::sort (order.begin(), order.end());
+
+                do
+                {
+                    if (config.fullOrderSweep)
+                    {
+                        forEachConfiguration ([&] (double sr, int bs, int ch)
+                        {
+                            results.add (measureChain ("order", order, sr, bs, ch));
+                        });
+                    }
+                    else
+                    {
+                        results.add (measureChain ("order", order, config.orderSampleRate,
+                                                   config.orderBlockSize, config.orderChannels));
+                    }
+                }
+                while (std::next_permutation (order.begin(), order.end()));
+            }
+
+            if (config.runBatch)
+            {
+                for (auto numInstances : config.batchInstanceCounts)
+                {
+                    forEachConfiguration ([&] (double sr, int bs, int ch)
+                    {
+                        results.add (measureBatch (numInstances, sr, bs, ch));
+                    });
+                }
+            }
+
+            if (config.runTanh)
+            {
+                results.add (measureTanh<SIMDHelpers::TanhAccuracy::Exact> ("exact"));
+                results.add (measureTanh<SIMDHelpers::TanhAccuracy::Accurate> ("accurate"));
+                results.add (measureTanh<SIMDHelpers::TanhAccuracy::Fast> ("fast"));
+            }
+
+            if (config.runParallel)
+            {
+                //phaser|chorus, overdrive, ladder|filter|delay, once on the workers and once serial
+                auto links = DSP_Links{};
+                links[1] = links[4] = links[5] = true;
+
+                for (auto parallel : { true, false })
+                {
+                    forEachConfiguration ([&] (double sr, int bs, int ch)
+                    {
+                        results.add (measureChain (parallel ? "parallel" : "parallel-serial", getDefaultOrder(), sr, bs, ch,
+                                                   links, parallel));
+                    });
+                }
+
+                processor.setParallelProcessing (true);
+            }
+
+            if (config.runProfiler)
+            {
+                //the chain suite with the StageProfiler on, the difference to it is the overhead
+                processor.getProfiler().setEnabled (true);
+
+                forEachConfiguration ([&] (double sr, int bs, int ch)
+                {
+                    results.add (measureChain ("profiled", getDefaultOrder(), sr, bs, ch));
+                });
+
+                processor.getProfiler().setEnabled (false);
+            }
+
+            if (config.runMeters)
+            {
+                //the chain suite with the stage meters on, as when the editor is open
+                processor.getMeters().setEnabled (true);
+
+                forEachConfiguration ([&] (double sr, int bs, int ch)
+                {
+                    results.add (measureChain ("metered", getDefaultOrder(), sr, bs, ch));
+                });
+
+                processor.getMeters().setEnabled (false);
+            }
+
+            if (config.runIdle)
+            {
+                //a track that stopped playing, what most tracks of a big session do most of the time
+                for (auto skipTails : { true, false })
+                {
+                    processor.setTailSkipping (skipTails);
+
+                    forEachConfiguration ([&] (double sr, int bs, int ch)
+                    {
+                        results.add (measureIdle (skipTails ? "idle" : "idle-noskip", sr, bs, ch));
+                    });
+                }
+
+                processor.setTailSkipping (true);
+            }
+
+            if (config.runSweep)
+            {
+                //what a sound designer's filter automation costs, per sample ramps against a step per control block
+                for (auto ramping : { true, false })
+                {
+                    processor.setCoefficientRamping (ramping);
+
+                    forEachConfiguration ([&] (double sr, int bs, int ch)
+                    {
+                        results.add (measureSweep (ramping ? "sweep" : "sweep-stepped", sr, bs, ch));
+                    });
+                }
+
+                processor.setCoefficientRamping (false);
+            }
+
+            if (config.runPipeline)
+            {
+                forEachConfiguration ([&] (double sr, int bs, int ch)
+                {
+                    results.add (measurePipeline (sr, bs, ch));
+                });
+            }
+
+            if (config.runMailbox)
+            {
+                results.add (measureMailbox<1> ("1 word"));
+                results.add (measureMailbox<32> ("32 words"));
+            }
+
+            return results;
+        }
+
+    private:
+        static DSP_Order getDefaultOrder()
+        {
+            return { DSP_Option::Phase, DSP_Option::Chorus, DSP_Option::Overdrive,
+                     DSP_Option::LadderFilter, DSP_Option::GeneralFilter, DSP_Option::Delay };
+        }
+
+        template <typename Callback>
+        void forEachConfiguration (Callback&& callback)
+        {
+            for (auto sr : config.sampleRates)
+                for (auto bs : config.blockSizes)
+                    for (auto ch : config.channelCounts)
+                        callback (sr, bs, ch);
+        }
+
+        BenchResult measureChain (const juce::String& suite, const DSP_Order& order, double sr, int bs, int ch,
+                                  const DSP_Links& links = {}, bool parallel = true)
+        {
+            processor.setDSPOrder (order);
+            processor.setDSPLinks (links);
+            processor.setParallelProcessing (parallel);
+
+            return measure (suite, OfflineRenderer::getDSPOrderName (order, links), sr, bs, ch,
+                            [this] (juce::AudioBuffer<float>& buffer)
+                            {
+                                processor.processBlock (buffer, midi);
+                            });
+        }
+
+        //silence only, the warmup runs until the chain's tail is over
+        BenchResult measureIdle (const juce::String& suite, double sr, int bs, int ch)
+        {
+            processor.setDSPOrder (getDefaultOrder());
+            processor.setDSPLinks ({});
+
+            return measure (suite, OfflineRenderer::getDSPOrderName (getDefaultOrder(), {}), sr, bs, ch,
+                            [this] (juce::AudioBuffer<float>& buffer)
+                            {
+                                buffer.clear();
+                                processor.processBlock (buffer, midi);
+                            },
+                            true);
+        }
+
+        //the ladder and general filter cutoffs follow a 0.5 Hz sine, a new value every block
+        BenchResult measureSweep (const juce::String& suite, double sr, int bs, int ch)
+        {
+            processor.setDSPOrder (getDefaultOrder());
+            processor.setDSPLinks ({});
+
+            auto* ladderCutoff = processor.ladderFilterCutoffHz;
+            auto* filterFreq = processor.generalFilterFreqHz;
+            const auto savedLadderCutoff = ladderCutoff->getValue();
+            const auto savedFilterFreq = filterFreq->getValue();
+
+            double phase = 0.0;
+            const auto increment = juce::MathConstants<double>::twoPi * 0.5 * bs / sr;
+
+            auto result = measure (suite, OfflineRenderer::getDSPOrderName (getDefaultOrder(), {}), sr, bs, ch,
+                                   [&] (juce::AudioBuffer<float>& buffer)
+                                   {
+                                       const auto value = (float) (0.5 + 0.4 * std::sin (phase));
+                                       phase += increment;
+
+                                       ladderCutoff->setValueNotifyingHost (value);
+                                       filterFreq->setValueNotifyingHost (value);
+                                       processor.processBlock (buffer, midi);
+                                   });
+
+            ladderCutoff->setValueNotifyingHost (savedLadderCutoff);
+            filterFreq->setValueNotifyingHost (savedFilterFreq);
+            return result;
+        }
+
+        template <typename ProcessFn>
+        BenchResult measure (const juce::String& suite, const juce::String& name,
+                             double sampleRate, int blockSize, int numChannels, ProcessFn&& process,
+                             bool warmupPastTail = false)
+        {
+            processor.setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+            processor.prepareToPlay (sampleRate, blockSize);
+
+            //an infinite tail never ends, then the measurement runs every stage anyway
+            const auto tailSeconds = processor.getTailLengthSeconds();
+            const auto warmupSeconds = config.warmupSeconds
+                                     + (warmupPastTail && std::isfinite (tailSeconds) ? tailSeconds : 0.0);
+
+            prepareSource (numChannels, sampleRate);
+
+            juce::AudioBuffer<float> buffer (numChannels, blockSize);
+
+            //one full block through processBlock pulls the order and pushes the parameters into the stages
+            buffer.clear();
+            processor.processBlock (buffer, midi);
+
+            const auto warmupBlocks = juce::jmax (1, (int) (warmupSeconds * sampleRate) / blockSize);
+            const auto numBlocks = juce::jmax (1, (int) (config.secondsPerMeasurement * sampleRate) / blockSize);
+
+            juce::uint64 totalCycles = 0;
+            juce::int64 totalHiResTicks = 0;
+            int sourcePosition = 0;
+
+            for (int i = 0; i < warmupBlocks + numBlocks; ++i)
+            {
+                fillFromSource (buffer, sourcePosition);
+
+                const auto hiResStart = juce::Time::getHighResolutionTicks();
+                const auto start = CycleClock::now();
+
+                process (buffer);
+
+                const auto end = CycleClock::now();
+                const auto hiResEnd = juce::Time::getHighResolutionTicks();
+
+                if (i >= warmupBlocks)
+                {
+                    totalCycles += end - start;
+                    totalHiResTicks += hiResEnd - hiResStart;
+                }
+            }
+
+            processor.releaseResources();
+
+            BenchResult result;
+            result.suite = suite;
+            result.name = name;
+            result.sampleRate = sampleRate;
+            result.blockSize = blockSize;
+            result.numChannels = numChannels;
+            result.numSamples = (juce::int64) numBlocks * blockSize;
+
+            const auto seconds = juce::Time::highResolutionTicksToSeconds (totalHiResTicks);
+            result.nsPerSample = seconds * 1.0e9 / (double) result.numSamples;
+            result.cyclesPerSample = (double) totalCycles / (double) result.numSamples;
+            result.realtimeFactor = seconds > 0.0 ? ((double) result.numSamples / sampleRate) / seconds : 0.0;
+
+            return result;
+        }
+
+        //the same input through processBlock and through a StagePipeline of the same stages, with
+        //tail skipping off like the offline renderer. every other quarter of the run is silence, so
+        //the chain also goes through its tails. times the pipeline, the serial chain is the chain suite
+        BenchResult measurePipeline (double sampleRate, int blockSize, int numChannels)
+        {
+            processor.setDSPOrder (getDefaultOrder());
+            processor.setDSPLinks ({});
+            processor.setTailSkipping (false);
+            processor.setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+
+            prepareSource (numChannels, sampleRate);
+
+            const auto numBlocks = juce::jmax (1, (int) (config.secondsPerMeasurement * sampleRate) / blockSize);
+            //from the number of blocks, a period in seconds would never be silent in a short run
+            const auto blocksPerQuarter = juce::jmax (1, numBlocks / 4);
+
+            juce::AudioBuffer<float> expected (numChannels, numBlocks * blockSize);
+            int sourcePosition = 0;
+
+            auto fillInput = [&] (juce::AudioBuffer<float>& buffer, int blockIndex)
+            {
+                fillFromSource (buffer, sourcePosition);
+
+                if ((blockIndex / blocksPerQuarter) % 2 == 1)
+                    buffer.clear();
+            };
+
+            processor.prepareToPlay (sampleRate, blockSize);
+
+            {
+                juce::AudioBuffer<float> buffer (numChannels, blockSize);
+
+                for (int i = 0; i < numBlocks; ++i)
+                {
+                    fillInput (buffer, i);
+                    processor.processBlock (buffer, midi);
+
+                    for (int ch = 0; ch < numChannels; ++ch)
+                        expected.copyFrom (ch, i * blockSize, buffer, ch, 0, blockSize);
+                }
+            }
+
+            //from the top again, prepareToPlay resets every stage
+            processor.prepareToPlay (sampleRate, blockSize);
+            sourcePosition = 0;
+
+            std::vector<juce::dsp::ProcessorBase*> stages;
+            const auto prepared = processor.prepareSerialStages (stages);
+            jassert (prepared);
+            juce::ignoreUnused (prepared);
+
+            StagePipeline pipeline (stages, numChannels, blockSize, processor.getEffectiveTileSize (numChannels));
+
+            int numFilled = 0, numDrained = 0;
+            double maxError = 0.0;
+
+            const auto hiResStart = juce::Time::getHighResolutionTicks();
+
+            pipeline.run ([&] (juce::AudioBuffer<float>& buffer)
+                          {
+                              if (numFilled == numBlocks)
+                                  return 0;
+
+                              buffer.setSize (numChannels, blockSize, false, false, true);
+                              fillInput (buffer, numFilled++);
+                              return blockSize;
+                          },
+                          [&] (const juce::AudioBuffer<float>& buffer)
+                          {
+                              for (int ch = 0; ch < numChannels; ++ch)
+                              {
+                                  const auto* output = buffer.getReadPointer (ch);
+                                  const auto* reference = expected.getReadPointer (ch, numDrained * blockSize);
+
+                                  for (int i = 0; i < blockSize; ++i)
+                                      maxError = juce::jmax (maxError, std::abs ((double) output[i] - (double) reference[i]));
+                              }
+
+                              ++numDrained;
+                              return true;
+                          });
+
+            const auto hiResEnd = juce::Time::getHighResolutionTicks();
+
+            processor.releaseResources();
+            processor.setTailSkipping (true);
+
+            BenchResult result;
+            result.suite = "pipeline";
+            result.name = OfflineRenderer::getDSPOrderName (getDefaultOrder(), {});
+            result.sampleRate = sampleRate;
+            result.blockSize = blockSize;
+            result.numChannels = numChannels;
+            result.numSamples = (juce::int64) numBlocks * blockSize;
+            result.maxError = maxError;
+
+            const auto seconds = juce::Time::highResolutionTicksToSeconds (hiResEnd - hiResStart);
+            result.nsPerSample = seconds * 1.0e9 / (double) result.numSamples;
+            result.realtimeFactor = seconds > 0.0 ? ((double) result.numSamples / sampleRate) / seconds : 0.0;
+
+            return result;
+        }
+
+        //samples and timings are summed over all instances, so ns_per_sample is the cost of one instance.
+        //max_error is how far the lanes stray from processBlock on the same input
+        BenchResult measureBatch (int numInstances, double sampleRate, int blockSize, int numChannels)
+        {
+            BatchChain batch;
+            batch.setDSPOrder (getDefaultOrder());
+            batch.setSaturationAccuracy (static_cast<SIMDHelpers::TanhAccuracy> (processor.saturationAccuracy->getIndex()));
+            batch.setControlInterval (config.modulationInterval);
+            batch.prepare (sampleRate, numInstances, numChannels);
+
+            //the same settings the processor runs with in the other suites
+            for (int i = 0; i < numInstances; ++i)
+                batch.setParameters (i, BatchChain::Parameters::fromProcessor (processor));
+
+            batch.reset();
+            prepareSource (numChannels, sampleRate);
+
+            juce::OwnedArray<juce::AudioBuffer<float>> buffers;
+            std::vector<juce::dsp::AudioBlock<float>> blocks;
+
+            for (int i = 0; i < numInstances; ++i)
+                blocks.emplace_back (*buffers.add (new juce::AudioBuffer<float> (numChannels, blockSize)));
+
+            const auto warmupBlocks = juce::jmax (1, (int) (config.warmupSeconds * sampleRate) / blockSize);
+            const auto numBlocks = juce::jmax (1, (int) (config.secondsPerMeasurement * sampleRate) / blockSize);
+
+            juce::uint64 totalCycles = 0;
+            juce::int64 totalHiResTicks = 0;
+            int sourcePosition = 0;
+
+            for (int i = 0; i < warmupBlocks + numBlocks; ++i)
+            {
+                //every instance reads its own stretch of the source
+                for (int n = 0; n < numInstances; ++n)
+                    fillFromSource (*buffers[n], sourcePosition);
+
+                const auto hiResStart = juce::Time::getHighResolutionTicks();
+                const auto start = CycleClock::now();
+
+                batch.process (blocks.data(), numInstances);
+
+                const auto end = CycleClock::now();
+                const auto hiResEnd = juce::Time::getHighResolutionTicks();
+
+                if (i >= warmupBlocks)
+                {
+                    totalCycles += end - start;
+                    totalHiResTicks += hiResEnd - hiResStart;
+                }
+            }
+
+            BenchResult result;
+            result.suite = "batch";
+            result.name = "instances=" + juce::String (numInstances);
+            result.sampleRate = sampleRate;
+            result.blockSize = blockSize;
+            result.numChannels = numChannels;
+            result.numSamples = (juce::int64) numBlocks * blockSize * numInstances;
+            result.maxError = getBatchError (batch, buffers, blocks, sampleRate, numBlocks);
+
+            const auto seconds = juce::Time::highResolutionTicksToSeconds (totalHiResTicks);
+            result.nsPerSample = seconds * 1.0e9 / (double) result.numSamples;
+            result.cyclesPerSample = (double) totalCycles / (double) result.numSamples;
+            result.realtimeFactor = seconds > 0.0 ? ((double) result.numSamples / sampleRate) / seconds : 0.0;
+
+            return result;
+        }
+
+        //every lane and processBlock from the top on the same input, with tail skipping off like
+        //the offline renderer
+        double getBatchError (BatchChain& batch, juce::OwnedArray<juce::AudioBuffer<float>>& buffers,
+                              std::vector<juce::dsp::AudioBlock<float>>& blocks, double sampleRate, int numBlocks)
+        {
+            const auto numChannels = buffers[0]->getNumChannels();
+            const auto blockSize = buffers[0]->getNumSamples();
+
+            processor.setDSPOrder (getDefaultOrder());
+            processor.setDSPLinks ({});
+            processor.setTailSkipping (false);
+            processor.setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+            processor.prepareToPlay (sampleRate, blockSize);
+            batch.reset();
+
+            juce::AudioBuffer<float> expected (numChannels, blockSize);
+            int sourcePosition = 0;
+            double maxError = 0.0;
+
+            for (int i = 0; i < numBlocks; ++i)
+            {
+                fillFromSource (expected, sourcePosition);
+
+                for (auto* buffer : buffers)
+                    for (int ch = 0; ch < numChannels; ++ch)
+                        buffer->copyFrom (ch, 0, expected, ch, 0, blockSize);
+
+                processor.processBlock (expected, midi);
+                batch.process (blocks.data(), buffers.size());
+
+                for (auto* buffer : buffers)
+                {
+                    for (int ch = 0; ch < numChannels; ++ch)
+                    {
+                        const auto* output = buffer->getReadPointer (ch);
+                        const auto* reference = expected.getReadPointer (ch);
+
+                        for (int n = 0; n < blockSize; ++n)
+                            maxError = juce::jmax (maxError, std::abs ((double) output[n] - (double) reference[n]));
+                    }
+                }
+            }
+
+            processor.releaseResources();
+            processor.setTailSkipping (true);
+
+            return maxError;
+        }
+
+        //one SIMDHelpers::tanh variant on its own, over a ramp from -8 to 8 that covers the
+        //clamped ends as well, so the error is the worst case the drive stages can see
+        template <SIMDHelpers::TanhAccuracy accuracy>
+        BenchResult measureTanh (const juce::String& name)
+        {
+            using Vec = SIMDHelpers::Float;
+
+            static constexpr size_t numValues = 4096;
+            static constexpr float range = 8.f;
+
+            std::vector<Vec> input (numValues / SIMDHelpers::lanes), output (input.size());
+
+            for (size_t i = 0; i < numValues; ++i)
+                input[i / SIMDHelpers::lanes].set (i % SIMDHelpers::lanes,
+                                                   -range + 2.f * range * (float) i / (float) (numValues - 1));
+
+            double maxError = 0.0;
+
+            for (size_t v = 0; v < input.size(); ++v)
+            {
+                const auto y = SIMDHelpers::tanh<accuracy> (input[v]);
+
+                for (size_t lane = 0; lane < SIMDHelpers::lanes; ++lane)
+                    maxError = juce::jmax (maxError, std::abs ((double) y.get (lane) - std::tanh ((double) input[v].get (lane))));
+            }
+
+            //about the same number of values per measurement as the audio suites process
+            const auto numPasses = juce::jmax (1, (int) (config.secondsPerMeasurement * 48000.0) / (int) numValues);
+            const auto warmupPasses = juce::jmax (1, (int) (config.warmupSeconds * 48000.0) / (int) numValues);
+
+            juce::uint64 totalCycles = 0;
+            juce::int64 totalHiResTicks = 0;
+
+            for (int pass = 0; pass < warmupPasses + numPasses; ++pass)
+            {
+                const auto hiResStart = juce::Time::getHighResolutionTicks();
+                const auto start = CycleClock::now();
+
+                for (size_t v = 0; v < input.size(); ++v)
+                    output[v] = SIMDHelpers::tanh<accuracy> (input[v]);
+
+                const auto end = CycleClock::now();
+                const auto hiResEnd = juce::Time::getHighResolutionTicks();
+
+                if (pass >= warmupPasses)
+                {
+                    totalCycles += end - start;
+                    totalHiResTicks += hiResEnd - hiResStart;
+                }
+
+                //the results are read back so the loop can't be dropped
+                input[(size_t) pass % input.size()] += output[0] * 0.f;
+            }
+
+            BenchResult result;
+            result.suite = "tanh";
+            result.name = name;
+            result.blockSize = (int) numValues;
+            result.numChannels = 1;
+            result.numSamples = (juce::int64) numPasses * (juce::int64) numValues;
+            result.maxError = maxError;
+
+            const auto seconds = juce::Time::highResolutionTicksToSeconds (totalHiResTicks);
+            result.nsPerSample = seconds * 1.0e9 / (double) result.numSamples;
+            result.cyclesPerSample = (double) totalCycles / (double) result.numSamples;
+
+            return result;
+        }
+
+        //a writer thread pushes as fast as it can while this thread pulls, every word of a
+        //value holds its sequence number so a torn value or one that goes back in time shows up
+        template <size_t numWords>
+        BenchResult measureMailbox (const juce::String& name)
+        {
+            using Value = std::array<juce::uint64, numWords>;
+
+            const auto numPushes = (juce::uint64) juce::jmax (1000.0, config.secondsPerMeasurement * 2.0e6);
+
+            LatestValueMailbox<Value> mailbox;
+            std::atomic<bool> start { false };
+
+            std::thread writer ([&]
+            {
+                while (! start.load())
+                    std::this_thread::yield();
+
+                Value value;
+
+                for (juce::uint64 sequence = 1; sequence <= numPushes; ++sequence)
+                {
+                    value.fill (sequence);
+                    mailbox.push (value);
+                }
+            });
+
+            juce::int64 numPulls = 0, numErrors = 0;
+            juce::uint64 lastSeen = 0;
+            Value value;
+
+            const auto hiResStart = juce::Time::getHighResolutionTicks();
+            const auto cycleStart = CycleClock::now();
+
+            start.store (true);
+
+            while (lastSeen < numPushes)
+            {
+                ++numPulls;
+
+                if (! mailbox.pull (value))
+                    continue;
+
+                const auto sequence = mailbox.getLastSequence();
+
+                if (sequence <= lastSeen || std::any_of (value.begin(), value.end(), [&] (auto word) { return word != sequence; }))
+                    ++numErrors;
+
+                lastSeen = sequence;
+            }
+
+            const auto cycleEnd = CycleClock::now();
+            const auto hiResEnd = juce::Time::getHighResolutionTicks();
+
+            writer.join();
+
+            BenchResult result;
+            result.suite = "mailbox";
+            result.name = name;
+            result.blockSize = (int) (numWords * sizeof (juce::uint64));
+            result.numChannels = 1;
+            result.numSamples = numPulls;
+            result.maxError = (double) numErrors;
+
+            const auto seconds = juce::Time::highResolutionTicksToSeconds (hiResEnd - hiResStart);
+            result.nsPerSample = seconds * 1.0e9 / (double) numPulls;
+            result.cyclesPerSample = (double) (cycleEnd - cycleStart) / (double) numPulls;
+
+            return result;
+        }
+
+        //a few seconds of noise at -12dBFS that the measured blocks are copied from, so the
+        //stages never settle into processing their own silence or denormals
+        void prepareSource (int numChannels, double sampleRate)
+        {
+            source.setSize (numChannels, (int) sampleRate, false, false, true);
+
+            juce::Random random (0x5eed);
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto* data = source.getWritePointer (ch);
+
+                for (int i = 0; i < source.getNumSamples(); ++i)
+                    data[i] = (random.nextFloat() * 2.f - 1.f) * 0.25f;
+            }
+        }
+
+        void fillFromSource (juce::AudioBuffer<float>& buffer, int& position)
+        {
+            if (position + buffer.getNumSamples() > source.getNumSamples())
+                position = 0;
+
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                buffer.copyFrom (ch, 0, source, ch, position, buffer.getNumSamples());
+
+            position += buffer.getNumSamples();
+        }
+
+        BenchConfig config;
+        MultieffectsAudioProcessor processor;
+        juce::AudioBuffer<float> source;
+        juce::MidiBuffer midi;
+    };
+
+    //==============================================================================
+    juce::String toCSV (const juce::Array<BenchResult>& results)
+    {
+        juce::String csv ("suite,name,sample_rate,block_size,channels,samples,ns_per_sample,cycles_per_sample,realtime_factor,max_error\n");
+
+        for (auto& r : results)
+        {
+            csv << r.suite << ",\"" << r.name << "\","
+                << r.sampleRate << "," << r.blockSize << "," << r.numChannels << "," << r.numSamples << ","
+                << juce::String (r.nsPerSample, 4) << "," << juce::String (r.cyclesPerSample, 4) << ","
+                << juce::String (r.realtimeFactor, 2) << "," << juce::String (r.maxError, 8) << "\n";
+        }
+
+        return csv;
+    }
+
+    juce::String toJSON (const juce::Array<BenchResult>& results)
+    {
+        auto meta = std::make_unique<juce::DynamicObject>();
+        meta->setProperty ("juce_version", juce::SystemStats::getJUCEVersion());
+        meta->setProperty ("cpu", juce::SystemStats::getCpuModel());
+        meta->setProperty ("os", juce::SystemStats::getOperatingSystemName());
+        meta->setProperty ("build_date", juce::String (__DATE__) + " " + __TIME__);
+        meta->setProperty ("time", juce::Time::getCurrentTime().toISO8601 (true));
+        meta->setProperty ("cycle_counter_hz", CycleClock::getTicksPerSecond());
+
+        juce::Array<juce::var> rows;
+
+        for (auto& r : results)
+        {
+            auto row = std::make_unique<juce::DynamicObject>();
+            row->setProperty ("suite", r.suite);
+            row->setProperty ("name", r.name);
+            row->setProperty ("sample_rate", r.sampleRate);
+            row->setProperty ("block_size", r.blockSize);
+            row->setProperty ("channels", r.numChannels);
+            row->setProperty ("samples", r.numSamples);
+            row->setProperty ("ns_per_sample", r.nsPerSample);
+            row->setProperty ("cycles_per_sample", r.cyclesPerSample);
+            row->setProperty ("realtime_factor", r.realtimeFactor);
+            row->setProperty ("max_error", r.maxError);
+            rows.add (juce::var (row.release()));
+        }
+
+        auto root = std::make_unique<juce::DynamicObject>();
+        root->setProperty ("meta", juce::var (meta.release()));
+        root->setProperty ("results", rows);
+
+        return juce::JSON::toString (juce::var (root.release()));
+    }
+
+    template <typename Type>
+    juce::Array<Type> parseList (const juce::String& text)
+    {
+        juce::Array<Type> values;
+
+        for (auto& token : juce::StringArray::fromTokens (text, ",", ""))
+            if (token.trim().isNotEmpty())
+                values.add ((Type) token.trim().getDoubleValue());
+
+        return values;
+    }
+
+    void printUsage()
+    {
+        std::cout
+            << "usage: multieffects-bench [options]\n"
+               "\n"
+               "  --format <csv|json>        output format (default csv)\n"
+               "  --output <file>            write results to a file instead of stdout\n"
+               "  --suites <stage,chain,order,batch,tanh,parallel,mailbox,profiled,metered,idle,sweep,pipeline> which suites to run (default all)\n"
+               "  --block-sizes <a,b,...>    default 16,32,64,128,256,512,1024,2048,4096\n"
+               "  --sample-rates <a,b,...>   default 44100,48000,88200,96000,176400,192000\n"
+               "  --channels <a,b>           default 1,2, up to 16 (7.1.4 is 12)\n"
+               "  --seconds <s>              audio seconds per measurement (default 1)\n"
+               "  --full-orders              run all orders at every configuration\n"
+               "  --tile-size <samples|auto> tile size for the chain suites (default 0, off)\n"
+               "  --lfo-interval <samples>   samples between phaser and chorus lfo updates (default 32)\n"
+               "  --batch-instances <a,b,...> instance counts for the batch suite (default 1,8,32)\n"
+               "  --quick                    48k, 64/512/4096 samples, stereo, 0.25 s per measurement\n"
+            << std::endl;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    if (args.containsOption ("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    BenchConfig config;
+
+    if (args.removeOptionIfFound ("--quick"))
+    {
+        config.blockSizes = { 64, 512, 4096 };
+        config.sampleRates = { 48000.0 };
+        config.channelCounts = { 2 };
+        config.secondsPerMeasurement = 0.25;
+    }
+
+    if (args.containsOption ("--block-sizes"))
+        config.blockSizes = parseList<int> (args.removeValueForOption ("--block-sizes"));
+
+    if (args.containsOption ("--sample-rates"))
+        config.sampleRates = parseList<double> (args.removeValueForOption ("--sample-rates"));
+
+    if (args.containsOption ("--channels"))
+        config.channelCounts = parseList<int> (args.removeValueForOption ("--channels"));
+
+    if (args.containsOption ("--seconds"))
+        config.secondsPerMeasurement = juce::jmax (0.01, args.removeValueForOption ("--seconds").getDoubleValue());
+
+    config.fullOrderSweep = args.removeOptionIfFound ("--full-orders");
+
+    if (args.containsOption ("--tile-size"))
+    {
+        auto tile = args.removeValueForOption ("--tile-size");
+        config.tileSize = tile == "auto" ? MultieffectsAudioProcessor::autoTileSize : tile.getIntValue();
+    }
+
+    if (args.containsOption ("--lfo-interval"))
+        config.modulationInterval = juce::jmax (1, args.removeValueForOption ("--lfo-interval").getIntValue());
+
+    if (args.containsOption ("--batch-instances"))
+        config.batchInstanceCounts = parseList<int> (args.removeValueForOption ("--batch-instances"));
+
+    if (args.containsOption ("--suites"))
+    {
+        auto suites = juce::StringArray::fromTokens (args.removeValueForOption ("--suites"), ",", "");
+        config.runStages = suites.contains ("stage");
+        config.runChain = suites.contains ("chain");
+        config.runOrders = suites.contains ("order");
+        config.runBatch = suites.contains ("batch");
+        config.runTanh = suites.contains ("tanh");
+        config.runParallel = suites.contains ("parallel");
+        config.runMailbox = suites.contains ("mailbox");
+        config.runProfiler = suites.contains ("profiled");
+        config.runMeters = suites.contains ("metered");
+        config.runIdle = suites.contains ("idle");
+        config.runSweep = suites.contains ("sweep");
+        config.runPipeline = suites.contains ("pipeline");
+    }
+
+    auto format = args.containsOption ("--format") ? args.removeValueForOption ("--format") : juce::String ("csv");
+    auto outputPath = args.containsOption ("--output") ? args.removeValueForOption ("--output") : juce::String();
+
+    if (args.size() > 0)
+    {
+        std::cerr << "error: unknown argument " << args[0].text << std::endl;
+        printUsage();
+        return 1;
+    }
+
+    if (format != "csv" && format != "json")
+    {
+        std::cerr << "error: unknown format " << format << std::endl;
+        return 1;
+    }
+
+    for (auto ch : config.channelCounts)
+    {
+        if (ch < 1 || ch > MultieffectsAudioProcessor::maxChannels)
+        {
+            std::cerr << "error: the processor supports 1 to " << MultieffectsAudioProcessor::maxChannels << " channels" << std::endl;
+            return 1;
+        }
+    }
+
+    Benchmark benchmark (config);
+    auto results = benchmark.run();
+    auto text = format == "json" ? toJSON (results) : toCSV (results);
+
+    if (outputPath.isNotEmpty())
+    {
+        auto file = juce::File::getCurrentWorkingDirectory().getChildFile (outputPath);
+
+        if (! file.replaceWithText (text))
+        {
+            std::cerr << "error: could not write " << file.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << text << std::endl;
+    }
+
+    for (auto& r : results)
+    {
+        if (r.suite == "mailbox" && r.maxError > 0.0)
+        {
+            std::cerr << "error: mailbox " << r.name << " returned " << r.maxError << " torn or out of order values" << std::endl;
+            return 1;
+        }
+
+        if (r.suite == "pipeline" && r.maxError > 0.0)
+        {
+            std::cerr << "error: the pipeline differs from processBlock by up to " << r.maxError
+                      << " at " << r.sampleRate << " Hz, " << r.blockSize << " samples" << std::endl;
+            return 1;
+        }
+
+        if (r.suite == "batch" && r.maxError > maxBatchError)
+        {
+            std::cerr << "error: the batch differs from processBlock by up to " << r.maxError
+                      << " at " << r.sampleRate << " Hz, " << r.blockSize << " samples" << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,214 @@
+/*
+  ==============================================================================
+
+    ControlRateLFO.h
+
+    Sine LFO evaluated at a control rate, with whatever the modulation drives
+    interpolated between the control points.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    The LFO shared by the phaser and chorus stages.
+
+    The sine comes from a recursive oscillator, a complex phasor rotated once per
+    control point, so there's no std::sin or std::function call on the audio
+    path. At every control point process() passes the LFO value through a map
+    function, typically straight to a filter coefficient or a delay time, and
+    writes that mapped value linearly interpolated to every sample.
+
+    The control interval is shortened for fast rates so a cycle always has at
+    least minPointsPerCycle points, slow LFOs run at the configured interval.
+
+    For per channel modulation it has several phases, spread evenly over a
+    cycle and all taken from the one phasor, so they can't drift apart.
+*/
+class ControlRateLFO
+{
+public:
+    static constexpr int defaultControlInterval = 32;
+    static constexpr int minPointsPerCycle = 64;
+    static constexpr int maxPhases = 16;
+
+    /** How a stage modulates its channels: all of them with the same LFO, or each
+        one with its own phase of it.
+    */
+    enum class Modulation
+    {
+        Linked,
+        PerChannel,
+    };
+
+    void prepare (double newSampleRate) noexcept
+    {
+        jassert (newSampleRate > 0.0);
+
+        sampleRate = newSampleRate;
+        updateIncrement();
+        reset();
+    }
+
+    /** Back to the start of a cycle, the next process() starts a new control point. */
+    void reset() noexcept
+    {
+        //-pi, like juce::dsp::Oscillator with a sine
+        re = -1.f;
+        im = 0.f;
+
+        samplesUntilUpdate = 0;
+        primed = false;
+    }
+
+    /** Only recomputes the phasor increment, so it's cheap enough to call per block. */
+    void setFrequency (float newFrequencyHz) noexcept
+    {
+        jassert (newFrequencyHz > 0.f);
+
+        frequency = newFrequencyHz;
+        updateIncrement();
+    }
+
+    /** Phase p runs p / numPhases of a cycle ahead of phase 0, 1 is a single LFO. A
+        change starts a new control point right away, the values in between aren't ramped.
+    */
+    void setNumPhases (int newNumPhases) noexcept
+    {
+        jassert (newNumPhases > 0 && newNumPhases <= maxPhases);
+
+        const auto n = juce::jlimit (1, maxPhases, newNumPhases);
+
+        if (n == numPhases)
+            return;
+
+        numPhases = n;
+
+        for (int p = 0; p < numPhases; ++p)
+        {
+            const auto offset = juce::MathConstants<double>::twoPi * p / numPhases;
+            phaseCos[(size_t) p] = (float) std::cos (offset);
+            phaseSin[(size_t) p] = (float) std::sin (offset);
+        }
+
+        samplesUntilUpdate = 0;
+        primed = false;
+    }
+
+    int getNumPhases() const noexcept { return numPhases; }
+
+    void setControlInterval (int numSamples) noexcept
+    {
+        jassert (numSamples > 0);
+
+        maxInterval = juce::jmax (1, numSamples);
+        updateIncrement();
+    }
+
+    /** The interval that is actually used at the current frequency. */
+    int getControlInterval() const noexcept { return interval; }
+
+    /** Writes numSamples interpolated values of map (lfo) to dest, phase p to
+        dest + p * stride. map (sines, mapped) gets the sines of all phases in
+        [-1, 1], writes what they map to and is only called once per control point.
+    */
+    template <typename MapFn>
+    void process (float* dest, size_t stride, size_t numSamples, MapFn&& map) noexcept
+    {
+        jassert (numPhases == 1 || stride >= numSamples);
+
+        for (size_t i = 0; i < numSamples;)
+        {
+            if (samplesUntilUpdate == 0)
+                startSegment (map);
+
+            const auto n = juce::jmin (numSamples - i, (size_t) samplesUntilUpdate);
+
+            for (size_t p = 0; p < (size_t) numPhases; ++p)
+            {
+                auto* d = dest + p * stride + i;
+                auto value = values[p];
+
+                for (size_t k = 0; k < n; ++k)
+                {
+                    d[k] = value;
+                    value += steps[p];
+                }
+
+                values[p] = value;
+            }
+
+            i += n;
+            samplesUntilUpdate -= (int) n;
+        }
+    }
+
+private:
+    using PhaseArray = std::array<float, (size_t) maxPhases>;
+
+    //sin (theta + offset) of every phase
+    void getSines (PhaseArray& sines) const noexcept
+    {
+        for (size_t p = 0; p < (size_t) numPhases; ++p)
+            sines[p] = im * phaseCos[p] + re * phaseSin[p];
+    }
+
+    template <typename MapFn>
+    void startSegment (MapFn& map) noexcept
+    {
+        PhaseArray sines, mapped;
+
+        if (! primed)
+        {
+            getSines (sines);
+            map (sines.data(), values.data());
+            primed = true;
+        }
+
+        rotate();
+
+        getSines (sines);
+        map (sines.data(), mapped.data());
+
+        for (size_t p = 0; p < (size_t) numPhases; ++p)
+            steps[p] = (mapped[p] - values[p]) / (float) interval;
+
+        samplesUntilUpdate = interval;
+    }
+
+    void rotate() noexcept
+    {
+        const auto r = re * cosIncrement - im * sinIncrement;
+        const auto i = re * sinIncrement + im * cosIncrement;
+
+        //first order renormalisation, keeps the float rounding from growing or shrinking the phasor
+        const auto g = 1.5f - 0.5f * (r * r + i * i);
+
+        re = r * g;
+        im = i * g;
+    }
+
+    void updateIncrement() noexcept
+    {
+        interval = juce::jlimit (1, maxInterval, (int) (sampleRate / (frequency * minPointsPerCycle)));
+
+        const auto angle = juce::MathConstants<double>::twoPi * frequency * interval / sampleRate;
+        cosIncrement = (float) std::cos (angle);
+        sinIncrement = (float) std::sin (angle);
+    }
+
+    double sampleRate = 44100.0;
+    float frequency = 1.f;
+    int maxInterval = defaultControlInterval, interval = defaultControlInterval;
+
+    float re = -1.f, im = 0.f, cosIncrement = 1.f, sinIncrement = 0.f;
+    int samplesUntilUpdate = 0;
+
+    int numPhases = 1;
+    PhaseArray phaseCos { 1.f }, phaseSin {}, values {}, steps {};
+    bool primed = false;
+};
@@ -0,0 +1,244 @@
+/*
+  ==============================================================================
+
+    FeedbackDelay.h
+
+    Feedback delay with gliding delay times, up to several seconds long.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDHelpers.h"
+
+//==============================================================================
+/**
+    A delay line per channel in one power of two ring buffer, sized once in
+    prepare(). Positions wrap with a mask, so there are no branches on the
+    read or write side.
+
+    juce::dsp::DelayLine pushes and pops one sample at a time and recomputes
+    the interpolation for every call. Here a block is cut into runs that are
+    never longer than the shortest delay in them, so every read of a run comes
+    from samples written before it. The taps of a run are gathered first, the
+    fractional interpolation runs on whole registers, and only then is the run
+    written back with the feedback. The delay times are computed once per
+    sample for all channels.
+
+    Changing the time glides the read position over glideSeconds, like tape,
+    instead of jumping.
+*/
+class FeedbackDelay
+{
+public:
+    static constexpr double maxDelaySeconds = 4.0;
+    static constexpr double glideSeconds = 0.2;
+
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        jassert (spec.sampleRate > 0.0);
+
+        sampleRate = spec.sampleRate;
+        numChannels = (size_t) spec.numChannels;
+
+        maxDelaySamples = (float) (maxDelaySeconds * sampleRate);
+        bufferSize = (size_t) juce::nextPowerOfTwo ((int) std::ceil (maxDelaySamples) + 2);
+        mask = (int) bufferSize - 1;
+
+        buffer.assign (numChannels * bufferSize, 0.f);
+
+        setDelayTime (delayMs);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        startClearing();
+        clearSome (buffer.size());
+    }
+
+    /** reset() a piece at a time, for an idle delay whose ring is too big to clear
+        in one block. After startClearing every clearSome clears up to numSamples
+        more of it and returns true once the delay is silent. Don't process it in
+        between, reset() finishes it in one go.
+    */
+    void startClearing() noexcept { clearPosition = 0; }
+    bool isClearing() const noexcept { return clearPosition < buffer.size(); }
+
+    bool clearSome (size_t numSamples) noexcept
+    {
+        const auto end = clearPosition + juce::jmin (numSamples, buffer.size() - clearPosition);
+
+        std::fill (buffer.begin() + (std::ptrdiff_t) clearPosition, buffer.begin() + (std::ptrdiff_t) end, 0.f);
+        clearPosition = end;
+
+        if (isClearing())
+            return false;
+
+        writePosition = 0;
+
+        delay.current = delay.target;
+        delay.countdown = 0;
+
+        feedbackVolume.reset (sampleRate, smoothingSeconds);
+        mixVolume.reset (sampleRate, smoothingSeconds);
+        return true;
+    }
+
+    /** Clamped to [1 sample, maxDelaySeconds]. */
+    void setDelayTime (float newDelayMs) noexcept
+    {
+        jassert (newDelayMs >= 0.f);
+        delayMs = newDelayMs;
+
+        const auto target = juce::jlimit (1.f, maxDelaySamples, delayMs * (float) (sampleRate / 1000.0));
+
+        if (target == delay.target)
+            return;
+
+        delay.target = target;
+        delay.countdown = juce::jmax (1, (int) (glideSeconds * sampleRate));
+        delay.step = (delay.target - delay.current) / (float) delay.countdown;
+    }
+
+    void setFeedback (float newFeedback) noexcept
+    {
+        jassert (newFeedback >= 0.f && newFeedback < 1.f);
+        feedbackVolume.setTargetValue (newFeedback);
+    }
+
+    void setMix (float newMix) noexcept
+    {
+        jassert (juce::isPositiveAndNotGreaterThan (newMix, 1.f));
+        mixVolume.setTargetValue (newMix);
+    }
+
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+        const auto numSamples = outputBlock.getNumSamples();
+
+        jassert (inputBlock.getNumChannels() == outputBlock.getNumChannels());
+        jassert (inputBlock.getNumSamples() == numSamples);
+        jassert (outputBlock.getNumChannels() <= numChannels);
+
+        if (context.isBypassed)
+        {
+            if (context.usesSeparateInputAndOutputBlocks())
+                outputBlock.copyFrom (inputBlock);
+
+            return;
+        }
+
+        static constexpr auto lanes = SIMDHelpers::lanes;
+        using Vec = SIMDHelpers::Float;
+
+        alignas (SIMDHelpers::alignment) float fractions[chunkSize];
+        alignas (SIMDHelpers::alignment) float taps1[chunkSize], taps2[chunkSize];
+        int offsets[chunkSize];
+        float feedback[chunkSize], mix[chunkSize];
+
+        for (size_t start = 0; start < numSamples;)
+        {
+            //a run can't be longer than its shortest delay, the ramp is linear so that's at one end
+            auto length = (int) juce::jmin (chunkSize, numSamples - start);
+            const auto shortest = juce::jmin (getDelayAt (0), getDelayAt (length - 1));
+            length = juce::jlimit (1, length, (int) shortest);
+
+            const auto padded = ((size_t) length + lanes - 1) / lanes * lanes;
+
+            for (int i = 0; i < length; ++i)
+            {
+                const auto d = getDelayAt (i);
+                offsets[i] = (int) d;
+                fractions[i] = d - (float) offsets[i];
+
+                feedback[i] = feedbackVolume.getNextValue();
+                mix[i] = mixVolume.getNextValue();
+            }
+
+            std::fill (fractions + length, fractions + padded, 0.f);
+            advanceDelay (length);
+
+            for (size_t ch = 0; ch < outputBlock.getNumChannels(); ++ch)
+            {
+                const auto* src = inputBlock.getChannelPointer (ch) + start;
+                auto* dest = outputBlock.getChannelPointer (ch) + start;
+                auto* line = buffer.data() + ch * bufferSize;
+
+                for (int i = 0; i < length; ++i)
+                {
+                    const auto index = (writePosition + i - offsets[i]) & mask;
+                    taps1[i] = line[index];
+                    taps2[i] = line[(index - 1) & mask];
+                }
+
+                std::fill (taps1 + length, taps1 + padded, 0.f);
+                std::fill (taps2 + length, taps2 + padded, 0.f);
+
+                for (size_t i = 0; i < padded; i += lanes)
+                {
+                    const auto tap1 = Vec::fromRawArray (taps1 + i);
+                    const auto tap2 = Vec::fromRawArray (taps2 + i);
+                    (tap1 + (tap2 - tap1) * Vec::fromRawArray (fractions + i)).copyToRawArray (taps1 + i);
+                }
+
+                for (int i = 0; i < length; ++i)
+                {
+                    const auto dry = src[i];
+                    const auto wet = taps1[i];
+
+                    line[(writePosition + i) & mask] = dry + wet * feedback[i];
+                    dest[i] = dry + (wet - dry) * mix[i];
+                }
+            }
+
+            writePosition = (writePosition + length) & mask;
+            start += (size_t) length;
+        }
+    }
+
+private:
+    //delay in samples, i samples into the current run
+    float getDelayAt (int i) const noexcept
+    {
+        return i < delay.countdown ? delay.current + delay.step * (float) (i + 1) : delay.target;
+    }
+
+    void advanceDelay (int numSamples) noexcept
+    {
+        if (delay.countdown > numSamples)
+        {
+            delay.current += delay.step * (float) numSamples;
+            delay.countdown -= numSamples;
+        }
+        else
+        {
+            delay.current = delay.target;
+            delay.countdown = 0;
+        }
+    }
+
+    struct Ramp
+    {
+        float current = 1.f, target = 1.f, step = 0.f;
+        int countdown = 0;
+    };
+
+    static constexpr size_t chunkSize = 64;
+    static constexpr double smoothingSeconds = 0.05;
+
+    std::vector<float> buffer;
+    size_t bufferSize = 0, numChannels = 0, clearPosition = 0;
+    int mask = 0, writePosition = 0;
+
+    Ramp delay;
+    juce::SmoothedValue<float> feedbackVolume, mixVolume;
+
+    double sampleRate = 44100.0;
+    float maxDelaySamples = 1.f, delayMs = 250.f;
+};
@@ -0,0 +1,131 @@
+/*
+  ==============================================================================
+
+    FilterCoefficientCache.cpp
+
+  ==============================================================================
+*/
+
+#include "FilterCoefficientCache.h"
+
+namespace
+{
+    //splitmix64 finaliser, spreads neighbouring frequencies across the table
+    juce::uint64 hashKey (juce::uint64 x) noexcept
+    {
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebull;
+        x ^= x >> 31;
+        return x;
+    }
+}
+
+FilterCoefficientCache::FilterCoefficientCache()
+    : slots (std::make_unique<Slot[]> ((size_t) capacity))
+{
+}
+
+//==============================================================================
+FilterCoefficientCache::QuantizedSettings FilterCoefficientCache::quantize (Mode mode, double sampleRate, float freqHz,
+                                                                            float quality, float gainDb) noexcept
+{
+    QuantizedSettings q;
+    q.mode = mode;
+    q.sampleRate = (juce::uint32) juce::jlimit (1, (1 << 20) - 1, juce::roundToInt (sampleRate));
+    q.freq = (juce::uint32) juce::jlimit (1, (int) (q.sampleRate / 2) - 1, juce::roundToInt (freqHz));
+    q.qualityIndex = (juce::uint32) juce::jlimit (1, 4095, juce::roundToInt (quality / qualityStep));
+
+    //only the peak filter uses the gain, leaving it out gives the other modes more hits
+    q.gainIndex = mode == Mode::Peak ? (juce::uint32) juce::jlimit (0, 4095, juce::roundToInt ((gainDb - minGainDb) / gainStep))
+                                     : 0;
+    return q;
+}
+
+juce::uint64 FilterCoefficientCache::makeKey (const QuantizedSettings& q) noexcept
+{
+    //sampleRate:20 | freq:16 | q:12 | gain:12 | mode + 1:3, never 0 and never touches the busy bit
+    return ((juce::uint64) q.sampleRate << 43)
+         | ((juce::uint64) (q.freq & 0xffff) << 27)
+         | ((juce::uint64) q.qualityIndex << 15)
+         | ((juce::uint64) q.gainIndex << 3)
+         | (juce::uint64) ((int) q.mode + 1);
+}
+
+FilterCoefficientCache::Coefficients FilterCoefficientCache::calculate (const QuantizedSettings& q) noexcept
+{
+    using ArrayCoefficients = juce::dsp::IIR::ArrayCoefficients<float>;
+
+    const auto sampleRate = (double) q.sampleRate;
+    const auto freq = (float) q.freq;
+    const auto quality = (float) q.qualityIndex * qualityStep;
+
+    switch (q.mode)
+    {
+    case Mode::Peak:
+        return ArrayCoefficients::makePeakFilter (sampleRate, freq, quality,
+                                                  juce::Decibels::decibelsToGain ((float) q.gainIndex * gainStep + minGainDb));
+    case Mode::BandPass:
+        return ArrayCoefficients::makeBandPass (sampleRate, freq, quality);
+    case Mode::Notch:
+        return ArrayCoefficients::makeNotch (sampleRate, freq, quality);
+    case Mode::AllPass:
+        return ArrayCoefficients::makeAllPass (sampleRate, freq, quality);
+    }
+
+    jassertfalse;
+    return { 1.f, 0.f, 0.f, 1.f, 0.f, 0.f };
+}
+
+FilterCoefficientCache::Coefficients FilterCoefficientCache::calculate (Mode mode, double sampleRate, float freqHz,
+                                                                        float quality, float gainDb) noexcept
+{
+    return calculate (quantize (mode, sampleRate, freqHz, quality, gainDb));
+}
+
+//==============================================================================
+FilterCoefficientCache::Coefficients FilterCoefficientCache::get (Mode mode, double sampleRate, float freqHz,
+                                                                  float quality, float gainDb) noexcept
+{
+    const auto settings = quantize (mode, sampleRate, freqHz, quality, gainDb);
+    const auto key = makeKey (settings);
+    auto index = (int) (hashKey (key) & (juce::uint64) (capacity - 1));
+
+    for (int probe = 0; probe < maxProbes; ++probe, index = (index + 1) & (capacity - 1))
+    {
+        auto& slot = slots[(size_t) index];
+        auto slotKey = slot.key.load (std::memory_order_acquire);
+
+        //entries are immutable once published, so a matching key means the values are complete
+        if (slotKey == key)
+            return slot.coefficients;
+
+        //another thread is writing this exact entry, don't wait for it
+        if (slotKey == (key | busyFlag))
+            break;
+
+        if (slotKey == 0)
+        {
+            if (! slot.key.compare_exchange_strong (slotKey, key | busyFlag, std::memory_order_acq_rel))
+            {
+                if (slotKey == key)
+                    return slot.coefficients;
+
+                if (slotKey == (key | busyFlag))
+                    break;
+
+                //lost the slot to a different key, keep probing
+                continue;
+            }
+
+            slot.coefficients = calculate (settings);
+            slot.key.store (key, std::memory_order_release);
+            numEntries.fetch_add (1, std::memory_order_relaxed);
+
+            return slot.coefficients;
+        }
+    }
+
+    return calculate (settings);
+}
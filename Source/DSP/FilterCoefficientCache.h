@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    FilterCoefficientCache.h
+
+    Process wide cache of general filter biquad coefficients.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Caches biquad coefficients for the general filter.
+
+    The filter parameters are quantized (1 Hz, 0.05 Q, 0.05 dB) and the mode has
+    four choices, so automation keeps coming back to the same coefficient sets.
+    Entries are keyed by (mode, freq, Q, gain, sampleRate) and live in a fixed
+    size open addressing table that is allocated once, when the first instance
+    creates the cache through a SharedResourcePointer.
+
+    Lookups and inserts are wait-free and never allocate, so they can run on any
+    number of audio threads. Entries are written once and never evicted: a full
+    table (or a slot that is being written by another thread) just falls back
+    to calculating the coefficients directly.
+*/
+class FilterCoefficientCache
+{
+public:
+    enum class Mode
+    {
+        Peak,
+        BandPass,
+        Notch,
+        AllPass,
+    };
+
+    //b0, b1, b2, a0, a1, a2 in the layout of juce::dsp::IIR::ArrayCoefficients
+    using Coefficients = std::array<float, 6>;
+
+    FilterCoefficientCache();
+
+    /** Returns the coefficients for the given settings, quantized to the parameter steps. */
+    Coefficients get (Mode mode, double sampleRate, float freqHz, float quality, float gainDb) noexcept;
+
+    /** Calculates the coefficients without touching the cache. */
+    static Coefficients calculate (Mode mode, double sampleRate, float freqHz, float quality, float gainDb) noexcept;
+
+    int getNumEntries() const noexcept { return numEntries.load (std::memory_order_relaxed); }
+    static constexpr int getCapacity() noexcept { return capacity; }
+
+private:
+    static constexpr int capacity = 1 << 16;
+    static constexpr int maxProbes = 16;
+
+    static constexpr float qualityStep = 0.05f;
+    static constexpr float gainStep = 0.05f;
+    static constexpr float minGainDb = -24.f;
+
+    static constexpr juce::uint64 busyFlag = juce::uint64 (1) << 63;
+
+    struct alignas (32) Slot
+    {
+        std::atomic<juce::uint64> key { 0 };
+        Coefficients coefficients {};
+    };
+
+    struct QuantizedSettings
+    {
+        Mode mode;
+        juce::uint32 sampleRate, freq, qualityIndex, gainIndex;
+    };
+
+    static QuantizedSettings quantize (Mode, double sampleRate, float freqHz, float quality, float gainDb) noexcept;
+    static juce::uint64 makeKey (const QuantizedSettings&) noexcept;
+    static Coefficients calculate (const QuantizedSettings&) noexcept;
+
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<int> numEntries { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (FilterCoefficientCache)
+};
@@ -0,0 +1,287 @@
+/*
+  ==============================================================================
+
+    LFOChorus.h
+
+    juce::dsp::Chorus with its modulation moved to a ControlRateLFO.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ControlRateLFO.h"
+#include "SIMDHelpers.h"
+
+//==============================================================================
+/**
+    Same modulated delay, feedback, parameter ranges and smoothing as
+    juce::dsp::Chorus, with the same setters.
+
+    The juce chorus renders its LFO through juce::dsp::Oscillator, a
+    std::function and a sin() per sample. Here the LFO is evaluated at the
+    control rate and interpolated, and the delay times are computed once per
+    sample for all channels.
+
+    The delay line is a power of two ring buffer of frames, one register of
+    channels per SIMD lane group, read with linear interpolation. Linked, the
+    channels share the delay time and a read is one load per register, per
+    channel every channel gets its own phase of the LFO and the lanes are
+    read one by one.
+*/
+class LFOChorus
+{
+public:
+    static constexpr double maxCentreDelayMs = 100.0, maximumDelayModulation = 20.0;
+    using Vec = SIMDHelpers::Float;
+    using Modulation = ControlRateLFO::Modulation;
+
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        jassert (spec.sampleRate > 0.0);
+        jassert (spec.numChannels > 0);
+
+        sampleRate = spec.sampleRate;
+
+        const auto maxDelaySamples = (int) std::ceil ((maximumDelayModulation + maxCentreDelayMs) * sampleRate / 1000.0);
+        const auto delaySize = juce::nextPowerOfTwo (maxDelaySamples + 2);
+        delayMask = delaySize - 1;
+
+        const auto numGroups = juce::jmax ((size_t) 1, (spec.numChannels + SIMDHelpers::lanes - 1) / SIMDHelpers::lanes);
+        delayLines.assign (numGroups * (size_t) delaySize, Vec::expand (0.f));
+        lastOutput.assign (numGroups, Vec::expand (0.f));
+
+        lfo.prepare (sampleRate);
+        dryWet.prepare (spec);
+
+        update();
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        startClearing();
+        clearSome (delayLines.size() * SIMDHelpers::lanes);
+    }
+
+    /** reset() a piece at a time, like FeedbackDelay's: every clearSome clears up
+        to numSamples more floats of the delay lines and returns true once the
+        chorus is silent. Don't process it in between.
+    */
+    void startClearing() noexcept { clearPosition = 0; }
+    bool isClearing() const noexcept { return clearPosition < delayLines.size(); }
+
+    bool clearSome (size_t numSamples) noexcept
+    {
+        const auto end = clearPosition + juce::jmin (numSamples / SIMDHelpers::lanes, delayLines.size() - clearPosition);
+
+        std::fill (delayLines.begin() + (std::ptrdiff_t) clearPosition, delayLines.begin() + (std::ptrdiff_t) end, Vec::expand (0.f));
+        clearPosition = end;
+
+        if (isClearing())
+            return false;
+
+        std::fill (lastOutput.begin(), lastOutput.end(), Vec::expand (0.f));
+        writePosition = 0;
+
+        lfo.reset();
+        dryWet.reset();
+        depthVolume.reset (sampleRate, smoothingSeconds);
+        feedbackVolume.reset (sampleRate, smoothingSeconds);
+        return true;
+    }
+
+    void setRate (float newRateHz) noexcept
+    {
+        jassert (juce::isPositiveAndBelow (newRateHz, 100.f));
+        rate = newRateHz;
+        lfo.setFrequency (rate);
+    }
+
+    void setDepth (float newDepth) noexcept
+    {
+        jassert (juce::isPositiveAndNotGreaterThan (newDepth, 1.f));
+        depth = newDepth;
+        depthVolume.setTargetValue (depth * 0.5f);
+    }
+
+    void setCentreDelay (float newDelayMs) noexcept
+    {
+        jassert (juce::isPositiveAndBelow (newDelayMs, (float) maxCentreDelayMs));
+        centreDelay = juce::jlimit (1.f, (float) maxCentreDelayMs, newDelayMs);
+    }
+
+    void setFeedback (float newFeedback) noexcept
+    {
+        jassert (newFeedback >= -1.f && newFeedback <= 1.f);
+        feedback = newFeedback;
+
+        feedbackVolume.setTargetValue (feedback);
+    }
+
+    void setMix (float newMix) noexcept
+    {
+        jassert (juce::isPositiveAndNotGreaterThan (newMix, 1.f));
+        mix = newMix;
+        dryWet.setWetMixProportion (mix);
+    }
+
+    /** Per channel spreads the LFO phases evenly over the channels, see ControlRateLFO. */
+    void setModulation (Modulation newModulation) noexcept { modulation = newModulation; }
+
+    /** Samples between two LFO updates, see ControlRateLFO. */
+    void setControlInterval (int numSamples) noexcept { lfo.setControlInterval (numSamples); }
+
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+        const auto numChannels = outputBlock.getNumChannels();
+        const auto numSamples = outputBlock.getNumSamples();
+
+        jassert (inputBlock.getNumChannels() == numChannels);
+        jassert (inputBlock.getNumSamples() == numSamples);
+        jassert (numChannels <= lastOutput.size() * SIMDHelpers::lanes);
+
+        if (context.isBypassed)
+        {
+            if (context.usesSeparateInputAndOutputBlocks())
+                outputBlock.copyFrom (inputBlock);
+
+            return;
+        }
+
+        dryWet.pushDrySamples (inputBlock);
+
+        const auto perChannel = modulation == Modulation::PerChannel && numChannels > 1;
+        lfo.setNumPhases (perChannel ? juce::jmin ((int) numChannels, ControlRateLFO::maxPhases) : 1);
+        const auto numPhases = (size_t) lfo.getNumPhases();
+
+        const auto samplesPerMs = (float) (sampleRate / 1000.0);
+
+        alignas (SIMDHelpers::alignment) float frames[chunkSize * SIMDHelpers::lanes];
+        float delays[ControlRateLFO::maxPhases * chunkSize], feedbacks[chunkSize];
+
+        for (size_t start = 0; start < numSamples; start += chunkSize)
+        {
+            const auto length = juce::jmin (chunkSize, numSamples - start);
+
+            //the depth ramps per sample, so only the sines themselves are interpolated
+            lfo.process (delays, chunkSize, length, [numPhases] (const float* lfoValues, float* mapped)
+            {
+                std::copy (lfoValues, lfoValues + numPhases, mapped);
+            });
+
+            for (size_t i = 0; i < length; ++i)
+            {
+                const auto depthValue = depthVolume.getNextValue();
+
+                for (size_t p = 0; p < numPhases; ++p)
+                {
+                    auto& delay = delays[p * chunkSize + i];
+                    delay = juce::jmax (1.f, (float) maximumDelayModulation * delay * depthValue + centreDelay) * samplesPerMs;
+                }
+
+                feedbacks[i] = feedbackVolume.getNextValue();
+            }
+
+            for (size_t group = 0, first = 0; first < numChannels; ++group, first += SIMDHelpers::lanes)
+            {
+                const auto groupChannels = juce::jmin (SIMDHelpers::lanes, numChannels - first);
+
+                SIMDHelpers::pack (inputBlock, first, groupChannels, start, length, frames);
+
+                if (perChannel)
+                    processFrames<true> (group, first, frames, delays, feedbacks, numPhases, length);
+                else
+                    processFrames<false> (group, first, frames, delays, feedbacks, numPhases, length);
+
+                SIMDHelpers::unpack (frames, outputBlock, first, groupChannels, start, length);
+            }
+
+            writePosition = (writePosition + (int) length) & delayMask;
+        }
+
+        dryWet.mixWetSamples (outputBlock);
+    }
+
+private:
+    //delays holds chunkSize delay times per LFO phase, only the first one is read when linked
+    template <bool perChannel>
+    void processFrames (size_t group, size_t firstChannel, float* frames, const float* delays,
+                        const float* feedbacks, size_t numPhases, size_t length) noexcept
+    {
+        auto* line = delayLines.data() + group * ((size_t) delayMask + 1);
+        auto last = lastOutput[group];
+        auto position = writePosition;
+
+        std::array<const float*, SIMDHelpers::lanes> laneDelays;
+
+        for (size_t lane = 0; lane < SIMDHelpers::lanes; ++lane)
+            laneDelays[lane] = delays + ((firstChannel + lane) % numPhases) * chunkSize;
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            auto* frame = frames + i * SIMDHelpers::lanes;
+            line[position] = Vec::fromRawArray (frame) - last;
+
+            //a delay of 0 reads the sample just written, like juce::dsp::DelayLine
+            Vec value1, value2, delayFrac;
+
+            if constexpr (perChannel)
+            {
+                for (size_t lane = 0; lane < SIMDHelpers::lanes; ++lane)
+                {
+                    const auto delay = laneDelays[lane][i];
+                    const auto delayInt = (int) delay;
+
+                    value1.set (lane, line[(position - delayInt) & delayMask].get (lane));
+                    value2.set (lane, line[(position - delayInt - 1) & delayMask].get (lane));
+                    delayFrac.set (lane, delay - (float) delayInt);
+                }
+            }
+            else
+            {
+                const auto delayInt = (int) delays[i];
+                value1 = line[(position - delayInt) & delayMask];
+                value2 = line[(position - delayInt - 1) & delayMask];
+                delayFrac = Vec::expand (delays[i] - (float) delayInt);
+            }
+
+            const auto output = value1 + (value2 - value1) * delayFrac;
+
+            output.copyToRawArray (frame);
+            last = output * feedbacks[i];
+
+            position = (position + 1) & delayMask;
+        }
+
+        lastOutput[group] = last;
+    }
+
+    void update() noexcept
+    {
+        setRate (rate);
+        setDepth (depth);
+        setCentreDelay (centreDelay);
+        setFeedback (feedback);
+        setMix (mix);
+    }
+
+    static constexpr size_t chunkSize = 64;
+    static constexpr double smoothingSeconds = 0.05;
+
+    ControlRateLFO lfo;
+    juce::dsp::DryWetMixer<float> dryWet;
+
+    std::vector<Vec> delayLines, lastOutput;
+    size_t clearPosition = 0;
+    juce::SmoothedValue<float> depthVolume, feedbackVolume;
+    Modulation modulation = Modulation::Linked;
+    int delayMask = 0, writePosition = 0;
+
+    double sampleRate = 44100.0;
+    float rate = 1.f, depth = 0.25f, feedback = 0.f, mix = 0.5f, centreDelay = 7.f;
+};
@@ -0,0 +1,264 @@
+/*
+  ==============================================================================
+
+    LFOPhaser.h
+
+    juce::dsp::Phaser with its modulation moved to a ControlRateLFO.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ControlRateLFO.h"
+#include "SIMDHelpers.h"
+
+//==============================================================================
+/**
+    Same six first order TPT allpasses, parameter mapping and smoothing as
+    juce::dsp::Phaser, with the same setters.
+
+    The juce phaser runs a juce::dsp::Oscillator and recomputes every allpass
+    cutoff, a tan() each, on its own 4 sample counter. Here the LFO only goes
+    through the log mapping and the tan() once per control point, and the
+    allpass coefficient itself is interpolated in between, so it moves
+    smoothly instead of in steps.
+
+    The channels are packed into SIMD lanes like SIMDLadderFilter. Linked, they
+    all share the coefficient, per channel every channel gets its own phase of
+    the LFO.
+*/
+class LFOPhaser
+{
+public:
+    static constexpr int numStages = 6;
+    using Vec = SIMDHelpers::Float;
+    using Modulation = ControlRateLFO::Modulation;
+
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        jassert (spec.sampleRate > 0.0);
+        jassert (spec.numChannels > 0);
+
+        sampleRate = spec.sampleRate;
+
+        lfo.prepare (sampleRate);
+        dryWet.prepare (spec);
+
+        const auto numGroups = (spec.numChannels + SIMDHelpers::lanes - 1) / SIMDHelpers::lanes;
+        state.resize (juce::jmax ((size_t) 1, (size_t) numGroups));
+
+        update();
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        for (auto& s : state)
+        {
+            s.stages.fill (Vec::expand (0.f));
+            s.lastOutput = Vec::expand (0.f);
+        }
+
+        lfo.reset();
+        dryWet.reset();
+
+        depthVolume.reset (sampleRate / lfo.getControlInterval(), smoothingSeconds);
+        feedbackVolume.reset (sampleRate, smoothingSeconds);
+    }
+
+    void setRate (float newRateHz) noexcept
+    {
+        jassert (juce::isPositiveAndBelow (newRateHz, 100.f));
+        rate = newRateHz;
+        lfo.setFrequency (rate);
+    }
+
+    void setDepth (float newDepth) noexcept
+    {
+        jassert (juce::isPositiveAndNotGreaterThan (newDepth, 1.f));
+        depth = newDepth;
+        depthVolume.setTargetValue (depth * 0.5f);
+    }
+
+    void setCentreFrequency (float newCentreHz) noexcept
+    {
+        jassert (juce::isPositiveAndBelow (newCentreHz, (float) (sampleRate * 0.5)));
+        centreFrequency = newCentreHz;
+        normCentreFrequency = juce::mapFromLog10 (centreFrequency, 20.f, getMaxFrequency());
+    }
+
+    void setFeedback (float newFeedback) noexcept
+    {
+        jassert (newFeedback >= -1.f && newFeedback <= 1.f);
+        feedback = newFeedback;
+
+        feedbackVolume.setTargetValue (feedback);
+    }
+
+    void setMix (float newMix) noexcept
+    {
+        jassert (juce::isPositiveAndNotGreaterThan (newMix, 1.f));
+        mix = newMix;
+        dryWet.setWetMixProportion (mix);
+    }
+
+    /** Per channel spreads the LFO phases evenly over the channels, see ControlRateLFO. */
+    void setModulation (Modulation newModulation) noexcept { modulation = newModulation; }
+
+    /** Samples between two LFO updates, see ControlRateLFO. */
+    void setControlInterval (int numSamples) noexcept
+    {
+        lfo.setControlInterval (numSamples);
+        depthVolume.reset (sampleRate / lfo.getControlInterval(), smoothingSeconds);
+    }
+
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+        const auto numChannels = outputBlock.getNumChannels();
+        const auto numSamples = outputBlock.getNumSamples();
+
+        jassert (inputBlock.getNumChannels() == numChannels);
+        jassert (inputBlock.getNumSamples() == numSamples);
+        jassert (numChannels <= state.size() * SIMDHelpers::lanes);
+
+        if (context.isBypassed)
+        {
+            if (context.usesSeparateInputAndOutputBlocks())
+                outputBlock.copyFrom (inputBlock);
+
+            return;
+        }
+
+        dryWet.pushDrySamples (inputBlock);
+
+        const auto perChannel = modulation == Modulation::PerChannel && numChannels > 1;
+        lfo.setNumPhases (perChannel ? juce::jmin ((int) numChannels, ControlRateLFO::maxPhases) : 1);
+        const auto numPhases = (size_t) lfo.getNumPhases();
+
+        const auto maxFrequency = getMaxFrequency();
+        const auto piOverSampleRate = juce::MathConstants<float>::pi / (float) sampleRate;
+
+        //lfo -> cutoff -> TPT gain, once per control point
+        auto toCoefficients = [&] (const float* lfoValues, float* mapped)
+        {
+            const auto depthValue = depthVolume.getNextValue();
+
+            for (size_t p = 0; p < numPhases; ++p)
+            {
+                const auto position = juce::jlimit (0.f, 1.f, lfoValues[p] * depthValue + normCentreFrequency);
+                const auto g = std::tan (piOverSampleRate * juce::mapToLog10 (position, 20.f, maxFrequency));
+                mapped[p] = g / (1.f + g);
+            }
+        };
+
+        alignas (SIMDHelpers::alignment) float frames[chunkSize * SIMDHelpers::lanes];
+        alignas (SIMDHelpers::alignment) float laneCoefficients[chunkSize * SIMDHelpers::lanes];
+        float coefficients[ControlRateLFO::maxPhases * chunkSize], feedbacks[chunkSize];
+
+        for (size_t start = 0; start < numSamples; start += chunkSize)
+        {
+            const auto length = juce::jmin (chunkSize, numSamples - start);
+
+            lfo.process (coefficients, chunkSize, length, toCoefficients);
+
+            for (size_t i = 0; i < length; ++i)
+                feedbacks[i] = feedbackVolume.getNextValue();
+
+            for (size_t group = 0, first = 0; first < numChannels; ++group, first += SIMDHelpers::lanes)
+            {
+                const auto groupChannels = juce::jmin (SIMDHelpers::lanes, numChannels - first);
+
+                SIMDHelpers::pack (inputBlock, first, groupChannels, start, length, frames);
+
+                if (perChannel)
+                {
+                    //every lane reads the phase of its channel, interleaved like the frames
+                    for (size_t lane = 0; lane < SIMDHelpers::lanes; ++lane)
+                    {
+                        const auto* phase = coefficients + ((first + lane) % numPhases) * chunkSize;
+
+                        for (size_t i = 0; i < length; ++i)
+                            laneCoefficients[i * SIMDHelpers::lanes + lane] = phase[i];
+                    }
+
+                    processFrames<true> (state[group], frames, laneCoefficients, feedbacks, length);
+                }
+                else
+                {
+                    processFrames<false> (state[group], frames, coefficients, feedbacks, length);
+                }
+
+                SIMDHelpers::unpack (frames, outputBlock, first, groupChannels, start, length);
+            }
+        }
+
+        dryWet.mixWetSamples (outputBlock);
+    }
+
+private:
+    struct State
+    {
+        std::array<Vec, numStages> stages;
+        Vec lastOutput;
+    };
+
+    //coefficients holds a frame per sample when perChannel, one shared value per sample otherwise
+    template <bool perChannel>
+    void processFrames (State& s, float* frames, const float* coefficients, const float* feedbacks, size_t length) noexcept
+    {
+        auto stages = s.stages;
+        auto last = s.lastOutput;
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            auto* frame = frames + i * SIMDHelpers::lanes;
+            const auto G = perChannel ? Vec::fromRawArray (coefficients + i * SIMDHelpers::lanes)
+                                      : Vec::expand (coefficients[i]);
+
+            auto output = Vec::fromRawArray (frame) - last;
+
+            for (auto& sn : stages)
+            {
+                const auto v = G * (output - sn);
+                const auto y = v + sn;
+                sn = y + v;
+                output = y * 2.f - output;
+            }
+
+            output.copyToRawArray (frame);
+            last = output * feedbacks[i];
+        }
+
+        s = { stages, last };
+    }
+
+    void update() noexcept
+    {
+        setRate (rate);
+        setDepth (depth);
+        setCentreFrequency (centreFrequency);
+        setFeedback (feedback);
+        setMix (mix);
+    }
+
+    float getMaxFrequency() const noexcept { return (float) juce::jmin (20000.0, 0.49 * sampleRate); }
+
+    static constexpr size_t chunkSize = 64;
+    static constexpr double smoothingSeconds = 0.05;
+
+    ControlRateLFO lfo;
+    juce::dsp::DryWetMixer<float> dryWet;
+
+    std::vector<State> state;
+    juce::SmoothedValue<float> depthVolume, feedbackVolume;
+    Modulation modulation = Modulation::Linked;
+
+    double sampleRate = 44100.0;
+    float rate = 1.f, depth = 0.5f, feedback = 0.f, mix = 0.5f;
+    float centreFrequency = 1300.f, normCentreFrequency = 0.5f;
+};
@@ -0,0 +1,141 @@
+/*
+  ==============================================================================
+
+    Oversampled.h
+
+    Runs a single processor at 2x, 4x or 8x the host rate.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/** Shared by every Oversampled<> so stages wrapping different processors can be
+    switched together.
+*/
+enum class OversamplingFilter
+{
+    //polyphase half-band equiripple FIRs, linear phase with a fixed latency
+    LinearPhase,
+
+    //polyphase half-band IIR allpasses, minimum phase so nothing is reported to the host
+    ZeroLatency,
+};
+
+//==============================================================================
+/**
+    Wraps a processor in juce::dsp::Oversampling so only that stage runs at the
+    higher rate, the rest of the chain stays at the host rate.
+
+    Every factor and filter type is allocated in prepare(), so switching them
+    from the audio thread only picks another preallocated oversampler. The
+    wrapped processor needs an allocation free setSampleRate(), it gets the
+    oversampled rate whenever the factor changes.
+*/
+template <typename DSP>
+class Oversampled
+{
+public:
+    using Filter = OversamplingFilter;
+
+    static constexpr int maxFactorIndex = 3;
+
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        baseSampleRate = spec.sampleRate;
+
+        for (int filter = 0; filter < numFilters; ++filter)
+        {
+            for (int index = 1; index <= maxFactorIndex; ++index)
+            {
+                const auto type = filter == static_cast<int> (Filter::LinearPhase)
+                                    ? juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple
+                                    : juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR;
+
+                //integer latency only matters when the latency is reported
+                const auto useIntegerLatency = filter == static_cast<int> (Filter::LinearPhase);
+
+                auto& oversampler = oversamplers[(size_t) filter][(size_t) index - 1];
+                oversampler = std::make_unique<juce::dsp::Oversampling<float>> (spec.numChannels, (size_t) index, type,
+                                                                                true, useIntegerLatency);
+                oversampler->initProcessing (spec.maximumBlockSize);
+            }
+        }
+
+        processor.prepare (spec);
+        setOversampling (factorIndex, filterType);
+    }
+
+    void reset() noexcept
+    {
+        processor.reset();
+
+        if (current != nullptr)
+            current->reset();
+    }
+
+    /** 0 is off, 1..3 are 2x, 4x and 8x. Doesn't allocate. */
+    void setOversampling (int newFactorIndex, Filter newFilter) noexcept
+    {
+        jassert (newFactorIndex >= 0 && newFactorIndex <= maxFactorIndex);
+
+        factorIndex = juce::jlimit (0, maxFactorIndex, newFactorIndex);
+        filterType = newFilter;
+
+        current = factorIndex > 0 ? oversamplers[static_cast<size_t> (filterType)][(size_t) factorIndex - 1].get()
+                                  : nullptr;
+
+        if (current != nullptr)
+            current->reset();
+
+        processor.setSampleRate (baseSampleRate * getFactor());
+    }
+
+    int getFactor() const noexcept { return 1 << factorIndex; }
+
+    /** Latency in host rate samples, always 0 for the zero latency filters. */
+    float getLatencyInSamples() const noexcept
+    {
+        if (current == nullptr || filterType == Filter::ZeroLatency)
+            return 0.f;
+
+        return current->getLatencyInSamples();
+    }
+
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        if (current == nullptr)
+        {
+            processor.process (context);
+            return;
+        }
+
+        auto& outputBlock = context.getOutputBlock();
+        auto oversampledBlock = current->processSamplesUp (context.getInputBlock());
+
+        auto oversampledContext = juce::dsp::ProcessContextReplacing<float> (oversampledBlock);
+        oversampledContext.isBypassed = context.isBypassed;
+        processor.process (oversampledContext);
+
+        current->processSamplesDown (outputBlock);
+    }
+
+    DSP& get() noexcept { return processor; }
+    const DSP& get() const noexcept { return processor; }
+
+private:
+    static constexpr int numFilters = 2;
+
+    DSP processor;
+
+    std::array<std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, maxFactorIndex>, numFilters> oversamplers;
+    juce::dsp::Oversampling<float>* current = nullptr;
+
+    double baseSampleRate = 44100.0;
+    int factorIndex = 0;
+    Filter filterType = Filter::LinearPhase;
+};
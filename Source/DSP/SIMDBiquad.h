@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    SIMDBiquad.h
+
+    Multichannel biquad with the channel states packed into SIMD lanes.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDHelpers.h"
+
+//==============================================================================
+/**
+    A transposed direct form II biquad that keeps one channel per SIMD lane, so
+    a stereo (or up to 8 channel, depending on the register width) signal runs
+    through one vector recurrence instead of one scalar filter per channel.
+    Wider layouts are split into groups of SIMDHelpers::lanes channels.
+
+    Unlike juce::dsp::IIR::Filter every channel has its own state, and the
+    coefficients are plain floats, so updating them never allocates.
+*/
+class SIMDBiquad
+{
+public:
+    using Vec = SIMDHelpers::Float;
+
+    //b0, b1, b2, a0, a1, a2 like juce::dsp::IIR::ArrayCoefficients
+    using Coefficients = std::array<float, 6>;
+
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        const auto numGroups = (spec.numChannels + SIMDHelpers::lanes - 1) / SIMDHelpers::lanes;
+        state.resize (juce::jmax ((size_t) 1, (size_t) numGroups));
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        for (auto& s : state)
+            s = { Vec::expand (0.f), Vec::expand (0.f) };
+    }
+
+    /** Takes un-normalised coefficients and divides them by a0. */
+    void setCoefficients (const Coefficients& c) noexcept
+    {
+        const auto a0Inv = c[3] != 0.f ? 1.f / c[3] : 1.f;
+
+        b0 = c[0] * a0Inv;
+        b1 = c[1] * a0Inv;
+        b2 = c[2] * a0Inv;
+        a1 = c[4] * a0Inv;
+        a2 = c[5] * a0Inv;
+    }
+
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+        const auto numChannels = outputBlock.getNumChannels();
+        const auto numSamples = outputBlock.getNumSamples();
+
+        jassert (inputBlock.getNumChannels() == numChannels);
+        jassert (inputBlock.getNumSamples() == numSamples);
+        jassert (numChannels <= state.size() * SIMDHelpers::lanes);
+
+        if (context.isBypassed)
+        {
+            if (context.usesSeparateInputAndOutputBlocks())
+                outputBlock.copyFrom (inputBlock);
+
+            return;
+        }
+
+        const auto vb0 = Vec::expand (b0), vb1 = Vec::expand (b1), vb2 = Vec::expand (b2);
+        const auto va1 = Vec::expand (a1), va2 = Vec::expand (a2);
+
+        alignas (SIMDHelpers::alignment) float frames[chunkSize * SIMDHelpers::lanes];
+
+        for (size_t group = 0, first = 0; first < numChannels; ++group, first += SIMDHelpers::lanes)
+        {
+            const auto groupChannels = juce::jmin (SIMDHelpers::lanes, numChannels - first);
+            auto s1 = state[group].s1;
+            auto s2 = state[group].s2;
+
+            for (size_t start = 0; start < numSamples; start += chunkSize)
+            {
+                const auto length = juce::jmin (chunkSize, numSamples - start);
+
+                SIMDHelpers::pack (inputBlock, first, groupChannels, start, length, frames);
+
+                for (size_t i = 0; i < length; ++i)
+                {
+                    auto* frame = frames + i * SIMDHelpers::lanes;
+                    const auto x = Vec::fromRawArray (frame);
+                    const auto y = vb0 * x + s1;
+
+                    s1 = vb1 * x - va1 * y + s2;
+                    s2 = vb2 * x - va2 * y;
+
+                    y.copyToRawArray (frame);
+                }
+
+                SIMDHelpers::unpack (frames, outputBlock, first, groupChannels, start, length);
+            }
+
+            state[group] = { s1, s2 };
+        }
+    }
+
+private:
+    static constexpr size_t chunkSize = 64;
+
+    struct State
+    {
+        Vec s1, s2;
+    };
+
+    std::vector<State> state;
+
+    //starts as a pass through filter
+    float b0 = 1.f, b1 = 0.f, b2 = 0.f, a1 = 0.f, a2 = 0.f;
+};
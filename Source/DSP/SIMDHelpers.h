@@ -0,0 +1,314 @@
+/*
+  ==============================================================================
+
+    SIMDHelpers.h
+
+    Shared pieces for the SIMD filter kernels: the register type, the few
+    operations juce::dsp::SIMDRegister doesn't have, and channel packing.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_USE_SIMD && JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+#if JUCE_USE_SIMD && JUCE_ARM && defined (__aarch64__)
+ #include <arm_neon.h>
+#endif
+
+namespace SIMDHelpers
+{
+#if JUCE_USE_SIMD
+    using Float = juce::dsp::SIMDRegister<float>;
+#else
+    /** One lane stand in with the SIMDRegister interface, for builds without SIMD. */
+    struct Float
+    {
+        using ElementType = float;
+
+        static constexpr size_t size() noexcept { return 1; }
+        static Float expand (float v) noexcept { return { v }; }
+        static Float fromRawArray (const float* a) noexcept { return { *a }; }
+        void copyToRawArray (float* a) const noexcept { *a = value; }
+        float get (size_t) const noexcept { return value; }
+        void set (size_t, float v) noexcept { value = v; }
+
+        static Float min (Float a, Float b) noexcept { return { juce::jmin (a.value, b.value) }; }
+        static Float max (Float a, Float b) noexcept { return { juce::jmax (a.value, b.value) }; }
+        static Float truncate (Float a) noexcept { return { std::trunc (a.value) }; }
+        static Float abs (Float a) noexcept { return { std::abs (a.value) }; }
+
+        Float operator+ (Float o) const noexcept { return { value + o.value }; }
+        Float operator- (Float o) const noexcept { return { value - o.value }; }
+        Float operator* (Float o) const noexcept { return { value * o.value }; }
+        Float operator+ (float o) const noexcept { return { value + o }; }
+        Float operator- (float o) const noexcept { return { value - o }; }
+        Float operator* (float o) const noexcept { return { value * o }; }
+        Float& operator+= (Float o) noexcept { value += o.value; return *this; }
+        Float& operator-= (Float o) noexcept { value -= o.value; return *this; }
+        Float& operator*= (Float o) noexcept { value *= o.value; return *this; }
+
+        float value;
+    };
+#endif
+
+    static constexpr size_t lanes = Float::size();
+
+    //alignment for stack buffers that are read with fromRawArray
+    static constexpr size_t alignment = 32;
+
+    //==============================================================================
+    /** Lane wise a / b. SIMDRegister has no division, so this goes to the native
+        instruction where there is one and falls back to a per lane loop.
+    */
+    inline Float divide (Float a, Float b) noexcept
+    {
+       #if JUCE_USE_SIMD && JUCE_INTEL
+        if constexpr (lanes == 4)
+            return Float::fromNative (_mm_div_ps (a.value, b.value));
+       #if defined (__AVX__)
+        else if constexpr (lanes == 8)
+            return Float::fromNative (_mm256_div_ps (a.value, b.value));
+       #endif
+        else
+       #elif JUCE_USE_SIMD && JUCE_ARM && defined (__aarch64__)
+        if constexpr (lanes == 4)
+            return Float::fromNative (vdivq_f32 (a.value, b.value));
+        else
+       #endif
+        {
+            Float result;
+
+            for (size_t i = 0; i < lanes; ++i)
+                result.set (i, a.get (i) / b.get (i));
+
+            return result;
+        }
+    }
+
+    /** Loads a register from any address, fromRawArray needs aligned memory
+        and audio block channels at a tile offset aren't.
+    */
+    inline Float loadUnaligned (const float* data) noexcept
+    {
+       #if JUCE_USE_SIMD && JUCE_INTEL
+        if constexpr (lanes == 4)
+            return Float::fromNative (_mm_loadu_ps (data));
+       #if defined (__AVX__)
+        else if constexpr (lanes == 8)
+            return Float::fromNative (_mm256_loadu_ps (data));
+       #endif
+        else
+       #elif JUCE_USE_SIMD && JUCE_ARM && defined (__aarch64__)
+        if constexpr (lanes == 4)
+            return Float::fromNative (vld1q_f32 (data));
+        else
+       #endif
+        {
+            Float result;
+
+            for (size_t i = 0; i < lanes; ++i)
+                result.set (i, data[i]);
+
+            return result;
+        }
+    }
+
+    /** Peak magnitude and sum of squares of a channel in one pass, added to peak
+        and sumOfSquares. Metering reads every sample once for both.
+    */
+    inline void addPeakAndSumOfSquares (const float* data, size_t length, float& peak, float& sumOfSquares) noexcept
+    {
+        auto peaks = Float::expand (0.f);
+        auto sums = Float::expand (0.f);
+        size_t i = 0;
+
+        for (; i + lanes <= length; i += lanes)
+        {
+            const auto x = loadUnaligned (data + i);
+            peaks = Float::max (peaks, Float::abs (x));
+            sums += x * x;
+        }
+
+        auto blockPeak = 0.f;
+        auto blockSum = 0.f;
+
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            blockPeak = juce::jmax (blockPeak, peaks.get (lane));
+            blockSum += sums.get (lane);
+        }
+
+        for (; i < length; ++i)
+        {
+            blockPeak = juce::jmax (blockPeak, std::abs (data[i]));
+            blockSum += data[i] * data[i];
+        }
+
+        peak = juce::jmax (peak, blockPeak);
+        sumOfSquares += blockSum;
+    }
+
+    /** True when no sample of a channel reaches threshold. Takes the peak a
+        register at a time and checks it after every run of 64 samples, so
+        audible audio stops after the first run and only silence gets read to
+        the end.
+    */
+    inline bool isSilent (const float* data, size_t length, float threshold) noexcept
+    {
+        static constexpr size_t runLength = 64;
+        const auto wholeRegisters = length - length % lanes;
+        size_t i = 0;
+
+        while (i < wholeRegisters)
+        {
+            auto peaks = Float::expand (0.f);
+            const auto runEnd = juce::jmin (wholeRegisters, i + runLength);
+
+            for (; i < runEnd; i += lanes)
+                peaks = Float::max (peaks, Float::abs (loadUnaligned (data + i)));
+
+            for (size_t lane = 0; lane < lanes; ++lane)
+                if (peaks.get (lane) >= threshold)
+                    return false;
+        }
+
+        for (; i < length; ++i)
+            if (std::abs (data[i]) >= threshold)
+                return false;
+
+        return true;
+    }
+
+    /** [7/6] Pade approximant of tanh, clamped where it reaches +-1.
+        Max error against std::tanh is about 1e-4, which is what the 128 point
+        lookup table in juce::dsp::LadderFilter gives as well.
+    */
+    inline Float tanh (Float x) noexcept
+    {
+        static constexpr float clamp = 4.97f;
+
+        x = Float::min (Float::max (x, Float::expand (-clamp)), Float::expand (clamp));
+
+        auto x2 = x * x;
+        auto num = x * (((x2 + 378.f) * x2 + 17325.f) * x2 + 135135.f);
+        auto den = ((x2 * 28.f + 3150.f) * x2 + 62370.f) * x2 + 135135.f;
+
+        return divide (num, den);
+    }
+
+    /** [3/2] Pade approximant of tanh, clamped at 3 where it is exactly +-1.
+        Max error against std::tanh is about 2.4e-2, only a third of the
+        multiplies of tanh() and still smooth, good enough for a drive stage.
+    */
+    inline Float tanhFast (Float x) noexcept
+    {
+        static constexpr float clamp = 3.f;
+
+        x = Float::min (Float::max (x, Float::expand (-clamp)), Float::expand (clamp));
+
+        auto x2 = x * x;
+        return divide (x * (x2 + 27.f), x2 * 9.f + 27.f);
+    }
+
+    /** std::tanh per lane, the reference the approximations are measured against. */
+    inline Float tanhExact (Float x) noexcept
+    {
+        Float result;
+
+        for (size_t i = 0; i < lanes; ++i)
+            result.set (i, std::tanh (x.get (i)));
+
+        return result;
+    }
+
+    /** Which tanh a saturating kernel uses, from the reference down to the cheapest. */
+    enum class TanhAccuracy
+    {
+        Exact,
+        Accurate,
+        Fast,
+    };
+
+    template <TanhAccuracy accuracy>
+    Float tanh (Float x) noexcept
+    {
+        if constexpr (accuracy == TanhAccuracy::Exact)
+            return tanhExact (x);
+        else if constexpr (accuracy == TanhAccuracy::Fast)
+            return tanhFast (x);
+        else
+            return tanh (x);
+    }
+
+    /** Sine for x in [-pi, pi]. Folds into [-pi/2, pi/2] and uses the Taylor
+        series up to x^11, max error against std::sin is below 1e-6.
+    */
+    inline Float sin (Float x) noexcept
+    {
+        static constexpr auto pi = juce::MathConstants<float>::pi;
+
+        x = Float::min (x, Float::expand (pi) - x);
+        x = Float::max (x, Float::expand (-pi) - x);
+
+        auto x2 = x * x;
+        auto poly = ((((x2 * (-1.f / 39916800.f) + (1.f / 362880.f)) * x2 - (1.f / 5040.f)) * x2
+                      + (1.f / 120.f)) * x2 - (1.f / 6.f)) * x2 + 1.f;
+
+        return x * poly;
+    }
+
+    /** Wraps a non negative phase back into [0, 2pi). */
+    inline Float wrapPhase (Float phase) noexcept
+    {
+        static constexpr auto twoPi = juce::MathConstants<float>::twoPi;
+
+        return phase - Float::truncate (phase * (1.f / twoPi)) * twoPi;
+    }
+
+    //==============================================================================
+    /** Interleaves up to `lanes` channels of a block into frames of one register
+        each, so a kernel can run all of them through one vector recurrence.
+        Unused lanes are zeroed.
+    */
+    template <typename BlockType>
+    void pack (const BlockType& block, size_t firstChannel, size_t numChannels,
+               size_t start, size_t length, float* frames) noexcept
+    {
+        jassert (numChannels <= lanes);
+
+        for (size_t ch = 0; ch < lanes; ++ch)
+        {
+            if (ch < numChannels)
+            {
+                const auto* src = block.getChannelPointer (firstChannel + ch) + start;
+
+                for (size_t i = 0; i < length; ++i)
+                    frames[i * lanes + ch] = src[i];
+            }
+            else
+            {
+                for (size_t i = 0; i < length; ++i)
+                    frames[i * lanes + ch] = 0.f;
+            }
+        }
+    }
+
+    template <typename BlockType>
+    void unpack (const float* frames, const BlockType& block, size_t firstChannel, size_t numChannels,
+                 size_t start, size_t length) noexcept
+    {
+        for (size_t ch = 0; ch < numChannels; ++ch)
+        {
+            auto* dest = block.getChannelPointer (firstChannel + ch) + start;
+
+            for (size_t i = 0; i < length; ++i)
+                dest[i] = frames[i * lanes + ch];
+        }
+    }
+}
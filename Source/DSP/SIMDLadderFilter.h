@@ -0,0 +1,298 @@
+/*
+  ==============================================================================
+
+    SIMDLadderFilter.h
+
+    The juce::dsp::LadderFilter algorithm with the channels packed into SIMD
+    lanes.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDHelpers.h"
+
+//==============================================================================
+/**
+    Same model, parameter mapping and smoothing as juce::dsp::LadderFilter, but
+    all channels of a group share one vector recurrence instead of looping over
+    the channels for every sample. Has the same setters, so it slots into the
+    overdrive and ladder stages unchanged.
+*/
+class SIMDLadderFilter
+{
+public:
+    using Vec = SIMDHelpers::Float;
+    using Mode = juce::dsp::LadderFilterMode;
+
+    SIMDLadderFilter()
+    {
+        setSampleRate (1000.0);
+        setResonance (0.f);
+        setDrive (1.2f);
+        setMode (Mode::LPF12);
+    }
+
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        const auto numGroups = (spec.numChannels + SIMDHelpers::lanes - 1) / SIMDHelpers::lanes;
+        state.resize (juce::jmax ((size_t) 1, (size_t) numGroups));
+
+        setSampleRate (spec.sampleRate);
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        for (auto& s : state)
+            s.fill (Vec::expand (0.f));
+
+        cutoffTransformSmoother.setCurrentAndTargetValue (cutoffTransformSmoother.getTargetValue());
+        scaledResonanceSmoother.setCurrentAndTargetValue (scaledResonanceSmoother.getTargetValue());
+    }
+
+    /** Changing the rate doesn't allocate, so this is safe to call from the audio thread. */
+    void setSampleRate (double sampleRate) noexcept
+    {
+        jassert (sampleRate > 0.0);
+
+        cutoffFreqScaler = (float) (-2.0 * juce::MathConstants<double>::pi / sampleRate);
+
+        static constexpr double smootherRampTimeSec = 0.05;
+        defaultCutoffRampLength = (int) std::floor (smootherRampTimeSec * sampleRate);
+        cutoffRampLength = defaultCutoffRampLength;
+        cutoffTransformSmoother.reset (cutoffRampLength);
+        scaledResonanceSmoother.reset (sampleRate, smootherRampTimeSec);
+
+        updateCutoffFreq();
+    }
+
+    void setMode (Mode newMode) noexcept
+    {
+        auto gains = getModeGains (newMode);
+        A = gains.A;
+        comp = gains.comp;
+        mode = newMode;
+    }
+
+    void setCutoffFrequencyHz (float newCutoff) noexcept
+    {
+        setCutoffFrequencyHz (newCutoff, defaultCutoffRampLength);
+    }
+
+    /** Reaches newCutoff's coefficient after exactly rampLength samples at the
+        filter's rate instead of the usual 50 ms, 0 jumps. For callers that send
+        exact control points, the coefficient moves linearly in between.
+    */
+    void setCutoffFrequencyHz (float newCutoff, int rampLength) noexcept
+    {
+        jassert (newCutoff > 0.f);
+        cutoffFreqHz = newCutoff;
+
+        //reset starts the next ramp from the last target, where the previous control point left it
+        if (rampLength != cutoffRampLength)
+        {
+            cutoffRampLength = juce::jmax (0, rampLength);
+            cutoffTransformSmoother.reset (cutoffRampLength);
+        }
+
+        updateCutoffFreq();
+    }
+
+    void setResonance (float newResonance) noexcept
+    {
+        scaledResonanceSmoother.setTargetValue (getScaledResonance (newResonance));
+    }
+
+    void setDrive (float newDrive) noexcept
+    {
+        auto gains = getDriveGains (newDrive);
+        drive = gains.drive;
+        drive2 = gains.drive2;
+        gain = gains.gain;
+        gain2 = gains.gain2;
+    }
+
+    /** The tanh used for the input and feedback saturation. */
+    void setTanhAccuracy (SIMDHelpers::TanhAccuracy newAccuracy) noexcept { tanhAccuracy = newAccuracy; }
+
+    Mode getMode() const noexcept { return mode; }
+
+    //==============================================================================
+    /** Output mix of the five ladder taps and the resonance compensation of a mode. */
+    struct ModeGains
+    {
+        std::array<float, 5> A;
+        float comp;
+    };
+
+    static ModeGains getModeGains (Mode newMode) noexcept
+    {
+        ModeGains g{};
+
+        switch (newMode)
+        {
+        case Mode::LPF12: g = { { { 0.f, 0.f, 1.f, 0.f, 0.f } }, 0.5f }; break;
+        case Mode::HPF12: g = { { { 1.f, -2.f, 1.f, 0.f, 0.f } }, 0.f }; break;
+        case Mode::BPF12: g = { { { 0.f, 0.f, -1.f, 1.f, 0.f } }, 0.5f }; break;
+        case Mode::LPF24: g = { { { 0.f, 0.f, 0.f, 0.f, 1.f } }, 0.5f }; break;
+        case Mode::HPF24: g = { { { 1.f, -4.f, 6.f, -4.f, 1.f } }, 0.f }; break;
+        case Mode::BPF24: g = { { { 0.f, 0.f, 1.f, -2.f, 1.f } }, 0.5f }; break;
+        default: jassertfalse; break;
+        }
+
+        static constexpr float outputGain = 1.2f;
+
+        for (auto& a : g.A)
+            a *= outputGain;
+
+        return g;
+    }
+
+    /** Input and feedback saturation amounts for a drive setting. */
+    struct DriveGains
+    {
+        float drive, drive2, gain, gain2;
+    };
+
+    static DriveGains getDriveGains (float newDrive) noexcept
+    {
+        jassert (newDrive >= 1.f);
+
+        DriveGains g;
+        g.drive = newDrive;
+        g.gain = std::pow (g.drive, -2.642f) * 0.6103f + 0.3903f;
+        g.drive2 = g.drive * 0.04f + 0.96f;
+        g.gain2 = std::pow (g.drive2, -2.642f) * 0.6103f + 0.3903f;
+        return g;
+    }
+
+    /** Maps the 0..1 resonance parameter to the value the feedback path uses. */
+    static float getScaledResonance (float resonance) noexcept
+    {
+        jassert (resonance >= 0.f && resonance <= 1.f);
+        return juce::jmap (resonance, 0.1f, 1.f);
+    }
+
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+        const auto numChannels = outputBlock.getNumChannels();
+        const auto numSamples = outputBlock.getNumSamples();
+
+        jassert (inputBlock.getNumChannels() == numChannels);
+        jassert (inputBlock.getNumSamples() == numSamples);
+        jassert (numChannels <= state.size() * SIMDHelpers::lanes);
+
+        if (context.isBypassed)
+        {
+            if (context.usesSeparateInputAndOutputBlocks())
+                outputBlock.copyFrom (inputBlock);
+
+            return;
+        }
+
+        alignas (SIMDHelpers::alignment) float frames[chunkSize * SIMDHelpers::lanes];
+        float cutoffTransforms[chunkSize], resonances[chunkSize];
+
+        for (size_t start = 0; start < numSamples; start += chunkSize)
+        {
+            const auto length = juce::jmin (chunkSize, numSamples - start);
+
+            //the smoothers step once per sample for all channels, like the juce ladder
+            for (size_t i = 0; i < length; ++i)
+            {
+                cutoffTransforms[i] = cutoffTransformSmoother.getNextValue();
+                resonances[i] = scaledResonanceSmoother.getNextValue();
+            }
+
+            for (size_t group = 0, first = 0; first < numChannels; ++group, first += SIMDHelpers::lanes)
+            {
+                const auto groupChannels = juce::jmin (SIMDHelpers::lanes, numChannels - first);
+
+                SIMDHelpers::pack (inputBlock, first, groupChannels, start, length, frames);
+                processFrames (state[group], frames, cutoffTransforms, resonances, length);
+                SIMDHelpers::unpack (frames, outputBlock, first, groupChannels, start, length);
+            }
+        }
+    }
+
+private:
+    using State = std::array<Vec, 5>;
+    using TanhAccuracy = SIMDHelpers::TanhAccuracy;
+
+    void processFrames (State& s, float* frames, const float* cutoffTransforms,
+                        const float* resonances, size_t length) noexcept
+    {
+        //one branch per chunk, the sample loop is compiled once per accuracy
+        switch (tanhAccuracy)
+        {
+        case TanhAccuracy::Exact:    processFramesUsing<TanhAccuracy::Exact> (s, frames, cutoffTransforms, resonances, length); break;
+        case TanhAccuracy::Accurate: processFramesUsing<TanhAccuracy::Accurate> (s, frames, cutoffTransforms, resonances, length); break;
+        case TanhAccuracy::Fast:     processFramesUsing<TanhAccuracy::Fast> (s, frames, cutoffTransforms, resonances, length); break;
+        }
+    }
+
+    template <TanhAccuracy accuracy>
+    void processFramesUsing (State& s, float* frames, const float* cutoffTransforms,
+                             const float* resonances, size_t length) noexcept
+    {
+        const auto vDrive = Vec::expand (drive), vDrive2 = Vec::expand (drive2);
+        const auto vGain = Vec::expand (gain), vGain2 = Vec::expand (gain2);
+        const auto vComp = Vec::expand (comp);
+
+        auto s0 = s[0], s1 = s[1], s2 = s[2], s3 = s[3], s4 = s[4];
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            auto* frame = frames + i * SIMDHelpers::lanes;
+
+            const auto a1 = cutoffTransforms[i];
+            const auto g = 1.f - a1;
+            const auto b0 = Vec::expand (g * 0.76923076923f);
+            const auto b1 = Vec::expand (g * 0.23076923076f);
+            const auto va1 = Vec::expand (a1);
+
+            const auto dx = vGain * SIMDHelpers::tanh<accuracy> (vDrive * Vec::fromRawArray (frame));
+            const auto a = dx + (vGain2 * SIMDHelpers::tanh<accuracy> (vDrive2 * s4) - dx * vComp) * (resonances[i] * -4.f);
+
+            const auto b = b1 * s0 + va1 * s1 + b0 * a;
+            const auto c = b1 * s1 + va1 * s2 + b0 * b;
+            const auto d = b1 * s2 + va1 * s3 + b0 * c;
+            const auto e = b1 * s3 + va1 * s4 + b0 * d;
+
+            s0 = a;
+            s1 = b;
+            s2 = c;
+            s3 = d;
+            s4 = e;
+
+            const auto y = a * A[0] + b * A[1] + c * A[2] + d * A[3] + e * A[4];
+            y.copyToRawArray (frame);
+        }
+
+        s = { s0, s1, s2, s3, s4 };
+    }
+
+    void updateCutoffFreq() noexcept
+    {
+        cutoffTransformSmoother.setTargetValue (std::exp (cutoffFreqHz * cutoffFreqScaler));
+    }
+
+    static constexpr size_t chunkSize = 64;
+
+    std::vector<State> state;
+
+    juce::SmoothedValue<float> cutoffTransformSmoother, scaledResonanceSmoother;
+    float cutoffFreqHz = 200.f, cutoffFreqScaler = 0.f;
+    int cutoffRampLength = 0, defaultCutoffRampLength = 0;
+    float drive = 1.f, drive2 = 1.f, gain = 1.f, gain2 = 1.f, comp = 0.f;
+
+    std::array<float, 5> A{};
+    Mode mode = Mode::LPF12;
+    TanhAccuracy tanhAccuracy = TanhAccuracy::Accurate;
+};
@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    SIMDOverdrive.h
+
+    A memoryless tanh waveshaper for the overdrive stage.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDHelpers.h"
+#include "SIMDLadderFilter.h"
+
+//==============================================================================
+/**
+    The overdrive stage used to be a ladder filter opened up to 20 kHz, run only
+    for the tanh on its input. This keeps that input saturation with the same
+    drive to gain mapping, and drops the four one pole filters and the feedback
+    path it didn't need.
+
+    There is no state, so the samples are processed straight along each
+    channel, a register at a time, instead of packing channels into lanes.
+*/
+class SIMDOverdrive
+{
+public:
+    using Vec = SIMDHelpers::Float;
+    using TanhAccuracy = SIMDHelpers::TanhAccuracy;
+
+    void prepare (const juce::dsp::ProcessSpec&) {}
+    void reset() noexcept {}
+
+    //nothing depends on the rate, this is here for Oversampled
+    void setSampleRate (double) noexcept {}
+
+    void setDrive (float newDrive) noexcept
+    {
+        auto gains = SIMDLadderFilter::getDriveGains (newDrive);
+        drive = gains.drive;
+        gain = gains.gain;
+    }
+
+    void setTanhAccuracy (TanhAccuracy newAccuracy) noexcept { tanhAccuracy = newAccuracy; }
+
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+
+        jassert (inputBlock.getNumChannels() == outputBlock.getNumChannels());
+        jassert (inputBlock.getNumSamples() == outputBlock.getNumSamples());
+
+        if (context.isBypassed)
+        {
+            if (context.usesSeparateInputAndOutputBlocks())
+                outputBlock.copyFrom (inputBlock);
+
+            return;
+        }
+
+        switch (tanhAccuracy)
+        {
+        case TanhAccuracy::Exact:    processBlock<TanhAccuracy::Exact> (inputBlock, outputBlock); break;
+        case TanhAccuracy::Accurate: processBlock<TanhAccuracy::Accurate> (inputBlock, outputBlock); break;
+        case TanhAccuracy::Fast:     processBlock<TanhAccuracy::Fast> (inputBlock, outputBlock); break;
+        }
+    }
+
+private:
+    template <TanhAccuracy accuracy, typename InputBlock, typename OutputBlock>
+    void processBlock (const InputBlock& inputBlock, OutputBlock& outputBlock) noexcept
+    {
+        const auto numSamples = outputBlock.getNumSamples();
+        const auto vDrive = Vec::expand (drive), vGain = Vec::expand (gain);
+
+        //the block pointers aren't aligned, so go through an aligned chunk
+        alignas (SIMDHelpers::alignment) float chunk[chunkSize];
+
+        for (size_t ch = 0; ch < outputBlock.getNumChannels(); ++ch)
+        {
+            const auto* src = inputBlock.getChannelPointer (ch);
+            auto* dest = outputBlock.getChannelPointer (ch);
+
+            for (size_t start = 0; start < numSamples; start += chunkSize)
+            {
+                const auto length = juce::jmin (chunkSize, numSamples - start);
+                const auto padded = (length + SIMDHelpers::lanes - 1) / SIMDHelpers::lanes * SIMDHelpers::lanes;
+
+                std::copy (src + start, src + start + length, chunk);
+                std::fill (chunk + length, chunk + padded, 0.f);
+
+                for (size_t i = 0; i < padded; i += SIMDHelpers::lanes)
+                {
+                    const auto x = Vec::fromRawArray (chunk + i);
+                    (vGain * SIMDHelpers::tanh<accuracy> (vDrive * x)).copyToRawArray (chunk + i);
+                }
+
+                std::copy (chunk, chunk + length, dest + start);
+            }
+        }
+    }
+
+    static constexpr size_t chunkSize = 64;
+
+    float drive = 1.f, gain = 1.f;
+    TanhAccuracy tanhAccuracy = TanhAccuracy::Accurate;
+};
@@ -0,0 +1,281 @@
+/*
+  ==============================================================================
+
+    SIMDStateVariableFilter.h
+
+    Topology preserving state variable filter with the channel states packed
+    into SIMD lanes and coefficients that ramp per sample.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDHelpers.h"
+#include "FilterCoefficientCache.h"
+
+//==============================================================================
+/**
+    The general filter's four modes as a trapezoidal (TPT) state variable
+    filter. At fixed settings it has the same response as the biquads from
+    FilterCoefficientCache, the difference is how it moves.
+
+    A biquad's coefficients can't be interpolated, halfway between two stable
+    sets can be an unstable one, so a sweep has to jump from one set to the
+    next. The SVF is stable for any positive g and k, so setCoefficients()
+    can take the exact coefficients at the end of a control block and ramp g,
+    k and the output mix there linearly, sample by sample. The derived
+    coefficients are worked out for a register of samples at a time, the
+    recurrence runs one channel per lane like SIMDBiquad.
+*/
+class SIMDStateVariableFilter
+{
+public:
+    using Vec = SIMDHelpers::Float;
+    using Mode = FilterCoefficientCache::Mode;
+
+    /** g = tan (pi f / fs), k = 1 / Q and the output mix m0 x + m1 band. Every mode
+        is a mix of the input and the band pass output.
+    */
+    struct Coefficients
+    {
+        float g = 0.f, k = 2.f, m0 = 1.f, m1 = 0.f;
+    };
+
+    /** Like FilterCoefficientCache::calculate, without the quantization. */
+    static Coefficients calculate (Mode mode, double sampleRate, float freqHz, float quality, float gainDb) noexcept
+    {
+        jassert (sampleRate > 0.0 && quality > 0.f);
+
+        Coefficients c;
+        c.g = (float) std::tan (juce::MathConstants<double>::pi * juce::jlimit (1.0, sampleRate * 0.49, (double) freqHz) / sampleRate);
+        c.k = 1.f / juce::jmax (1.0e-3f, quality);
+
+        switch (mode)
+        {
+        case Mode::Peak:
+        {
+            //the bell of juce's makePeakFilter, which takes A = sqrt (gain) as well
+            const auto A = std::sqrt (juce::Decibels::decibelsToGain (gainDb));
+            c.k /= A;
+            c.m1 = c.k * (A * A - 1.f);
+            break;
+        }
+        case Mode::BandPass: c.m0 = 0.f; c.m1 = c.k; break;
+        case Mode::Notch:    c.m1 = -c.k; break;
+        case Mode::AllPass:  c.m1 = -2.f * c.k; break;
+        }
+
+        return c;
+    }
+
+    void prepare (const juce::dsp::ProcessSpec& spec)
+    {
+        const auto numGroups = (spec.numChannels + SIMDHelpers::lanes - 1) / SIMDHelpers::lanes;
+        state.resize (juce::jmax ((size_t) 1, (size_t) numGroups));
+        reset();
+    }
+
+    /** Clears the state and finishes a ramp that's still going. */
+    void reset() noexcept
+    {
+        for (auto& s : state)
+            s = { Vec::expand (0.f), Vec::expand (0.f) };
+
+        current = target;
+        rampRemaining = 0;
+    }
+
+    /** Moves to the new coefficients over rampLength samples, 0 jumps. A ramp
+        that isn't finished yet starts over from where it got to.
+    */
+    void setCoefficients (const Coefficients& newCoefficients, int rampLength = 0) noexcept
+    {
+        target = newCoefficients;
+        rampRemaining = juce::jmax (0, rampLength);
+
+        if (rampRemaining == 0)
+        {
+            current = target;
+            return;
+        }
+
+        const auto scale = 1.f / (float) rampRemaining;
+        increment = { (target.g - current.g) * scale, (target.k - current.k) * scale,
+                      (target.m0 - current.m0) * scale, (target.m1 - current.m1) * scale };
+    }
+
+    bool isRamping() const noexcept { return rampRemaining > 0; }
+
+    template <typename ProcessContext>
+    void process (const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+        const auto numChannels = outputBlock.getNumChannels();
+        const auto numSamples = outputBlock.getNumSamples();
+
+        jassert (inputBlock.getNumChannels() == numChannels);
+        jassert (inputBlock.getNumSamples() == numSamples);
+        jassert (numChannels <= state.size() * SIMDHelpers::lanes);
+
+        if (context.isBypassed)
+        {
+            if (context.usesSeparateInputAndOutputBlocks())
+                outputBlock.copyFrom (inputBlock);
+
+            return;
+        }
+
+        alignas (SIMDHelpers::alignment) float frames[chunkSize * SIMDHelpers::lanes];
+        alignas (SIMDHelpers::alignment) Ramp ramp;
+
+        for (size_t start = 0; start < numSamples; start += chunkSize)
+        {
+            const auto length = juce::jmin (chunkSize, numSamples - start);
+
+            //the coefficients step once per sample for all channels, like the ladder's smoothers
+            const auto ramping = rampRemaining > 0;
+
+            if (ramping)
+                fillRamp (ramp, length);
+
+            for (size_t group = 0, first = 0; first < numChannels; ++group, first += SIMDHelpers::lanes)
+            {
+                const auto groupChannels = juce::jmin (SIMDHelpers::lanes, numChannels - first);
+
+                SIMDHelpers::pack (inputBlock, first, groupChannels, start, length, frames);
+
+                if (ramping)
+                    processFrames<true> (state[group], frames, ramp, length);
+                else
+                    processFrames<false> (state[group], frames, ramp, length);
+
+                SIMDHelpers::unpack (frames, outputBlock, first, groupChannels, start, length);
+            }
+        }
+    }
+
+private:
+    static constexpr size_t chunkSize = 64;
+
+    //ic1eq and ic2eq, the two integrators
+    struct State
+    {
+        Vec s1, s2;
+    };
+
+    //per sample coefficients of a chunk
+    struct Ramp
+    {
+        alignas (SIMDHelpers::alignment) float a1[chunkSize];
+        alignas (SIMDHelpers::alignment) float a2[chunkSize];
+        alignas (SIMDHelpers::alignment) float a3[chunkSize];
+        alignas (SIMDHelpers::alignment) float m0[chunkSize];
+        alignas (SIMDHelpers::alignment) float m1[chunkSize];
+    };
+
+    struct Derived
+    {
+        float a1, a2, a3;
+    };
+
+    static Derived derive (float g, float k) noexcept
+    {
+        const auto a1 = 1.f / (1.f + g * (g + k));
+        return { a1, g * a1, g * g * a1 };
+    }
+
+    void fillRamp (Ramp& ramp, size_t length) noexcept
+    {
+        float g[chunkSize], k[chunkSize];
+
+        //the ramp ends exactly on the target, after that it holds
+        for (size_t i = 0; i < length; ++i)
+        {
+            if (rampRemaining > 0 && --rampRemaining == 0)
+            {
+                current = target;
+            }
+            else if (rampRemaining > 0)
+            {
+                current.g += increment.g;
+                current.k += increment.k;
+                current.m0 += increment.m0;
+                current.m1 += increment.m1;
+            }
+
+            g[i] = current.g;
+            k[i] = current.k;
+            ramp.m0[i] = current.m0;
+            ramp.m1[i] = current.m1;
+        }
+
+        //a1 = 1 / (1 + g (g + k)) a register of samples at a time, the one division per sample
+        size_t i = 0;
+
+        for (; i + SIMDHelpers::lanes <= length; i += SIMDHelpers::lanes)
+        {
+            const auto vg = SIMDHelpers::loadUnaligned (g + i);
+            const auto vk = SIMDHelpers::loadUnaligned (k + i);
+            const auto a1 = SIMDHelpers::divide (Vec::expand (1.f), vg * (vg + vk) + 1.f);
+            const auto a2 = vg * a1;
+
+            a1.copyToRawArray (ramp.a1 + i);
+            a2.copyToRawArray (ramp.a2 + i);
+            (vg * a2).copyToRawArray (ramp.a3 + i);
+        }
+
+        for (; i < length; ++i)
+        {
+            const auto d = derive (g[i], k[i]);
+            ramp.a1[i] = d.a1;
+            ramp.a2[i] = d.a2;
+            ramp.a3[i] = d.a3;
+        }
+    }
+
+    template <bool ramping>
+    void processFrames (State& s, float* frames, const Ramp& ramp, size_t length) noexcept
+    {
+        const auto fixed = derive (current.g, current.k);
+
+        auto va1 = Vec::expand (fixed.a1), va2 = Vec::expand (fixed.a2), va3 = Vec::expand (fixed.a3);
+        auto vm0 = Vec::expand (current.m0), vm1 = Vec::expand (current.m1);
+
+        auto s1 = s.s1, s2 = s.s2;
+
+        for (size_t i = 0; i < length; ++i)
+        {
+            if constexpr (ramping)
+            {
+                va1 = Vec::expand (ramp.a1[i]);
+                va2 = Vec::expand (ramp.a2[i]);
+                va3 = Vec::expand (ramp.a3[i]);
+                vm0 = Vec::expand (ramp.m0[i]);
+                vm1 = Vec::expand (ramp.m1[i]);
+            }
+
+            auto* frame = frames + i * SIMDHelpers::lanes;
+            const auto x = Vec::fromRawArray (frame);
+
+            const auto v3 = x - s2;
+            const auto band = va1 * s1 + va2 * v3;
+            const auto low = s2 + va2 * s1 + va3 * v3;
+
+            s1 = band * 2.f - s1;
+            s2 = low * 2.f - s2;
+
+            (vm0 * x + vm1 * band).copyToRawArray (frame);
+        }
+
+        s = { s1, s2 };
+    }
+
+    std::vector<State> state;
+
+    //starts as a pass through filter
+    Coefficients current, target, increment { 0.f, 0.f, 0.f, 0.f };
+    int rampRemaining = 0;
+};
@@ -0,0 +1,170 @@
+/*
+  ==============================================================================
+
+    StageMeters.h
+
+    Peak and RMS in front of and behind every stage of the chain.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SIMDHelpers.h"
+#include "../Utility/LatestValueMailbox.h"
+
+//==============================================================================
+/** Running peak and sum of squares of a signal, over every channel. */
+struct MeterLevel
+{
+    float peak = 0.f;
+    float sumOfSquares = 0.f;
+    juce::uint32 numValues = 0;
+
+    /** One SIMD pass per channel of the block. */
+    static MeterLevel measure (const juce::dsp::AudioBlock<float>& block) noexcept
+    {
+        MeterLevel level;
+
+        for (size_t ch = 0; ch < block.getNumChannels(); ++ch)
+            SIMDHelpers::addPeakAndSumOfSquares (block.getChannelPointer (ch), block.getNumSamples(),
+                                                 level.peak, level.sumOfSquares);
+
+        level.numValues = static_cast<juce::uint32> (block.getNumChannels() * block.getNumSamples());
+        return level;
+    }
+
+    void add (const MeterLevel& other) noexcept
+    {
+        peak = juce::jmax (peak, other.peak);
+        sumOfSquares += other.sumOfSquares;
+        numValues += other.numValues;
+    }
+
+    float getRms() const noexcept
+    {
+        return numValues > 0 ? std::sqrt (sumOfSquares / static_cast<float> (numValues)) : 0.f;
+    }
+};
+
+//==============================================================================
+/**
+    Collects a MeterLevel for the input and the output of every stage and of
+    the whole chain on the audio thread, and publishes them through a
+    LatestValueMailbox about 30 times a second. The output of one stage is the
+    input of the next, so the chain measures every signal once: the block
+    before the first stage and after every stage, plus the mix of each group
+    of parallel branches.
+
+    Like the StageProfiler, stages add from whichever thread runs them, each
+    stage from one thread at a time, in between beginBlock() and endBlock().
+    getLatest() is for one reader, the editor.
+*/
+class StageMeters
+{
+public:
+    static constexpr int maxStages = 16;
+    static constexpr double publishRateHz = 30.0;
+
+    struct Reading
+    {
+        float inputPeak = 0.f, inputRms = 0.f;
+        float outputPeak = 0.f, outputRms = 0.f;
+    };
+
+    struct Snapshot
+    {
+        std::array<Reading, maxStages> stages{};
+        Reading chain;
+        int numStages = 0;
+    };
+
+    explicit StageMeters (int numStagesToUse)
+        : numStages (juce::jlimit (1, maxStages, numStagesToUse))
+    {
+    }
+
+    //==============================================================================
+    void setEnabled (bool shouldBeEnabled) noexcept { enabled.store (shouldBeEnabled, std::memory_order_release); }
+    bool isEnabled() const noexcept { return enabled.load (std::memory_order_relaxed); }
+
+    /** From prepareToPlay, sets how many samples go into one published reading. */
+    void prepare (double sampleRate) noexcept
+    {
+        samplesPerReading = juce::jmax (1, juce::roundToInt (sampleRate / publishRateHz));
+        clear();
+    }
+
+    int getNumStages() const noexcept { return numStages; }
+
+    //==============================================================================
+    /** Audio thread. Returns false when metering is off, skip the rest of the calls then. */
+    bool beginBlock() noexcept
+    {
+        return enabled.load (std::memory_order_acquire);
+    }
+
+    void addStage (int stage, const MeterLevel& input, const MeterLevel& output) noexcept
+    {
+        jassert (juce::isPositiveAndBelow (stage, numStages));
+        stageInputs[(size_t) stage].add (input);
+        stageOutputs[(size_t) stage].add (output);
+    }
+
+    void addChain (const MeterLevel& input, const MeterLevel& output) noexcept
+    {
+        chainInput.add (input);
+        chainOutput.add (output);
+    }
+
+    /** Publishes once enough samples went through since the last reading. */
+    void endBlock (int numSamples) noexcept
+    {
+        samplesSinceReading += numSamples;
+
+        if (samplesSinceReading < samplesPerReading)
+            return;
+
+        Snapshot snapshot;
+        snapshot.numStages = numStages;
+        snapshot.chain = makeReading (chainInput, chainOutput);
+
+        for (size_t i = 0; i < (size_t) numStages; ++i)
+            snapshot.stages[i] = makeReading (stageInputs[i], stageOutputs[i]);
+
+        mailbox.push (snapshot);
+        clear();
+    }
+
+    //==============================================================================
+    /** Copies the newest reading to snapshot, false when there's been none since the last call. */
+    bool getLatest (Snapshot& snapshot) noexcept { return mailbox.pull (snapshot); }
+
+private:
+    static Reading makeReading (const MeterLevel& input, const MeterLevel& output) noexcept
+    {
+        return { input.peak, input.getRms(), output.peak, output.getRms() };
+    }
+
+    void clear() noexcept
+    {
+        stageInputs.fill ({});
+        stageOutputs.fill ({});
+        chainInput = {};
+        chainOutput = {};
+        samplesSinceReading = 0;
+    }
+
+    const int numStages;
+    std::atomic<bool> enabled { false };
+
+    //audio thread only, summed until the next reading is published
+    std::array<MeterLevel, maxStages> stageInputs, stageOutputs;
+    MeterLevel chainInput, chainOutput;
+    int samplesPerReading = 1600, samplesSinceReading = 0;
+
+    LatestValueMailbox<Snapshot> mailbox;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StageMeters)
+};
@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    TailModel.h
+
+    How long each stage keeps ringing after its input goes silent.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    Tail lengths of the stages in seconds, from their parameters: the time it
+    takes a full scale signal to fall below silenceThresholdDb once the input
+    is gone. They err on the long side, the processor stops running a stage
+    after its tail, so a short guess cuts off something audible.
+
+    A stage that never stops on its own, a self oscillating ladder or full
+    feedback, has an infinite tail.
+*/
+namespace TailModel
+{
+    static constexpr float silenceThresholdDb = -100.f;
+
+    inline float getSilenceThreshold() noexcept
+    {
+        //-100 dB is where juce::Decibels gives up and returns 0
+        return juce::Decibels::decibelsToGain (silenceThresholdDb, silenceThresholdDb - 1.f);
+    }
+
+    /** Time constants of exponential decay from gain down to the threshold. */
+    inline double getDecayTimeConstants (double gain = 1.0) noexcept
+    {
+        return std::log (juce::jmax (1.0, gain) / (double) getSilenceThreshold());
+    }
+
+    /** Round trips through a feedback loop until it's below the threshold, 0 without feedback. */
+    inline double getFeedbackPasses (double feedback) noexcept
+    {
+        feedback = std::abs (feedback);
+
+        if (feedback < 1.0e-6)
+            return 0.0;
+
+        if (feedback >= 1.0)
+            return std::numeric_limits<double>::infinity();
+
+        return getDecayTimeConstants() / -std::log (feedback);
+    }
+
+    //==============================================================================
+    /** The allpasses ring longest at the bottom of the sweep, 20 Hz at full depth,
+        and the feedback sends the ring around again.
+    */
+    inline double getPhaserSeconds (int numAllpasses, float feedback) noexcept
+    {
+        constexpr double lowestFrequency = 20.0;
+        const auto timeConstant = (double) numAllpasses / (juce::MathConstants<double>::twoPi * lowestFrequency);
+
+        return timeConstant * (getDecayTimeConstants() + getFeedbackPasses (feedback));
+    }
+
+    /** One pass through the longest delay the lfo reaches, then one more per feedback pass. */
+    inline double getChorusSeconds (float centreDelayMs, float depth, double maxModulationMs, float feedback) noexcept
+    {
+        const auto longestDelay = ((double) centreDelayMs + maxModulationMs * (double) depth) / 1000.0;
+        return longestDelay * (1.0 + getFeedbackPasses (feedback));
+    }
+
+    /** A memoryless stage behind the oversampling filters, which ring for about twice their latency. */
+    inline double getOversampledSeconds (double latencySamples, double sampleRate) noexcept
+    {
+        return sampleRate > 0.0 ? 2.0 * latencySamples / sampleRate : 0.0;
+    }
+
+    /** The resonant pole decays with a time constant of 1 / (pi fc (1 - k)), k being
+        the feedback the resonance maps to. At k = 1 the ladder oscillates by itself.
+    */
+    inline double getLadderSeconds (float cutoffHz, float scaledResonance, double latencySamples, double sampleRate) noexcept
+    {
+        const auto damping = 1.0 - (double) scaledResonance;
+
+        if (damping <= 1.0e-3)
+            return std::numeric_limits<double>::infinity();
+
+        const auto timeConstant = 1.0 / (juce::MathConstants<double>::pi * juce::jmax (20.0, (double) cutoffHz) * damping);
+        return timeConstant * getDecayTimeConstants() + getOversampledSeconds (latencySamples, sampleRate);
+    }
+
+    /** A biquad's poles decay with a time constant of Q / (pi f), boosts start that much higher. */
+    inline double getBiquadSeconds (float frequencyHz, float quality, float gainDb) noexcept
+    {
+        const auto timeConstant = juce::jmax (0.5, (double) quality) / (juce::MathConstants<double>::pi * juce::jmax (20.0, (double) frequencyHz));
+        return timeConstant * getDecayTimeConstants (juce::Decibels::decibelsToGain ((double) gainDb));
+    }
+
+    /** The echo of the last input, then one echo per feedback pass, plus the glide of a time change. */
+    inline double getDelaySeconds (float delayMs, float feedback, double glideSeconds) noexcept
+    {
+        return (double) delayMs / 1000.0 * (1.0 + getFeedbackPasses (feedback)) + glideSeconds;
+    }
+}
@@ -0,0 +1,282 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyzer.h"
+
+namespace
+{
+    //how fast a bin falls back once the signal in it is gone, peaks show up right away
+    constexpr float decayDbPerSecond = 60.f;
+
+    const float gridFrequencies[] = { 50.f, 100.f, 200.f, 500.f, 1000.f, 2000.f, 5000.f, 10000.f };
+    const float gridLevels[] = { -72.f, -48.f, -24.f, 0.f };
+}
+
+//==============================================================================
+class SpectrumAnalyzer::AnalyzerThread  : public juce::Thread
+{
+public:
+    explicit AnalyzerThread (SpectrumAnalyzer& analyzerToFeed)
+        : juce::Thread ("multieffects spectrum"),
+          owner (analyzerToFeed)
+    {
+    }
+
+    void run() override
+    {
+        //everything that allocates is set up here, not on the message thread while the editor opens
+        juce::dsp::FFT fft (fftOrder);
+        juce::dsp::WindowingFunction<float> window ((size_t) fftSize, juce::dsp::WindowingFunction<float>::hann, false);
+        juce::AudioBuffer<float> pulled (AudioTap::maxChannels, AudioTap::capacity);
+
+        Spectrum pre, post;
+        juce::Path prePath, postPath;
+        int builtWidth = 0, builtHeight = 0;
+
+        constexpr int frameIntervalMs = 1000 / frameRateHz;
+        constexpr float decayPerFrame = decayDbPerSecond / (float) frameRateHz;
+
+        while (! threadShouldExit())
+        {
+            const auto frameStart = juce::Time::getMillisecondCounter();
+
+            //both taps every frame, so neither ring fills up while the other one is quiet
+            const auto preChanged = pre.update (owner.preTap, pulled, fft, window, decayPerFrame);
+            const auto postChanged = post.update (owner.postTap, pulled, fft, window, decayPerFrame);
+
+            const auto width = owner.pathWidth.load (std::memory_order_relaxed);
+            const auto height = owner.pathHeight.load (std::memory_order_relaxed);
+            const auto resized = width != builtWidth || height != builtHeight;
+
+            if ((preChanged || postChanged || resized) && width > 0 && height > 0)
+            {
+                pre.buildPath (prePath, owner.preTap.getSampleRate(), (float) width, (float) height);
+                post.buildPath (postPath, owner.postTap.getSampleRate(), (float) width, (float) height);
+
+                builtWidth = width;
+                builtHeight = height;
+
+                //the old ready paths come back and get cleared for the next frame, nothing is reallocated
+                const juce::SpinLock::ScopedLockType lock (owner.pathLock);
+                owner.readyPrePath.swapWithPath (prePath);
+                owner.readyPostPath.swapWithPath (postPath);
+                owner.pathsReady.store (true, std::memory_order_release);
+            }
+
+            const auto elapsed = (int) (juce::Time::getMillisecondCounter() - frameStart);
+            wait (juce::jmax (1, frameIntervalMs - elapsed));
+        }
+    }
+
+private:
+    //the history, the fft buffer and the smoothed levels of one tap
+    struct Spectrum
+    {
+        std::vector<float> history = std::vector<float> ((size_t) fftSize, 0.f);
+        std::vector<float> fftData = std::vector<float> ((size_t) fftSize * 2, 0.f);
+        std::vector<float> levels = std::vector<float> ((size_t) fftSize / 2 + 1, minDb);
+
+        //pulls what arrived since the last frame and runs the fft over the newest fftSize samples
+        bool update (AudioTap& tap, juce::AudioBuffer<float>& pulled, juce::dsp::FFT& fft,
+                     juce::dsp::WindowingFunction<float>& window, float decay)
+        {
+            const auto numNew = tap.pull (pulled);
+
+            if (numNew == 0)
+                return false;
+
+            append (pulled, numNew);
+
+            std::copy (history.begin(), history.end(), fftData.begin());
+            window.multiplyWithWindowingTable (fftData.data(), (size_t) fftSize);
+            fft.performFrequencyOnlyForwardTransform (fftData.data());
+
+            //one sided magnitude over the hann window's coherent gain of 0.5, so a full scale sine reads 0 dB
+            constexpr float scale = 4.f / (float) fftSize;
+
+            for (size_t bin = 0; bin < levels.size(); ++bin)
+            {
+                const auto db = juce::Decibels::gainToDecibels (fftData[bin] * scale, minDb);
+                levels[bin] = juce::jmax (db, levels[bin] - decay);
+            }
+
+            return true;
+        }
+
+        //the channels summed to mono, behind what's already there
+        void append (const juce::AudioBuffer<float>& pulled, int numNew)
+        {
+            const auto numKept = juce::jmax (0, fftSize - numNew);
+            const auto numCopied = fftSize - numKept;
+            const auto firstCopied = numNew - numCopied;
+
+            std::copy (history.end() - numKept, history.end(), history.begin());
+
+            auto* left = pulled.getReadPointer (0, firstCopied);
+            auto* right = pulled.getReadPointer (1, firstCopied);
+
+            for (int i = 0; i < numCopied; ++i)
+                history[(size_t) (numKept + i)] = 0.5f * (left[i] + right[i]);
+        }
+
+        //one point per pixel column, the loudest bin in it, so the top octaves don't draw thousands of lines
+        void buildPath (juce::Path& path, double sampleRate, float width, float height) const
+        {
+            path.clear();
+
+            const auto binWidth = (float) (sampleRate / fftSize);
+            auto column = -1;
+            auto columnX = 0.f, columnDb = minDb;
+
+            auto addPoint = [&path, height] (float x, float db)
+            {
+                const auto y = dbToY (db, height);
+
+                if (path.isEmpty())
+                    path.startNewSubPath (x, y);
+                else
+                    path.lineTo (x, y);
+            };
+
+            for (size_t bin = 1; bin < levels.size(); ++bin)
+            {
+                const auto frequency = (float) bin * binWidth;
+
+                if (frequency < minFrequency)
+                    continue;
+
+                if (frequency > maxFrequency)
+                    break;
+
+                const auto x = frequencyToX (frequency, width);
+
+                if ((int) x == column)
+                {
+                    columnDb = juce::jmax (columnDb, levels[bin]);
+                    continue;
+                }
+
+                if (column >= 0)
+                    addPoint (columnX, columnDb);
+
+                column = (int) x;
+                columnX = x;
+                columnDb = levels[bin];
+            }
+
+            if (column >= 0)
+                addPoint (columnX, columnDb);
+        }
+    };
+
+    SpectrumAnalyzer& owner;
+};
+
+//==============================================================================
+SpectrumAnalyzer::SpectrumAnalyzer (AudioTap& preChainTap, AudioTap& postChainTap)
+    : preTap (preChainTap),
+      postTap (postChainTap)
+{
+    setOpaque (true);
+
+    //whatever sat in the rings since the last editor closed is stale
+    preTap.drain();
+    postTap.drain();
+    preTap.setEnabled (true);
+    postTap.setEnabled (true);
+
+    analyzerThread = std::make_unique<AnalyzerThread> (*this);
+    analyzerThread->startThread (juce::Thread::Priority::low);
+
+    startTimerHz (frameRateHz);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer()
+{
+    stopTimer();
+    analyzerThread->stopThread (1000);
+
+    preTap.setEnabled (false);
+    postTap.setEnabled (false);
+}
+
+//==============================================================================
+void SpectrumAnalyzer::paint (juce::Graphics& g)
+{
+    g.fillAll (juce::Colours::black);
+
+    const auto width = (float) getWidth();
+    const auto height = (float) getHeight();
+
+    g.setFont (juce::FontOptions (11.0f));
+
+    for (auto frequency : gridFrequencies)
+    {
+        const auto x = frequencyToX (frequency, width);
+
+        g.setColour (juce::Colours::white.withAlpha (0.15f));
+        g.drawVerticalLine (juce::roundToInt (x), 0.f, height);
+
+        g.setColour (juce::Colours::white.withAlpha (0.5f));
+        const auto label = frequency >= 1000.f ? juce::String (frequency / 1000.f) + "k" : juce::String (frequency);
+        g.drawText (label, juce::Rectangle<float> (x + 2.f, height - 14.f, 40.f, 14.f), juce::Justification::centredLeft);
+    }
+
+    for (auto db : gridLevels)
+    {
+        const auto y = dbToY (db, height);
+
+        g.setColour (juce::Colours::white.withAlpha (0.15f));
+        g.drawHorizontalLine (juce::roundToInt (y), 0.f, width);
+
+        g.setColour (juce::Colours::white.withAlpha (0.5f));
+        g.drawText (juce::String (db) + " dB", juce::Rectangle<float> (2.f, y + 1.f, 50.f, 14.f), juce::Justification::centredLeft);
+    }
+
+    g.setColour (juce::Colours::grey);
+    g.strokePath (prePath, juce::PathStrokeType (1.f));
+
+    g.setColour (juce::Colours::orange);
+    g.strokePath (postPath, juce::PathStrokeType (1.5f));
+}
+
+void SpectrumAnalyzer::resized()
+{
+    //the analyzer thread builds the next frame at the new size
+    pathWidth.store (getWidth(), std::memory_order_relaxed);
+    pathHeight.store (getHeight(), std::memory_order_relaxed);
+}
+
+void SpectrumAnalyzer::timerCallback()
+{
+    if (! pathsReady.load (std::memory_order_acquire))
+        return;
+
+    //the analyzer thread is mid swap, there's another frame in a 30th of a second
+    const juce::SpinLock::ScopedTryLockType lock (pathLock);
+
+    if (! lock.isLocked())
+        return;
+
+    prePath.swapWithPath (readyPrePath);
+    postPath.swapWithPath (readyPostPath);
+    pathsReady.store (false, std::memory_order_relaxed);
+
+    repaint();
+}
+
+//==============================================================================
+float SpectrumAnalyzer::frequencyToX (float frequency, float width) noexcept
+{
+    return width * std::log (frequency / minFrequency) / std::log (maxFrequency / minFrequency);
+}
+
+float SpectrumAnalyzer::dbToY (float db, float height) noexcept
+{
+    return juce::jmap (juce::jlimit (minDb, maxDb, db), minDb, maxDb, height, 0.f);
+}
@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.h
+
+    Spectrum of the chain's input and output, analysed off the message thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../Utility/AudioTap.h"
+
+//==============================================================================
+/**
+    Draws the spectrum in front of the chain in grey and behind it in colour,
+    on a log frequency axis.
+
+    The audio thread's only part is the memcpy into the two AudioTaps. A
+    background thread pulls from them, runs the FFT, smooths the bins and
+    builds both curves as paths at the component's size. Finished paths are
+    swapped into a ready slot under a spin lock, and a timer on the message
+    thread, capped at frameRateHz, swaps them out with a try-lock and repaints.
+    paint() only strokes the cached paths, so a slow frame on either side is
+    skipped instead of waited for.
+
+    The taps are on while the analyzer exists.
+*/
+class SpectrumAnalyzer  : public juce::Component,
+                          private juce::Timer
+{
+public:
+    static constexpr int fftOrder = 12;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int frameRateHz = 30;
+
+    static constexpr float minFrequency = 20.f, maxFrequency = 20000.f;
+    static constexpr float minDb = -90.f, maxDb = 6.f;
+
+    SpectrumAnalyzer (AudioTap& preChainTap, AudioTap& postChainTap);
+    ~SpectrumAnalyzer() override;
+
+    //==============================================================================
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    class AnalyzerThread;
+
+    void timerCallback() override;
+
+    //x of a frequency and y of a level, for both the grid and the analyzer thread
+    static float frequencyToX (float frequency, float width) noexcept;
+    static float dbToY (float db, float height) noexcept;
+
+    AudioTap& preTap;
+    AudioTap& postTap;
+
+    //written by the analyzer thread, swapped out by the timer
+    juce::SpinLock pathLock;
+    juce::Path readyPrePath, readyPostPath;
+    std::atomic<bool> pathsReady { false };
+
+    //message thread only
+    juce::Path prePath, postPath;
+
+    //the size the analyzer thread builds the paths for
+    std::atomic<int> pathWidth { 0 }, pathHeight { 0 };
+
+    std::unique_ptr<AnalyzerThread> analyzerThread;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrumAnalyzer)
+};
@@ -9,17 +9,39 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+namespace
+{
+    //meters in the order of DSP_Option, the chain goes last
+    const char* const stageNames[] = { "Phaser", "Chorus", "Overdrive", "Ladder", "Filter", "Delay" };
+
+    static_assert (std::size (stageNames) == static_cast<size_t> (MultieffectsAudioProcessor::DSP_Option::END_OF_LIST));
+
+    constexpr float meterFloorDb = -60.f;
+    constexpr float meterCeilingDb = 6.f;
+}
+
 //==============================================================================
 MultieffectsAudioProcessorEditor::MultieffectsAudioProcessorEditor (MultieffectsAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p),
+      analyzer (p.getPreChainTap(), p.getPostChainTap()),
+      parameterEditor (p)
 {
+    addAndMakeVisible (analyzer);
+    addAndMakeVisible (parameterEditor);
+
+    //the audio thread only measures while an editor is looking
+    audioProcessor.getMeters().setEnabled (true);
+    startTimerHz (juce::roundToInt (StageMeters::publishRateHz));
+
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    setSize (860, 640);
 }
 
 MultieffectsAudioProcessorEditor::~MultieffectsAudioProcessorEditor()
 {
+    stopTimer();
+    audioProcessor.getMeters().setEnabled (false);
 }
 
 //==============================================================================
@@ -28,13 +50,67 @@ void MultieffectsAudioProcessorEditor::paint (juce::Graphics& g)
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
 
+    auto area = meterArea.toFloat();
+    const auto numRows = static_cast<int> (std::size (stageNames)) + 2;
+    const auto rowHeight = area.getHeight() / static_cast<float> (numRows);
+
     g.setColour (juce::Colours::white);
-    g.setFont (juce::FontOptions (15.0f));
-    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
+    g.setFont (juce::FontOptions (13.0f));
+
+    auto header = area.removeFromTop (rowHeight);
+    header.removeFromLeft (80.f);
+    g.drawText ("in", header.removeFromLeft (header.getWidth() / 2.f), juce::Justification::centred);
+    g.drawText ("out", header, juce::Justification::centred);
+
+    for (int row = 0; row < numRows - 1; ++row)
+    {
+        const auto isChain = row == numRows - 2;
+        const auto& reading = isChain ? meterSnapshot.chain : meterSnapshot.stages[(size_t) row];
+
+        auto rowArea = area.removeFromTop (rowHeight).reduced (0.f, 3.f);
+
+        g.setColour (juce::Colours::white);
+        g.drawText (isChain ? "Chain" : stageNames[row], rowArea.removeFromLeft (80.f), juce::Justification::centredLeft);
+
+        auto input = rowArea.removeFromLeft (rowArea.getWidth() / 2.f).reduced (4.f, 0.f);
+        paintMeter (g, input, reading.inputPeak, reading.inputRms);
+        paintMeter (g, rowArea.reduced (4.f, 0.f), reading.outputPeak, reading.outputRms);
+    }
+}
+
+void MultieffectsAudioProcessorEditor::paintMeter (juce::Graphics& g, juce::Rectangle<float> area, float peak, float rms) const
+{
+    auto toX = [area] (float gain)
+    {
+        const auto db = juce::Decibels::gainToDecibels (gain, meterFloorDb);
+        return juce::jmap (db, meterFloorDb, meterCeilingDb, area.getX(), area.getRight());
+    };
+
+    g.setColour (juce::Colours::black.withAlpha (0.4f));
+    g.fillRect (area);
+
+    g.setColour (juce::Colours::limegreen);
+    g.fillRect (area.withRight (toX (rms)));
+
+    //anything at or over full scale is the stage to look at
+    g.setColour (peak >= 1.f ? juce::Colours::red : juce::Colours::yellow);
+    g.fillRect (juce::Rectangle<float> (toX (peak) - 1.f, area.getY(), 2.f, area.getHeight()));
+
+    g.setColour (juce::Colours::white.withAlpha (0.5f));
+    g.fillRect (juce::Rectangle<float> (toX (1.f), area.getY(), 1.f, area.getHeight()));
 }
 
 void MultieffectsAudioProcessorEditor::resized()
 {
-    // This is generally where you'll want to lay out the positions of any
-    // subcomponents in your editor..
+    auto area = getLocalBounds();
+
+    analyzer.setBounds (area.removeFromTop (240).reduced (10));
+    meterArea = area.removeFromLeft (380).reduced (10);
+    parameterEditor.setBounds (area.reduced (10));
+}
+
+void MultieffectsAudioProcessorEditor::timerCallback()
+{
+    if (audioProcessor.getMeters().getLatest (meterSnapshot))
+        repaint();
 }
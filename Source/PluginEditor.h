@@ -10,11 +10,13 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "GUI/SpectrumAnalyzer.h"
 
 //==============================================================================
 /**
 */
-class MultieffectsAudioProcessorEditor  : public juce::AudioProcessorEditor
+class MultieffectsAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                          private juce::Timer
 {
 public:
     MultieffectsAudioProcessorEditor (MultieffectsAudioProcessor&);
@@ -25,9 +27,22 @@ public:
     void resized() override;
 
 private:
+    void timerCallback() override;
+
+    void paintMeter (juce::Graphics& g, juce::Rectangle<float> area, float peak, float rms) const;
+
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     MultieffectsAudioProcessor& audioProcessor;
 
+    SpectrumAnalyzer analyzer;
+    juce::GenericAudioProcessorEditor parameterEditor;
+
+    //where paint draws the meters, next to the parameters
+    juce::Rectangle<int> meterArea;
+
+    //the newest reading from the audio thread, held between readings
+    StageMeters::Snapshot meterSnapshot;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MultieffectsAudioProcessorEditor)
 };
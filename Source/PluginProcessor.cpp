@@ -14,12 +14,21 @@ auto getPhaserCenterFreqName() { return juce::String("Phaser Center Freq Hz"); }
 auto getPhaserDepthName() { return juce::String("Phaser Depth %"); }
 auto getPhaserFeedbackName() { return juce::String("Phaser Feedback %"); }
 auto getPhaserMixName() { return juce::String("Phaser mix %"); }
+auto getPhaserModulationName() { return juce::String("Phaser Modulation"); }
 
 auto getChorusRateName() { return juce::String("Chorus Rate Hz"); }
 auto getChorusDepthName() { return juce::String("Chorus Depth %"); }
 auto getChorusCenterDelayName() { return juce::String("Chorus Center delay Ms"); }
 auto getChorusFeedbackName() { return juce::String("Chorus Feedback %"); }
 auto getChorusMixName() { return juce::String("Chorus mix %"); }
+auto getChorusModulationName() { return juce::String("Chorus Modulation"); }
+
+auto getModulationChoices() {
+    return juce::StringArray{
+        "Linked",      //every channel on the same lfo
+        "Per Channel", //lfo phases spread evenly over the channels
+    };
+}
 
 auto getOverdriveSaturationName() { return juce::String("Overdrive Saturation");}
 
@@ -53,6 +62,60 @@ auto getGeneralFilterFreqName() { return juce::String("General Filter Freq Hz");
 auto getGeneralFilterQualityName() { return juce::String("Ladder Filter Quality"); }
 auto getGeneralFilterGainName() { return juce::String("Ladder Filter Gain"); }
 
+auto getOversamplingName() { return juce::String("Oversampling"); }
+auto getOversamplingFilterName() { return juce::String("Oversampling Filter"); }
+
+auto getOversamplingChoices() {
+    return juce::StringArray{
+        "Off",
+        "2x",
+        "4x",
+        "8x",
+    };
+}
+
+auto getOversamplingFilterChoices() {
+    return juce::StringArray{
+        "Linear Phase", //fir, latency is reported to the host
+        "Zero Latency", //iir, minimum phase
+    };
+}
+
+auto getSaturationAccuracyName() { return juce::String("Saturation Accuracy"); }
+
+auto getDelayTimeName() { return juce::String("Delay Time Ms"); }
+auto getDelayFeedbackName() { return juce::String("Delay Feedback %"); }
+auto getDelayMixName() { return juce::String("Delay mix %"); }
+auto getDelaySyncName() { return juce::String("Delay Sync"); }
+
+auto getDelaySyncChoices() {
+    return juce::StringArray{
+        "Off", //free running, uses the delay time
+        "1/1",
+        "1/2",
+        "1/4",
+        "1/8",
+        "1/16",
+        "1/4 Dotted",
+        "1/8 Dotted",
+        "1/4 Triplet",
+        "1/8 Triplet",
+    };
+}
+
+//length of each sync choice in quarter notes, same order as the choices
+auto getDelaySyncBeats() {
+    return std::array{ 0.f, 4.f, 2.f, 1.f, 0.5f, 0.25f, 1.5f, 0.75f, 2.f / 3.f, 1.f / 3.f };
+}
+
+auto getSaturationAccuracyChoices() {
+    return juce::StringArray{
+        "Exact",    //std::tanh
+        "Accurate", //[7/6] pade, ~1e-4 off
+        "Fast",     //[3/2] pade, ~2e-2 off
+    };
+}
+
 
 //==============================================================================
 MultieffectsAudioProcessor::MultieffectsAudioProcessor()
@@ -90,6 +153,9 @@ MultieffectsAudioProcessor::MultieffectsAudioProcessor()
         &generalFilterQuality,
         &generalFilterGain,
 
+        &delayTimeMs,
+        &delayFeedbackPercent,
+        &delayMixPercent,
 
     };
     auto floatNameFuncs = std::array{
@@ -115,6 +181,9 @@ MultieffectsAudioProcessor::MultieffectsAudioProcessor()
          &getGeneralFilterQualityName,
          &getGeneralFilterGainName,
 
+         &getDelayTimeName,
+         &getDelayFeedbackName,
+         &getDelayMixName,
     };
 
     for (size_t i = 0; i < floatParams.size(); ++i) {
@@ -127,13 +196,25 @@ MultieffectsAudioProcessor::MultieffectsAudioProcessor()
 
     auto choiceParams = std::array{
 
+        &phaserModulation,
+        &chorusModulation,
         &ladderFilterMode,
         &generalFilterMode,
+        &oversampling,
+        &oversamplingFilter,
+        &saturationAccuracy,
+        &delaySync,
     };
 
     auto choiceNameFuncs = std::array{
+        &getPhaserModulationName,
+        &getChorusModulationName,
         &getLadderFilterModeName,
         &getGeneralFilterModeName,
+        &getOversamplingName,
+        &getOversamplingFilterName,
+        &getSaturationAccuracyName,
+        &getDelaySyncName,
 
     };
 
@@ -144,11 +225,27 @@ MultieffectsAudioProcessor::MultieffectsAudioProcessor()
         jassert(*ptrToParamPtr != nullptr);
 
     }
+
+    //every slot starts on the defaults
+    const auto& parameters = getParameters();
+    jassert(parameters.size() <= BinaryPreset::maxParameters);
+
+    for (auto& values : slotValues) {
+        for (size_t i = 0; i < values.size(); ++i) {
+            const auto index = static_cast<int>(i);
+            values[i].store(index < parameters.size() ? parameters.getUnchecked(index)->getDefaultValue() : 0.f);
+        }
+    }
+
+    pullHostParameters(true);
+    updateRouting();
+    startTimerHz(hostUpdateRateHz);
 }
     
 
     MultieffectsAudioProcessor::~MultieffectsAudioProcessor()
     {
+        stopTimer();
     }
 
 //==============================================================================
@@ -186,7 +283,8 @@ bool MultieffectsAudioProcessor::isMidiEffect() const
 
 double MultieffectsAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    //infinite while the ladder self oscillates or a feedback is at full
+    return tailLengthSeconds.load();
 }
 
 int MultieffectsAudioProcessor::getNumPrograms()
@@ -219,7 +317,7 @@ void MultieffectsAudioProcessor::prepareToPlay(double sampleRate, int samplesPer
     juce::dsp::ProcessSpec spec;
     spec.sampleRate = sampleRate;
     spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels = getTotalNumInputChannels();
+    spec.numChannels = juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels());
 
     std::vector<juce::dsp::ProcessorBase*> dsp{
         &phaser,
@@ -227,6 +325,8 @@ void MultieffectsAudioProcessor::prepareToPlay(double sampleRate, int samplesPer
         &overdrive,
         &ladderFilter,
         &generalFilter,
+        &rampedGeneralFilter,
+        &delay,
     };
      
     for (auto p : dsp) {
@@ -236,7 +336,89 @@ void MultieffectsAudioProcessor::prepareToPlay(double sampleRate, int samplesPer
 
     }
 
+    //the stage pool only grows or shrinks here, so no chain ever allocates on the audio thread
+    numInstances = static_cast<size_t>(juce::jlimit(1, static_cast<int>(maxSlots), stagePoolSize.load()));
+
+    resizeInstances(stagePool.phasers, numInstances - 1, spec);
+    resizeInstances(stagePool.choruses, numInstances - 1, spec);
+    resizeInstances(stagePool.overdrives, numInstances - 1, spec);
+    resizeInstances(stagePool.ladderFilters, numInstances - 1, spec);
+    resizeInstances(stagePool.generalFilters, numInstances - 1, spec);
+    resizeInstances(stagePool.rampedGeneralFilters, numInstances - 1, spec);
+    resizeInstances(stagePool.delays, numInstances - 1, spec);
+
+    //forces the first block to push every parameter, from where the parameters are now
+    paramWatchers = ParamWatchers();
+    pullHostParameters(true);
+
+    //the multiplicative ramps can't start from 0, so they start on the parameters
+    auto& s = controlSmoothers;
+    s.ladderCutoff.reset(sampleRate, controlSmoothingSeconds);
+    s.filterFreq.reset(sampleRate, controlSmoothingSeconds);
+    s.filterQuality.reset(sampleRate, controlSmoothingSeconds);
+    s.filterGain.reset(sampleRate, controlSmoothingSeconds);
+
+    startControlSmoothers(s, getHostSource());
+    snapControlSmoothers = true;
+    rampingCoefficients = coefficientRamping.load();
+    parameterEvents.clear();
+
+    //the slots start over too, updateRouting pushes everything again and starts their smoothers
+    for (auto& state : slotStates) {
+        state.option = DSP_Option::END_OF_LIST;
+        state.smoothers.ladderCutoff.reset(sampleRate, controlSmoothingSeconds);
+        state.smoothers.filterFreq.reset(sampleRate, controlSmoothingSeconds);
+        state.smoothers.filterQuality.reset(sampleRate, controlSmoothingSeconds);
+        state.smoothers.filterGain.reset(sampleRate, controlSmoothingSeconds);
+    }
+
+    updateRouting();
+
+    //every stage starts on the parameters, it would glide there from its defaults in the first
+    //block otherwise and the start of a render would depend on them
+    updateDSPFromParams();
+    snapControlSmoothers = true;
+    updateControlRate(0);
+
+    for (size_t instance = 0; instance < numInstances; ++instance) {
+        getInstance(phaser, stagePool.phasers, instance).reset();
+        getInstance(chorus, stagePool.choruses, instance).reset();
+        getInstance(overdrive, stagePool.overdrives, instance).reset();
+        getInstance(ladderFilter, stagePool.ladderFilters, instance).reset();
+        getInstance(generalFilter, stagePool.generalFilters, instance).reset();
+        getInstance(rampedGeneralFilter, stagePool.rampedGeneralFilters, instance).reset();
+        getInstance(delay, stagePool.delays, instance).reset();
+    }
 
+    //room for every branch but the first, so a parallel group never allocates
+    const auto numChannels = juce::jmax(getTotalNumInputChannels(), getTotalNumOutputChannels());
+    branchBuffer.setSize(numChannels * static_cast<int>(maxBranches - 1), samplesPerBlock);
+
+    //one worker per extra branch, the audio thread runs the first branch itself. groups wider
+    //than one branch per option are rare, the audio thread runs what the workers don't take
+    const auto numWorkers = parallelProcessing.load()
+        ? juce::jmin(static_cast<int>(numOptions) - 1, juce::SystemStats::getNumCpus() - 1)
+        : 0;
+
+    if (numWorkers <= 0)
+        workerPool.reset();
+    else if (workerPool == nullptr || workerPool->getNumWorkers() != numWorkers)
+        workerPool = std::make_unique<RealtimeWorkerPool>(numWorkers);
+
+    profiler.prepare(sampleRate);
+    meters.prepare(sampleRate);
+    preChainTap.prepare(sampleRate);
+    postChainTap.prepare(sampleRate);
+
+    //the host reads the latency right after prepareToPlay, so don't wait for the first block
+    const auto host = getHostSource();
+    updateOversampling(host.getIndex(*oversampling), host.getIndex(*oversamplingFilter));
+    reportLatency();
+
+    //and the tail, which needs the latency
+    silentSamples = 0;
+    stageAsleep.fill(false);
+    updateTails(false);
 }
 
 void MultieffectsAudioProcessor::releaseResources()
@@ -252,12 +434,11 @@ bool MultieffectsAudioProcessor::isBusesLayoutSupported (const BusesLayout& layo
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    //every stage packs the channels into simd lanes and doesn't care what they are, so mono and
+    //stereo up to surround, 7.1.4 and 3rd order ambisonics all work, as long as it's at most maxChannels
+    const auto& output = layouts.getMainOutputChannelSet();
+
+    if (output.isDisabled() || output.size() > maxChannels)
         return false;
 
     // This checks if the input layout matches the output layout
@@ -285,6 +466,10 @@ juce::AudioProcessorValueTreeState::ParameterLayout MultieffectsAudioProcessor::
 
     const int versionHint = 1;
 
+    //everything added since the first release goes at the end with this hint, so the first
+    //parameters keep their indices in host sessions, automation and binary presets
+    const int addedVersionHint = 2;
+
     auto name = getPhaserRateName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ name, versionHint },
@@ -479,6 +664,103 @@ juce::AudioProcessorValueTreeState::ParameterLayout MultieffectsAudioProcessor::
         0.f,
         "dB"
     ));
+
+    /*oversampling, only around the overdrive and ladder stages
+    factor: off, 2x, 4x, 8x
+    filter: linear phase fir or zero latency iir*/
+
+    name = getOversamplingName();
+    choices = getOversamplingChoices();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ name, addedVersionHint },
+        name,
+        choices,
+        0
+    ));
+
+    name = getOversamplingFilterName();
+    choices = getOversamplingFilterChoices();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ name, addedVersionHint },
+        name,
+        choices,
+        0
+    ));
+
+    /*saturation accuracy, which tanh the overdrive and ladder use
+    exact, accurate or fast*/
+
+    name = getSaturationAccuracyName();
+    choices = getSaturationAccuracyChoices();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ name, addedVersionHint },
+        name,
+        choices,
+        1
+    ));
+
+    /*delay
+    time ms 1 to 4000, ignored while synced
+    feedback 0 to 0.95
+    mix 0 to 1
+    sync: off or a note length at the host tempo*/
+
+    name = getDelayTimeName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name, addedVersionHint },
+        name,
+        juce::NormalisableRange<float>(1.f, static_cast<float>(FeedbackDelay::maxDelaySeconds * 1000.0), 0.1f, 0.4f),
+        250.f,
+        "ms"
+    ));
+
+    name = getDelayFeedbackName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name, addedVersionHint },
+        name,
+        juce::NormalisableRange<float>(0.f, 0.95f, 0.01f, 1.f),
+        0.3f,
+        "%"
+    ));
+
+    name = getDelayMixName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name, addedVersionHint },
+        name,
+        juce::NormalisableRange<float>(0.f, 1.f, 0.01f, 1.f),
+        0.05f,
+        "%"
+    ));
+
+    name = getDelaySyncName();
+    choices = getDelaySyncChoices();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ name, addedVersionHint },
+        name,
+        choices,
+        0
+    ));
+
+    /*modulation of the phaser's and the chorus' lfos
+    linked or per channel*/
+
+    name = getPhaserModulationName();
+    choices = getModulationChoices();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ name, addedVersionHint },
+        name,
+        choices,
+        0
+    ));
+
+    name = getChorusModulationName();
+    choices = getModulationChoices();
+    layout.add(std::make_unique<juce::AudioParameterChoice>(
+        juce::ParameterID{ name, addedVersionHint },
+        name,
+        choices,
+        0
+    ));
     
 
     return layout;
@@ -487,6 +769,14 @@ juce::AudioProcessorValueTreeState::ParameterLayout MultieffectsAudioProcessor::
 void MultieffectsAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+
+    //with MULTIEFFECTS_ENABLE_RT_CHECKS anything in here that allocates, locks or blocks is reported
+    const RealtimeSafety::ScopedRealtime realtimeScope;
+
+    //one relaxed load when the profiler is off, the stages only time themselves while this is set
+    profiling = profiler.beginBlock();
+    metering = meters.beginBlock();
+
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -502,64 +792,71 @@ void MultieffectsAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     //TODO
     //add apvts-DONE
     // create all dsp choices-DONE
-    //update dsp here from audio params 
+    //update dsp here from audio params -DONE
     //save/load settings
     // save/load dsp order
     //drag to reorder gui
     //gui design for each
-    //metering
+    //metering-DONE
     //prepare all dsp--DONE
     //stereo 
     //video has more as bonuses, maybe later POST
 
+    //synced delay times follow the host tempo
+    if (auto* playHead = getPlayHead())
+        if (auto position = playHead->getPosition())
+            if (auto bpm = position->getBpm())
+                hostBpm.store(*bpm);
 
-    auto newDSPOrder = DSP_Order();
+    //host automation first, a queued preset that arrives with it is newer
+    pullHostParameters(false);
+    pullDSPRouting();
+    clearIdleDelayLines();
 
-    //trying to pull
-    while (dspOrderFifo.pull(newDSPOrder)) {
+    updateDSPFromParams();
+    updateCoefficientRamping();
 
-    }
+    //a silent input puts every stage to sleep whose tail has died out, the stages after it
+    //still ring with what came out of it before
+    const auto inputSilent = tailSkipping.load(std::memory_order_relaxed) && isSilent(buffer);
+    updateTails(inputSilent);
 
-        //if pulled, replace dsp order
-    if (newDSPOrder != DSP_Order()) 
-        dspOrder = newDSPOrder;
+    const auto silentSeconds = static_cast<double>(silentSamples) / getSampleRate();
 
-    //connverts dspOrder into an array of pointers
-    DSP_Pointers dspPointers;
-    
-    for (size_t i = 0; i < dspPointers.size(); ++i) {
-        switch (dspOrder[i])
-        {
-        case DSP_Option::Phase:
-            dspPointers[i] = &phaser;
-            break;
-        case DSP_Option::Chorus:
-            dspPointers[i] = &chorus;
-            break;
-        case DSP_Option::Overdrive:
-            dspPointers[i] = &overdrive;
-            break;
-        case DSP_Option::LadderFilter:
-            dspPointers[i] = &ladderFilter;
-            break;
-        case DSP_Option::GeneralFilter:
-            dspPointers[i] = &generalFilter;
-            break;
-        case DSP_Option::END_OF_LIST:
-            jassertfalse;
-                break;
+    for (size_t i = 0; i < stageAsleep.size(); ++i)
+        stageAsleep[i] = inputSilent && silentSeconds >= stageSleepAfter[i];
 
-        }
-    }
+    const auto chainAsleep = inputSilent && silentSeconds >= chainSleepAfter;
+    silentSamples = inputSilent ? silentSamples + buffer.getNumSamples() : 0;
+
+    preChainTap.push(buffer);
 
         //processing(making a block and a context to be manipulated)
         auto block = juce::dsp::AudioBlock<float>(buffer);
-        auto context = juce::dsp::ProcessContextReplacing<float>(block);
-        for (size_t i = 0; i < dspPointers.size(); ++i) {
-            if (dspPointers[i] != nullptr) {
-                dspPointers[i]->process(context);
-             }
+        const auto tile = static_cast<size_t>(getEffectiveTileSize(static_cast<int>(block.getNumChannels())));
+
+        if (chainAsleep) {
+            //every tail has died out, what's left is below the threshold. the parameters still
+            //move, so the chain wakes up where the automation is
+            buffer.clear();
+
+            if (applyParameterEvents(0, std::numeric_limits<int>::max()) > 0)
+                updateDSPFromParams();
+
+            updateControlRate(buffer.getNumSamples());
         }
+        else {
+            processControlBlocks(block, tile);
+        }
+
+        parameterEvents.clear();
+        postChainTap.push(buffer);
+
+        if (metering)
+            meters.endBlock(buffer.getNumSamples());
+
+        if (profiling)
+            profiler.endBlock(buffer.getNumSamples());
 
     }
 
@@ -578,37 +875,1431 @@ void MultieffectsAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
 //    }
 //}           FIX MAYBE
 
-//==============================================================================
-bool MultieffectsAudioProcessor::hasEditor() const
+void MultieffectsAudioProcessor::processControlBlocks(juce::dsp::AudioBlock<float>& block, size_t tile)
 {
-    return true; // (change this to false if you choose to not supply an editor)
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+    const auto control = controlBlockSize.load(std::memory_order_relaxed);
+
+    auto start = 0;
+    auto nextEvent = 0;
+
+    while (start < numSamples) {
+        //events land at the start of the control block they're in
+        const auto firstEvent = nextEvent;
+        nextEvent = applyParameterEvents(nextEvent, start);
+
+        if (nextEvent != firstEvent)
+            updateDSPFromParams();
+
+        //a control block ends at the next control boundary, tile boundary or event, whichever comes first.
+        //the whole chain runs on it while it's still in cache, the stages keep their state between
+        //calls so this sounds the same as one big block
+        auto end = numSamples;
+
+        if (control > 0)
+            end = juce::jmin(end, start + control);
+
+        if (tile > 0)
+            end = juce::jmin(end, start + static_cast<int>(tile));
+
+        if (nextEvent < parameterEvents.size())
+            end = juce::jmin(end, parameterEvents[nextEvent].sampleOffset);
+
+        updateControlRate(end - start);
+
+        auto subBlock = block.getSubBlock(static_cast<size_t>(start), static_cast<size_t>(end - start));
+        runChain(juce::dsp::ProcessContextReplacing<float>(subBlock));
+
+        start = end;
+    }
+
+    //events at or past the end of the block hold from the next one, the same as when the chain
+    //is asleep, instead of being dropped with the rest
+    if (applyParameterEvents(nextEvent, std::numeric_limits<int>::max()) != nextEvent)
+        updateDSPFromParams();
 }
 
-juce::AudioProcessorEditor* MultieffectsAudioProcessor::createEditor()
+int MultieffectsAudioProcessor::applyParameterEvents(int firstEvent, int offset)
 {
-    return new juce::GenericAudioProcessorEditor (*this);
+    const auto& parameters = getParameters();
+    auto index = firstEvent;
+
+    const auto numParameters = juce::jmin(parameters.size(), BinaryPreset::maxParameters);
+
+    for (; index < parameterEvents.size() && parameterEvents[index].sampleOffset <= offset; ++index) {
+        const auto& event = parameterEvents[index];
+
+        //straight to the smoothers through updateDSPFromParams, the apvts follows in updateHost
+        if (juce::isPositiveAndBelow(event.parameterIndex, numParameters))
+            setHostValue(static_cast<size_t>(event.parameterIndex), event.value);
+    }
+
+    return index;
 }
 
-//==============================================================================
-void MultieffectsAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+void MultieffectsAudioProcessor::updateControlRate(int numSamples)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    const auto filterMode = getHostSource().getIndex(*generalFilterMode);
 
-    juce::MemoryOutputStream mos(destData, false);
-    apvts.state.writeToStream(mos);
+    updateSmoothedControls(DSP_Option::LadderFilter, 0, controlSmoothers, snapControlSmoothers, filterMode, numSamples);
+    updateSmoothedControls(DSP_Option::GeneralFilter, 0, controlSmoothers, snapControlSmoothers, filterMode, numSamples);
+    snapControlSmoothers = false;
+
+    //the filters past the first of their option glide on their own smoothers
+    for (size_t slot = 0; slot < dspChain.numSlots; ++slot) {
+        auto& state = slotStates[slot];
 
+        if (! isPoolSlot(slot) || (state.option != DSP_Option::LadderFilter && state.option != DSP_Option::GeneralFilter))
+            continue;
+
+        updateSmoothedControls(state.option, state.instance, state.smoothers, state.snapSmoothers,
+                               getParameterSource(slot).getIndex(*generalFilterMode), numSamples);
+        state.snapSmoothers = false;
+    }
 }
 
-void MultieffectsAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+void MultieffectsAudioProcessor::updateSmoothedControls(DSP_Option option, size_t instance, ControlSmoothers& s,
+                                                        bool snap, int filterMode, int numSamples)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    //the value the ramp reaches at the end of the control block, so a ramp is done when it says so.
+    //ramping, the filters move there over the control block instead of jumping at its start
+    const auto rampLength = rampingCoefficients && ! snap ? numSamples : 0;
+
+    if (option == DSP_Option::LadderFilter) {
+        if (snap)
+            s.ladderCutoff.setCurrentAndTargetValue(s.ladderCutoff.getTargetValue());
+
+        if (snap || s.ladderCutoff.isSmoothing()) {
+            auto& ladder = getInstance(ladderFilter, stagePool.ladderFilters, instance).dsp;
+            const auto cutoff = s.ladderCutoff.skip(numSamples);
+
+            //the ladder counts its ramp at the oversampled rate
+            if (rampingCoefficients)
+                ladder.get().setCutoffFrequencyHz(cutoff, rampLength * ladder.getFactor());
+            else
+                ladder.get().setCutoffFrequencyHz(cutoff);
+        }
+    }
+    else if (option == DSP_Option::GeneralFilter) {
+        if (snap) {
+            s.filterFreq.setCurrentAndTargetValue(s.filterFreq.getTargetValue());
+            s.filterQuality.setCurrentAndTargetValue(s.filterQuality.getTargetValue());
+            s.filterGain.setCurrentAndTargetValue(s.filterGain.getTargetValue());
+        }
 
-    auto tree= juce::ValueTree::readFromData(data, sizeInBytes);
-    if (tree.isValid()) {
-        apvts.replaceState(tree);
+        //at most one coefficient update per control block, and none once the ramps are over
+        const auto filterSmoothing = s.filterFreq.isSmoothing() || s.filterQuality.isSmoothing() || s.filterGain.isSmoothing();
+
+        if (snap || filterSmoothing) {
+            s.filterFreq.skip(numSamples);
+            s.filterQuality.skip(numSamples);
+            s.filterGain.skip(numSamples);
+            updateGeneralFilterCoefficients(instance, s, filterMode, rampLength);
+        }
+    }
+}
+
+bool MultieffectsAudioProcessor::addParameterEvent(int sampleOffset, int parameterIndex, float normalisedValue)
+{
+    jassert(juce::isPositiveAndBelow(parameterIndex, getParameters().size()));
+    return parameterEvents.add(juce::jmax(0, sampleOffset), parameterIndex, juce::jlimit(0.f, 1.f, normalisedValue));
+}
+
+void MultieffectsAudioProcessor::setControlBlockSize(int numSamples)
+{
+    jassert(numSamples >= 0);
+    controlBlockSize.store(juce::jmax(0, numSamples));
+}
+
+void MultieffectsAudioProcessor::pullDSPRouting()
+{
+    //the mailboxes only hold the latest push, so there's nothing to drain. the routing set last
+    //wins, whichever mailbox it came through and whichever block it arrives in
+    auto routingChanged = false;
+    auto chainUpdate = ChainUpdate();
+
+    if (dspChainMailbox.pull(chainUpdate) && chainUpdate.sequence > routingSequence) {
+        dspChain = chainUpdate.chain;
+        routingSequence = chainUpdate.sequence;
+        routingChanged = true;
+    }
+
+    //a queued preset lands as one snapshot, updateDSPFromParams picks up its parameters
+    if (presetMailbox.hasNewValue()) {
+        presetMailbox.pull(queuedPreset);
+
+        const auto& preset = queuedPreset.preset;
+        applyPresetHostValues(preset);
+        applyPresetSlotParameters(preset);
+
+        if (queuedPreset.routingSequence > routingSequence && getRouting(preset, dspChain)) {
+            routingSequence = queuedPreset.routingSequence;
+            routingChanged = true;
+        }
+    }
+
+    //if pulled, pick the chain function and stage calls for the new order
+    if (routingChanged)
+        updateRouting();
+}
+
+bool MultieffectsAudioProcessor::prepareSerialStages(std::vector<juce::dsp::ProcessorBase*>& stages)
+{
+    pullHostParameters(false);
+    pullDSPRouting();
+    updateDSPFromParams();
+    updateCoefficientRamping();
+
+    //the stages run on their own from here, so the filters start on their targets
+    snapControlSmoothers = true;
+    updateControlRate(0);
+
+    stages.clear();
+
+    if (numRoutingGroups != dspChain.numSlots || tailSkipping.load())
+        return false;
+
+    for (size_t slot = 0; slot < dspChain.numSlots; ++slot) {
+        if (auto* stage = getStage(dspChain.options[slot], slotInstances[slot]))
+            stages.push_back(stage);
+    }
+
+    return true;
+}
+
+void MultieffectsAudioProcessor::updateDSPFromParams()
+{
+    auto& w = paramWatchers;
+    const auto host = getHostSource();
+
+    for (auto option : { DSP_Option::Phase, DSP_Option::Chorus, DSP_Option::Overdrive,
+                         DSP_Option::LadderFilter, DSP_Option::GeneralFilter })
+        updateStageFromParams(option, 0, w, controlSmoothers, host);
+
+    //oversampling
+    auto oversamplingChanged = w.oversampling.hasChanged(static_cast<float>(host.getIndex(*oversampling)));
+    oversamplingChanged = w.oversamplingFilter.hasChanged(static_cast<float>(host.getIndex(*oversamplingFilter))) || oversamplingChanged;
+
+    if (oversamplingChanged)
+        updateOversampling(host.getIndex(*oversampling), host.getIndex(*oversamplingFilter));
+
+    updateStageFromParams(DSP_Option::Delay, 0, w, controlSmoothers, host);
+
+    //lfo control interval, shared by the phaser and chorus
+    if (w.modulationInterval.hasChanged(static_cast<float>(modulationInterval.load(std::memory_order_relaxed))))
+    {
+        const auto interval = static_cast<int>(w.modulationInterval.lastValue);
+
+        for (size_t instance = 0; instance < numInstances; ++instance) {
+            getInstance(phaser, stagePool.phasers, instance).dsp.setControlInterval(interval);
+            getInstance(chorus, stagePool.choruses, instance).dsp.setControlInterval(interval);
+        }
+    }
+
+    //saturation accuracy
+    if (w.saturationAccuracy.hasChanged(static_cast<float>(host.getIndex(*saturationAccuracy))))
+    {
+        const auto accuracy = static_cast<SIMDHelpers::TanhAccuracy>(host.getIndex(*saturationAccuracy));
+
+        for (size_t instance = 0; instance < numInstances; ++instance) {
+            getInstance(overdrive, stagePool.overdrives, instance).dsp.get().setTanhAccuracy(accuracy);
+            getInstance(ladderFilter, stagePool.ladderFilters, instance).dsp.get().setTanhAccuracy(accuracy);
+        }
+    }
+
+    //the slots past the first of their option, from their own values
+    for (size_t slot = 0; slot < dspChain.numSlots; ++slot) {
+        if (! isPoolSlot(slot))
+            continue;
+
+        auto& state = slotStates[slot];
+        updateStageFromParams(state.option, state.instance, state.watchers, state.smoothers, getParameterSource(slot));
+    }
+}
+
+void MultieffectsAudioProcessor::updateStageFromParams(DSP_Option option, size_t instance, ParamWatchers& w,
+                                                       ControlSmoothers& smoothers, const ParameterSource& source)
+{
+    switch (option)
+    {
+    case DSP_Option::Phase: {
+        auto& dsp = getInstance(phaser, stagePool.phasers, instance).dsp;
+
+        if (w.phaserRate.hasChanged(source.get(*phaserRateHz)))
+            dsp.setRate(w.phaserRate.lastValue);
+
+        if (w.phaserCenterFreq.hasChanged(source.get(*phaserCenterFreqHz)))
+            dsp.setCentreFrequency(w.phaserCenterFreq.lastValue);
+
+        if (w.phaserDepth.hasChanged(source.get(*phaserDepthPercent)))
+            dsp.setDepth(w.phaserDepth.lastValue);
+
+        if (w.phaserFeedback.hasChanged(source.get(*phaserFeedbackPercent)))
+            dsp.setFeedback(w.phaserFeedback.lastValue);
+
+        if (w.phaserMix.hasChanged(source.get(*phaserMixPercent)))
+            dsp.setMix(w.phaserMix.lastValue);
+
+        if (w.phaserModulation.hasChanged(static_cast<float>(source.getIndex(*phaserModulation))))
+            dsp.setModulation(static_cast<ControlRateLFO::Modulation>(source.getIndex(*phaserModulation)));
+
+        break;
+    }
+    case DSP_Option::Chorus: {
+        auto& dsp = getInstance(chorus, stagePool.choruses, instance).dsp;
+
+        //rate and centre delay must stay below 100
+        if (w.chorusRate.hasChanged(source.get(*chorusRateHz)))
+            dsp.setRate(juce::jmin(w.chorusRate.lastValue, 99.99f));
+
+        if (w.chorusDepth.hasChanged(source.get(*chorusDepthPercent)))
+            dsp.setDepth(w.chorusDepth.lastValue);
+
+        if (w.chorusCenterDelay.hasChanged(source.get(*chorusCenterDelayMs)))
+            dsp.setCentreDelay(juce::jmin(w.chorusCenterDelay.lastValue, 99.9f));
+
+        if (w.chorusFeedback.hasChanged(source.get(*chorusFeedbackPercent)))
+            dsp.setFeedback(w.chorusFeedback.lastValue);
+
+        if (w.chorusMix.hasChanged(source.get(*chorusMixPercent)))
+            dsp.setMix(w.chorusMix.lastValue);
+
+        if (w.chorusModulation.hasChanged(static_cast<float>(source.getIndex(*chorusModulation))))
+            dsp.setModulation(static_cast<ControlRateLFO::Modulation>(source.getIndex(*chorusModulation)));
+
+        break;
+    }
+    case DSP_Option::Overdrive:
+        if (w.overdriveSaturation.hasChanged(source.get(*overdriveSaturation)))
+            getInstance(overdrive, stagePool.overdrives, instance).dsp.get().setDrive(w.overdriveSaturation.lastValue);
+
+        break;
+    case DSP_Option::LadderFilter: {
+        auto& dsp = getInstance(ladderFilter, stagePool.ladderFilters, instance).dsp.get();
+
+        if (w.ladderMode.hasChanged(static_cast<float>(source.getIndex(*ladderFilterMode))))
+            dsp.setMode(static_cast<juce::dsp::LadderFilterMode>(source.getIndex(*ladderFilterMode)));
+
+        //cutoff, frequency, Q and gain glide there at control rate, see updateControlRate
+        if (w.ladderCutoff.hasChanged(source.get(*ladderFilterCutoffHz)))
+            smoothers.ladderCutoff.setTargetValue(w.ladderCutoff.lastValue);
+
+        if (w.ladderResonance.hasChanged(source.get(*ladderFilterResonance)))
+            dsp.setResonance(w.ladderResonance.lastValue);
+
+        if (w.ladderDrive.hasChanged(source.get(*ladderFilterDrive)))
+            dsp.setDrive(w.ladderDrive.lastValue);
+
+        break;
+    }
+    case DSP_Option::GeneralFilter:
+        //a new mode can't glide so it changes the coefficients right away
+        if (w.filterFreq.hasChanged(source.get(*generalFilterFreqHz)))
+            smoothers.filterFreq.setTargetValue(w.filterFreq.lastValue);
+
+        if (w.filterQuality.hasChanged(source.get(*generalFilterQuality)))
+            smoothers.filterQuality.setTargetValue(w.filterQuality.lastValue);
+
+        if (w.filterGain.hasChanged(source.get(*generalFilterGain)))
+            smoothers.filterGain.setTargetValue(w.filterGain.lastValue);
+
+        if (w.filterMode.hasChanged(static_cast<float>(source.getIndex(*generalFilterMode))))
+            updateGeneralFilterCoefficients(instance, smoothers, static_cast<int>(w.filterMode.lastValue));
+
+        break;
+    case DSP_Option::Delay: {
+        auto& dsp = getInstance(delay, stagePool.delays, instance).dsp;
+
+        //the time also changes with the sync choice and the host tempo
+        if (w.delayTime.hasChanged(getDelayTimeMs(source)))
+            dsp.setDelayTime(w.delayTime.lastValue);
+
+        if (w.delayFeedback.hasChanged(source.get(*delayFeedbackPercent)))
+            dsp.setFeedback(w.delayFeedback.lastValue);
+
+        if (w.delayMix.hasChanged(source.get(*delayMixPercent)))
+            dsp.setMix(w.delayMix.lastValue);
+
+        break;
+    }
+    case DSP_Option::END_OF_LIST:
+        jassertfalse;
+        break;
+    }
+}
+
+void MultieffectsAudioProcessor::updateOversampling(int factorIndex, int filterIndex)
+{
+    //only picks preallocated oversamplers and retunes the ladder, safe on the audio thread
+    const auto filter = static_cast<OversamplingFilter>(filterIndex);
+
+    for (size_t instance = 0; instance < numInstances; ++instance) {
+        getInstance(overdrive, stagePool.overdrives, instance).dsp.setOversampling(factorIndex, filter);
+        getInstance(ladderFilter, stagePool.ladderFilters, instance).dsp.setOversampling(factorIndex, filter);
+    }
+
+    updateLatency();
+}
+
+void MultieffectsAudioProcessor::updateLatency()
+{
+    //every instance runs the same oversampling, so a slot adds the latency of its option
+    auto totalLatency = 0.0;
+
+    for (size_t slot = 0; slot < dspChain.numSlots; ++slot) {
+        if (slotInstances[slot] >= numInstances)
+            continue;
+
+        if (dspChain.options[slot] == DSP_Option::Overdrive)
+            totalLatency += overdrive.dsp.getLatencyInSamples();
+        else if (dspChain.options[slot] == DSP_Option::LadderFilter)
+            totalLatency += ladderFilter.dsp.getLatencyInSamples();
+    }
+
+    chainLatencySamples.store(juce::roundToInt(totalLatency), std::memory_order_relaxed);
+}
+
+void MultieffectsAudioProcessor::reportLatency()
+{
+    //setLatencySamples tells the host through the processor's listeners, only when it changed
+    const auto newLatency = chainLatencySamples.load(std::memory_order_relaxed);
+
+    if (newLatency != getLatencySamples())
+        setLatencySamples(newLatency);
+}
+
+void MultieffectsAudioProcessor::updateHost()
+{
+    //what the audio thread played from queued presets, so the parameters and the host show it too
+    const auto& parameters = getParameters();
+
+    for (int i = 0; i < juce::jmin(parameters.size(), BinaryPreset::maxParameters); ++i) {
+        auto& pending = pendingHostValues[static_cast<size_t>(i)];
+        auto value = pending.load(std::memory_order_relaxed);
+
+        if (std::isnan(value))
+            continue;
+
+        auto* param = parameters.getUnchecked(i);
+
+        if (param->getValue() != value)
+            param->setValueNotifyingHost(value);
+
+        //only once the parameter has it, or the audio thread would pull the old one back in. a
+        //newer value it set meanwhile waits for the next call
+        pending.compare_exchange_strong(value, std::numeric_limits<float>::quiet_NaN(), std::memory_order_relaxed);
+    }
+
+    reportLatency();
+}
+
+void MultieffectsAudioProcessor::pullHostParameters(bool all)
+{
+    const auto& parameters = getParameters();
+
+    for (int i = 0; i < juce::jmin(parameters.size(), BinaryPreset::maxParameters); ++i) {
+        const auto index = static_cast<size_t>(i);
+        const auto value = parameters.getUnchecked(i)->getValue();
+
+        if (all)
+            pendingHostValues[index].store(std::numeric_limits<float>::quiet_NaN(), std::memory_order_relaxed);
+        else if (value == hostValues[index].load(std::memory_order_relaxed)
+                 || ! std::isnan(pendingHostValues[index].load(std::memory_order_relaxed)))
+            continue;
+
+        hostValues[index].store(value, std::memory_order_relaxed);
+    }
+}
+
+void MultieffectsAudioProcessor::setHostValue(size_t index, float normalisedValue)
+{
+    hostValues[index].store(normalisedValue, std::memory_order_relaxed);
+    pendingHostValues[index].store(normalisedValue, std::memory_order_relaxed);
+}
+
+void MultieffectsAudioProcessor::timerCallback()
+{
+    updateHost();
+}
+
+void MultieffectsAudioProcessor::updateGeneralFilterCoefficients(size_t instance, const ControlSmoothers& s, int filterMode, int rampLength)
+{
+    const auto sampleRate = getSampleRate();
+    const auto mode = static_cast<FilterCoefficientCache::Mode>(filterMode);
+
+    //a tan per control block, the state variable filter ramps between them
+    if (rampingCoefficients) {
+        getInstance(rampedGeneralFilter, stagePool.rampedGeneralFilters, instance).dsp.setCoefficients(
+            SIMDStateVariableFilter::calculate(mode, sampleRate,
+                                               s.filterFreq.getCurrentValue(),
+                                               s.filterQuality.getCurrentValue(),
+                                               s.filterGain.getCurrentValue()),
+            rampLength);
+        return;
+    }
+
+    //the cache is shared by every instance, so automation sweeps mostly skip the tan/pow math.
+    //the simd biquad keeps its coefficients as plain floats, so this never allocates
+    getInstance(generalFilter, stagePool.generalFilters, instance).dsp.setCoefficients(filterCoefficientCache->get(
+        mode,
+        sampleRate,
+        juce::jmin(s.filterFreq.getCurrentValue(), static_cast<float>(sampleRate * 0.49)),
+        s.filterQuality.getCurrentValue(),
+        s.filterGain.getCurrentValue()));
+}
+
+void MultieffectsAudioProcessor::setTileSize(int numSamples)
+{
+    //anything below 0 but autoTileSize would make processControlBlocks step backwards
+    jassert(numSamples >= autoTileSize);
+    tileSize.store(numSamples == autoTileSize ? autoTileSize : juce::jmax(0, numSamples));
+}
+
+float MultieffectsAudioProcessor::getDelayTimeMs() const
+{
+    return getDelayTimeMs(ParameterSource());
+}
+
+float MultieffectsAudioProcessor::getDelayTimeMs(const ParameterSource& source) const
+{
+    const auto beats = getDelaySyncBeats()[static_cast<size_t>(source.getIndex(*delaySync))];
+
+    if (beats == 0.f)
+        return source.get(*delayTimeMs);
+
+    const auto bpm = juce::jmax(1.0, hostBpm.load(std::memory_order_relaxed));
+    return juce::jmin(static_cast<float>(60000.0 / bpm) * beats, static_cast<float>(FeedbackDelay::maxDelaySeconds * 1000.0));
+}
+
+float MultieffectsAudioProcessor::ParameterSource::get(const juce::AudioParameterFloat& param) const
+{
+    if (slotValues == nullptr)
+        return param.get();
+
+    return param.convertFrom0to1((*slotValues)[static_cast<size_t>(param.getParameterIndex())].load(std::memory_order_relaxed));
+}
+
+int MultieffectsAudioProcessor::ParameterSource::getIndex(const juce::AudioParameterChoice& param) const
+{
+    if (slotValues == nullptr)
+        return param.getIndex();
+
+    return juce::roundToInt(param.convertFrom0to1((*slotValues)[static_cast<size_t>(param.getParameterIndex())].load(std::memory_order_relaxed)));
+}
+
+MultieffectsAudioProcessor::ParameterSource MultieffectsAudioProcessor::getParameterSource(size_t slot) const
+{
+    //the first slot of every option is the host's
+    return isPoolSlot(slot) ? ParameterSource{ &slotValues[slot] } : getHostSource();
+}
+
+void MultieffectsAudioProcessor::startControlSmoothers(ControlSmoothers& s, const ParameterSource& source)
+{
+    s.ladderCutoff.setCurrentAndTargetValue(source.get(*ladderFilterCutoffHz));
+    s.filterFreq.setCurrentAndTargetValue(source.get(*generalFilterFreqHz));
+    s.filterQuality.setCurrentAndTargetValue(source.get(*generalFilterQuality));
+    s.filterGain.setCurrentAndTargetValue(source.get(*generalFilterGain));
+}
+
+void MultieffectsAudioProcessor::setDSPOrder(const DSP_Order& newOrder)
+{
+    //an order that repeats an option is a chain that needs the stage pool, getDSPOrder returns it either way
+    requestedOrder = newOrder;
+
+    const auto accepted = setDSPChain(DSP_Chain::fromOrder(newOrder, requestedLinks));
+    jassert(accepted);
+    juce::ignoreUnused(accepted);
+}
+
+void MultieffectsAudioProcessor::setDSPLinks(const DSP_Links& newLinks)
+{
+    requestedLinks = newLinks;
+
+    const auto accepted = setDSPChain(DSP_Chain::fromOrder(requestedOrder, newLinks));
+    jassert(accepted);
+    juce::ignoreUnused(accepted);
+}
+
+bool MultieffectsAudioProcessor::setDSPChain(const DSP_Chain& newChain)
+{
+    if (! isValidChain(newChain))
+        return false;
+
+    //the slots past the end are left at their defaults, so equal chains compare equal
+    auto chain = DSP_Chain();
+    chain.numSlots = newChain.numSlots;
+
+    for (size_t slot = 0; slot < chain.numSlots; ++slot) {
+        chain.options[slot] = newChain.options[slot];
+        chain.links[slot] = slot > 0 && newChain.links[slot];
+    }
+
+    requestedChain = chain;
+    chain.toOrder(requestedOrder, requestedLinks);
+
+    dspChainMailbox.push({ chain, ++numRoutingChanges });
+    return true;
+}
+
+void MultieffectsAudioProcessor::setStagePoolSize(int instancesPerOption)
+{
+    jassert(instancesPerOption >= 1 && instancesPerOption <= static_cast<int>(maxSlots));
+    stagePoolSize.store(juce::jlimit(1, static_cast<int>(maxSlots), instancesPerOption));
+}
+
+void MultieffectsAudioProcessor::setSlotParameter(size_t slot, int parameterIndex, float normalisedValue)
+{
+    jassert(slot < maxSlots && juce::isPositiveAndBelow(parameterIndex, getParameters().size()));
+
+    if (slot < maxSlots && juce::isPositiveAndBelow(parameterIndex, BinaryPreset::maxParameters))
+        slotValues[slot][static_cast<size_t>(parameterIndex)].store(juce::jlimit(0.f, 1.f, normalisedValue));
+}
+
+float MultieffectsAudioProcessor::getSlotParameter(size_t slot, int parameterIndex) const
+{
+    jassert(slot < maxSlots && juce::isPositiveAndBelow(parameterIndex, getParameters().size()));
+
+    if (slot < maxSlots && juce::isPositiveAndBelow(parameterIndex, BinaryPreset::maxParameters))
+        return slotValues[slot][static_cast<size_t>(parameterIndex)].load();
+
+    return 0.f;
+}
+
+bool MultieffectsAudioProcessor::isValidChain(const DSP_Chain& chain) const
+{
+    if (chain.numSlots == 0 || chain.numSlots > maxSlots)
+        return false;
+
+    for (size_t slot = 0; slot < chain.numSlots; ++slot) {
+        if (static_cast<size_t>(chain.options[slot]) >= numOptions)
+            return false;
+    }
+
+    //the same stage can't be in two places at once, every repeat needs an instance of its own
+    const auto poolSize = stagePoolSize.load();
+
+    for (size_t option = 0; option < numOptions; ++option) {
+        if (chain.count(static_cast<DSP_Option>(option)) > poolSize)
+            return false;
+    }
+
+    return true;
+}
+
+MultieffectsAudioProcessor::DSP_Chain MultieffectsAudioProcessor::DSP_Chain::fromOrder(const DSP_Order& order, const DSP_Links& orderLinks)
+{
+    auto chain = DSP_Chain();
+    chain.numSlots = order.size();
+
+    for (size_t slot = 0; slot < order.size(); ++slot) {
+        chain.options[slot] = order[slot];
+        chain.links[slot] = orderLinks[slot];
+    }
+
+    return chain;
+}
+
+bool MultieffectsAudioProcessor::DSP_Chain::toOrder(DSP_Order& order, DSP_Links& orderLinks) const
+{
+    if (numSlots != order.size())
+        return false;
+
+    for (size_t option = 0; option < numOptions; ++option) {
+        if (count(static_cast<DSP_Option>(option)) != 1)
+            return false;
+    }
+
+    for (size_t slot = 0; slot < order.size(); ++slot) {
+        order[slot] = options[slot];
+        orderLinks[slot] = slot > 0 && links[slot];
+    }
+
+    return true;
+}
+
+int MultieffectsAudioProcessor::DSP_Chain::count(DSP_Option option) const
+{
+    return static_cast<int>(std::count(options.begin(), options.begin() + static_cast<std::ptrdiff_t>(numSlots), option));
+}
+
+BinaryPreset::Record MultieffectsAudioProcessor::createPreset(const juce::String& name) const
+{
+    auto preset = BinaryPreset::Record{};
+    preset.setName(name);
+
+    const auto& parameters = getParameters();
+    jassert(parameters.size() <= BinaryPreset::maxParameters);
+
+    preset.numParameters = static_cast<juce::uint32>(juce::jmin(parameters.size(), BinaryPreset::maxParameters));
+
+    for (int i = 0; i < static_cast<int>(preset.numParameters); ++i)
+        preset.values[i] = parameters.getUnchecked(i)->getValue();
+
+    preset.numSlots = static_cast<juce::uint32>(requestedChain.numSlots);
+
+    for (size_t i = 0; i < requestedChain.numSlots; ++i) {
+        preset.order[i] = static_cast<juce::uint8>(requestedChain.options[i]);
+        preset.links[i] = requestedChain.links[i] ? 1 : 0;
+    }
+
+    //every slot, not just the ones in the chain, so they come back if the chain grows again
+    for (size_t slot = 0; slot < maxSlots; ++slot) {
+        for (size_t i = 0; i < preset.numParameters; ++i)
+            preset.slotValues[slot][i] = slotValues[slot][i].load();
+    }
+
+    return preset;
+}
+
+bool MultieffectsAudioProcessor::applyPreset(const BinaryPreset::Record& preset)
+{
+    if (! applyPresetParameters(preset))
+        return false;
+
+    applyPresetSlotParameters(preset);
+
+    auto chain = DSP_Chain();
+
+    if (getRouting(preset, chain))
+        setDSPChain(chain);
+
+    return true;
+}
+
+void MultieffectsAudioProcessor::queuePreset(const BinaryPreset::Record& preset)
+{
+    //the getters report the new routing right away, like after setDSPChain
+    auto chain = DSP_Chain();
+    auto update = PresetUpdate();
+    update.preset = preset;
+
+    if (getRouting(preset, chain)) {
+        requestedChain = chain;
+        chain.toOrder(requestedOrder, requestedLinks);
+        update.routingSequence = ++numRoutingChanges;
+    }
+
+    presetMailbox.push(update);
+}
+
+juce::uint32 MultieffectsAudioProcessor::getPresetLayoutHash() const
+{
+    return BinaryPreset::getLayoutHash(getParameters());
+}
+
+bool MultieffectsAudioProcessor::getRouting(const BinaryPreset::Record& preset, DSP_Chain& chain) const
+{
+    auto newChain = DSP_Chain();
+
+    if (preset.numSlots == 0 || preset.numSlots > maxSlots)
+        return false;
+
+    newChain.numSlots = preset.numSlots;
+
+    for (size_t i = 0; i < newChain.numSlots; ++i) {
+        const auto option = static_cast<size_t>(preset.order[i]);
+
+        if (option >= numOptions)
+            return false;
+
+        newChain.options[i] = static_cast<DSP_Option>(option);
+        newChain.links[i] = i > 0 && preset.links[i] != 0;
+    }
+
+    if (! isValidChain(newChain))
+        return false;
+
+    chain = newChain;
+    return true;
+}
+
+bool MultieffectsAudioProcessor::applyPresetParameters(const BinaryPreset::Record& preset)
+{
+    const auto& parameters = getParameters();
+
+    if (preset.numParameters != static_cast<juce::uint32>(parameters.size()))
+        return false;
+
+    //only the ones that change, so hosts don't record automation for everything. what the audio
+    //thread still had on its way to the host is older than this
+    for (int i = 0; i < parameters.size(); ++i) {
+        auto* param = parameters.getUnchecked(i);
+        const auto value = juce::jlimit(0.f, 1.f, preset.values[i]);
+
+        pendingHostValues[static_cast<size_t>(i)].store(std::numeric_limits<float>::quiet_NaN(), std::memory_order_relaxed);
+
+        if (param->getValue() != value)
+            param->setValueNotifyingHost(value);
+    }
+
+    return true;
+}
+
+bool MultieffectsAudioProcessor::applyPresetHostValues(const BinaryPreset::Record& preset)
+{
+    const auto& parameters = getParameters();
+
+    if (preset.numParameters != static_cast<juce::uint32>(parameters.size()))
+        return false;
+
+    //the same on the audio thread, updateHost passes the changed ones on to the host
+    for (size_t i = 0; i < preset.numParameters; ++i) {
+        const auto value = juce::jlimit(0.f, 1.f, preset.values[i]);
+
+        if (hostValues[i].load(std::memory_order_relaxed) != value)
+            setHostValue(i, value);
+    }
+
+    return true;
+}
+
+void MultieffectsAudioProcessor::applyPresetSlotParameters(const BinaryPreset::Record& preset)
+{
+    //plain stores, the audio thread pushes whatever changed at its next block
+    const auto numParameters = juce::jmin(static_cast<size_t>(preset.numParameters), static_cast<size_t>(BinaryPreset::maxParameters));
+
+    for (size_t slot = 0; slot < maxSlots; ++slot) {
+        for (size_t i = 0; i < numParameters; ++i)
+            slotValues[slot][i].store(juce::jlimit(0.f, 1.f, preset.slotValues[slot][i]), std::memory_order_relaxed);
+    }
+}
+
+void MultieffectsAudioProcessor::setParallelProcessing(bool shouldRunInParallel)
+{
+    parallelProcessing.store(shouldRunInParallel);
+}
+
+void MultieffectsAudioProcessor::setTailSkipping(bool shouldSkipTails)
+{
+    tailSkipping.store(shouldSkipTails);
+}
+
+void MultieffectsAudioProcessor::setCoefficientRamping(bool shouldRamp)
+{
+    coefficientRamping.store(shouldRamp);
+}
+
+void MultieffectsAudioProcessor::updateCoefficientRamping()
+{
+    const auto shouldRamp = coefficientRamping.load(std::memory_order_relaxed);
+
+    if (shouldRamp == rampingCoefficients)
+        return;
+
+    rampingCoefficients = shouldRamp;
+
+    //the other general filters sat idle, their state is from whenever they last ran
+    for (size_t instance = 0; instance < numInstances; ++instance) {
+        if (rampingCoefficients)
+            getInstance(rampedGeneralFilter, stagePool.rampedGeneralFilters, instance).reset();
+        else
+            getInstance(generalFilter, stagePool.generalFilters, instance).reset();
+    }
+
+    snapControlSmoothers = true;
+
+    for (auto& state : slotStates)
+        state.snapSmoothers = true;
+}
+
+void MultieffectsAudioProcessor::setModulationInterval(int numSamples)
+{
+    jassert(numSamples > 0);
+    modulationInterval.store(juce::jmax(1, numSamples));
+}
+
+int MultieffectsAudioProcessor::getEffectiveTileSize(int numChannels) const
+{
+    auto size = tileSize.load(std::memory_order_relaxed);
+
+    if (size != autoTileSize)
+        return size;
+
+    //half of a typical 32k L1 for the audio, the rest is left for the stage state
+    constexpr int audioBytes = 16 * 1024;
+    auto samples = audioBytes / (static_cast<int>(sizeof(float)) * juce::jmax(1, numChannels));
+
+    //multiples of 32 keep every tile a whole number of SIMD vectors
+    return juce::jmax(32, samples - samples % 32);
+}
+
+double MultieffectsAudioProcessor::getStageTailSeconds(size_t slot) const
+{
+    //from the parameters rather than the stages, so this works before the first block too.
+    //a slot past the allocated pool passes its input through
+    if (slotInstances[slot] >= numInstances)
+        return 0.0;
+
+    const auto sampleRate = getSampleRate();
+    const auto source = getParameterSource(slot);
+
+    switch (dspChain.options[slot])
+    {
+    case DSP_Option::Phase:
+        return TailModel::getPhaserSeconds(LFOPhaser::numStages, source.get(*phaserFeedbackPercent));
+    case DSP_Option::Chorus:
+        return TailModel::getChorusSeconds(source.get(*chorusCenterDelayMs), source.get(*chorusDepthPercent),
+                                           LFOChorus::maximumDelayModulation, source.get(*chorusFeedbackPercent));
+    case DSP_Option::Overdrive:
+        return TailModel::getOversampledSeconds(overdrive.dsp.getLatencyInSamples(), sampleRate);
+    case DSP_Option::LadderFilter:
+        return TailModel::getLadderSeconds(source.get(*ladderFilterCutoffHz),
+                                           SIMDLadderFilter::getScaledResonance(source.get(*ladderFilterResonance)),
+                                           ladderFilter.dsp.getLatencyInSamples(), sampleRate);
+    case DSP_Option::GeneralFilter:
+        return TailModel::getBiquadSeconds(source.get(*generalFilterFreqHz), source.get(*generalFilterQuality),
+                                           source.get(*generalFilterGain));
+    case DSP_Option::Delay:
+        return TailModel::getDelaySeconds(getDelayTimeMs(source), source.get(*delayFeedbackPercent), FeedbackDelay::glideSeconds);
+    case DSP_Option::END_OF_LIST:
+        jassertfalse;
+        break;
+    }
+
+    return 0.0;
+}
+
+void MultieffectsAudioProcessor::updateTails(bool keepLongest)
+{
+    //a stage rings for its own tail after the one in front of it has stopped ringing,
+    //so tails add up along the chain and a parallel group ends with its longest branch
+    auto groupStart = 0.0;
+
+    for (size_t i = 0; i < numRoutingGroups; ++i) {
+        const auto& group = routingGroups[i];
+        auto groupEnd = groupStart;
+
+        for (size_t b = 0; b < group.numBranches; ++b) {
+            const auto slot = group.firstSlot + b;
+            const auto end = groupStart + getStageTailSeconds(slot);
+            auto& sleepAfter = stageSleepAfter[slot];
+
+            //while the input is silent a tail can only grow, a parameter change that shortens
+            //it would otherwise cut off what is still ringing from before
+            sleepAfter = keepLongest ? juce::jmax(sleepAfter, end) : end;
+            groupEnd = juce::jmax(groupEnd, end);
+        }
+
+        groupStart = groupEnd;
+    }
+
+    chainSleepAfter = keepLongest ? juce::jmax(chainSleepAfter, groupStart) : groupStart;
+    tailLengthSeconds.store(groupStart, std::memory_order_relaxed);
+}
+
+bool MultieffectsAudioProcessor::isSilent(const juce::AudioBuffer<float>& buffer)
+{
+    const auto threshold = TailModel::getSilenceThreshold();
+
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch) {
+        if (! SIMDHelpers::isSilent(buffer.getReadPointer(ch), static_cast<size_t>(buffer.getNumSamples()), threshold))
+            return false;
+    }
+
+    return true;
+}
+
+template <MultieffectsAudioProcessor::DSP_Option Option>
+void MultieffectsAudioProcessor::processStage(const ProcessContext& context, size_t slot)
+{
+    const auto start = profiling ? CycleClock::now() : 0;
+
+    //a stage whose tail has died out only has silence to give
+    if (stageAsleep[slot]) {
+        context.getOutputBlock().clear();
+    }
+    else {
+        //calls the concrete dsp directly, no virtual call through DSP_Choice
+        if constexpr (Option == DSP_Option::Phase)
+            phaser.dsp.process(context);
+        else if constexpr (Option == DSP_Option::Chorus)
+            chorus.dsp.process(context);
+        else if constexpr (Option == DSP_Option::Overdrive)
+            overdrive.dsp.process(context);
+        else if constexpr (Option == DSP_Option::LadderFilter)
+            ladderFilter.dsp.process(context);
+        else if constexpr (Option == DSP_Option::GeneralFilter) {
+            if (rampingCoefficients)
+                rampedGeneralFilter.dsp.process(context);
+            else
+                generalFilter.dsp.process(context);
+        }
+        else if constexpr (Option == DSP_Option::Delay)
+            delay.dsp.process(context);
+    }
+
+    if (profiling)
+        profiler.addStageTicks(static_cast<int>(Option), CycleClock::now() - start);
+
+    if (metering)
+        meterStage(Option, context, currentLevel);
+}
+
+void MultieffectsAudioProcessor::processStages(const ProcessContext& context)
+{
+    for (size_t slot = 0; slot < dspChain.numSlots; ++slot)
+        (this->*slotFunctions[slot])(context, slot);
+}
+
+void MultieffectsAudioProcessor::processChainInOrder(const ProcessContext& context)
+{
+    for (size_t slot = 0; slot < dspChain.numSlots; ++slot)
+        processSlot(slot, context, currentLevel);
+}
+
+void MultieffectsAudioProcessor::runChain(const ProcessContext& context)
+{
+    if (! metering) {
+        (this->*chainFunction)(context);
+        return;
+    }
+
+    //the only extra pass, every stage after this measures its output and passes it on as the next input
+    const auto input = MeterLevel::measure(context.getOutputBlock());
+    currentLevel = input;
+
+    (this->*chainFunction)(context);
+
+    meters.addChain(input, currentLevel);
+}
+
+void MultieffectsAudioProcessor::meterStage(DSP_Option option, const ProcessContext& context, MeterLevel& level)
+{
+    const auto output = MeterLevel::measure(context.getOutputBlock());
+    meters.addStage(static_cast<int>(option), level, output);
+    level = output;
+}
+
+void MultieffectsAudioProcessor::processSlot(size_t slot, const ProcessContext& context, MeterLevel& level)
+{
+    const auto option = dspChain.options[slot];
+    auto* stage = getStage(option, slotInstances[slot]);
+
+    //past what the pool has, the input goes through untouched
+    if (stage == nullptr)
+        return;
+
+    const auto start = profiling ? CycleClock::now() : 0;
+
+    if (stageAsleep[slot])
+        context.getOutputBlock().clear();
+    else
+        stage->process(context);
+
+    if (profiling)
+        profiler.addStageTicks(static_cast<int>(option), CycleClock::now() - start);
+
+    if (metering)
+        meterStage(option, context, level);
+}
+
+template <size_t... Options>
+constexpr auto MultieffectsAudioProcessor::makeStageTable(std::index_sequence<Options...>)
+{
+    return std::array<StageFunction, sizeof...(Options)>{
+        &MultieffectsAudioProcessor::processStage<static_cast<DSP_Option>(Options)>...
+    };
+}
+
+MultieffectsAudioProcessor::StageFunction MultieffectsAudioProcessor::getStageFunction(DSP_Option option)
+{
+    //one per option, the order only decides which slot calls which
+    static constexpr auto stageTable = makeStageTable(std::make_index_sequence<numOptions>());
+
+    jassert(static_cast<size_t>(option) < stageTable.size());
+    return stageTable[static_cast<size_t>(option)];
+}
+
+void MultieffectsAudioProcessor::updateRouting()
+{
+    numRoutingGroups = 0;
+    slotInstances.fill(0);
+
+    std::array<size_t, numOptions> counts{};
+
+    for (size_t slot = 0; slot < dspChain.numSlots; ++slot) {
+        const auto option = dspChain.options[slot];
+
+        //the k-th slot of an option runs instance k
+        slotInstances[slot] = counts[static_cast<size_t>(option)]++;
+
+        if (slot > 0 && dspChain.links[slot]) {
+            auto& group = routingGroups[numRoutingGroups - 1];
+
+            for (auto b = group.firstSlot; b < slot; ++b)
+                group.repeatsOption = group.repeatsOption || dspChain.options[b] == option;
+
+            ++group.numBranches;
+        }
+        else {
+            routingGroups[numRoutingGroups++] = { slot, 1, false };
+        }
+    }
+
+    //a pool instance that comes into use starts from silence, not from wherever it stopped last time,
+    //so it's cleared when it leaves. the delay lines are cleared a piece per block in clearIdleDelayLines
+    const auto chorusOption = static_cast<size_t>(DSP_Option::Chorus);
+    const auto delayOption = static_cast<size_t>(DSP_Option::Delay);
+
+    for (size_t option = 0; option < numOptions; ++option) {
+        if (option == chorusOption || option == delayOption)
+            continue;
+
+        const auto end = juce::jmin(instancesInUse[option], numInstances);
+
+        for (auto instance = juce::jmax(static_cast<size_t>(1), counts[option]); instance < end; ++instance)
+            if (auto* stage = getStage(static_cast<DSP_Option>(option), instance))
+                stage->reset();
+    }
+
+    updateClearing(chorus, stagePool.choruses, instancesInUse[chorusOption], counts[chorusOption]);
+    updateClearing(delay, stagePool.delays, instancesInUse[delayOption], counts[delayOption]);
+
+    instancesInUse = counts;
+
+    //a slot that runs a different instance than before pushes all of its parameters again
+    for (size_t slot = 0; slot < maxSlots; ++slot) {
+        auto& state = slotStates[slot];
+        const auto option = slot < dspChain.numSlots ? dspChain.options[slot] : DSP_Option::END_OF_LIST;
+
+        if (state.option == option && state.instance == slotInstances[slot])
+            continue;
+
+        state.option = option;
+        state.instance = slotInstances[slot];
+        state.watchers = ParamWatchers();
+        state.snapSmoothers = true;
+
+        if (isPoolSlot(slot))
+            startControlSmoothers(state.smoothers, getParameterSource(slot));
+    }
+
+    //nothing linked keeps a serial chain, with direct stage calls when every option is in it once
+    auto order = DSP_Order();
+    auto links = DSP_Links();
+
+    if (numRoutingGroups != dspChain.numSlots)
+        chainFunction = &MultieffectsAudioProcessor::processRouted;
+    else if (dspChain.toOrder(order, links)) {
+        for (size_t slot = 0; slot < dspChain.numSlots; ++slot)
+            slotFunctions[slot] = getStageFunction(dspChain.options[slot]);
+
+        chainFunction = &MultieffectsAudioProcessor::processStages;
+    }
+    else
+        chainFunction = &MultieffectsAudioProcessor::processChainInOrder;
+
+    updateLatency();
+}
+
+template <typename DSP>
+void MultieffectsAudioProcessor::updateClearing(DSP_Choice<DSP>& first, const StageInstances<DSP>& pool,
+                                                size_t inUse, size_t newInUse)
+{
+    for (auto instance = juce::jmax(static_cast<size_t>(1), newInUse); instance < juce::jmin(inUse, numInstances); ++instance)
+        getInstance(first, pool, instance).dsp.startClearing();
+
+    //one that comes back before it's clear finishes now
+    for (auto instance = juce::jmax(static_cast<size_t>(1), inUse); instance < juce::jmin(newInUse, numInstances); ++instance) {
+        auto& dsp = getInstance(first, pool, instance).dsp;
+
+        if (dsp.isClearing())
+            dsp.reset();
+    }
+}
+
+template <typename DSP>
+bool MultieffectsAudioProcessor::clearIdleInstance(DSP_Choice<DSP>& first, const StageInstances<DSP>& pool, size_t inUse)
+{
+    for (auto instance = juce::jmax(static_cast<size_t>(1), inUse); instance < numInstances; ++instance) {
+        auto& dsp = getInstance(first, pool, instance).dsp;
+
+        if (dsp.isClearing()) {
+            dsp.clearSome(idleClearSamplesPerBlock);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void MultieffectsAudioProcessor::clearIdleDelayLines()
+{
+    //one piece of one instance per block, they're cleared one after the other
+    if (! clearIdleInstance(delay, stagePool.delays, instancesInUse[static_cast<size_t>(DSP_Option::Delay)]))
+        clearIdleInstance(chorus, stagePool.choruses, instancesInUse[static_cast<size_t>(DSP_Option::Chorus)]);
+}
+
+void MultieffectsAudioProcessor::processRouted(const ProcessContext& context)
+{
+    auto& block = context.getOutputBlock();
+
+    for (size_t i = 0; i < numRoutingGroups; ++i) {
+        const auto& group = routingGroups[i];
+
+        if (group.numBranches == 1) {
+            processSlot(group.firstSlot, context, currentLevel);
+        }
+        else {
+            processParallelGroup(group, block);
+        }
+    }
+}
+
+void MultieffectsAudioProcessor::processParallelGroup(const RoutingGroup& group, juce::dsp::AudioBlock<float>& block)
+{
+    const auto numChannels = block.getNumChannels();
+    const auto numBranches = static_cast<int>(group.numBranches);
+    const auto capacity = static_cast<size_t>(branchBuffer.getNumSamples());
+    auto branchBlock = juce::dsp::AudioBlock<float>(branchBuffer);
+
+    jassert(numChannels * (group.numBranches - 1) <= branchBlock.getNumChannels());
+
+    //hosts can send more than the block size they announced, the branches then go in pieces
+    for (size_t start = 0; start < block.getNumSamples(); start += capacity) {
+        auto input = block.getSubBlock(start, juce::jmin(capacity, block.getNumSamples() - start));
+
+        for (size_t b = 0; b < group.numBranches; ++b) {
+            auto& task = branchTasks[b];
+            task.slot = group.firstSlot + b;
+            task.level = currentLevel;
+
+            //the first branch works in place, the others on a copy of the group input
+            if (b == 0) {
+                task.block = input;
+            }
+            else {
+                task.block = branchBlock.getSubsetChannelBlock((b - 1) * numChannels, numChannels)
+                                        .getSubBlock(0, input.getNumSamples());
+                task.block.copyFrom(input);
+            }
+        }
+
+        //every branch runs its own instance, so the workers never share any state. the profiler
+        //and the meters have one row per option though, two branches of one option can't both write it
+        const auto shareRows = group.repeatsOption && (profiling || metering);
+
+        if (workerPool != nullptr && parallelProcessing.load(std::memory_order_relaxed) && ! shareRows) {
+            workerPool->runTasks(&MultieffectsAudioProcessor::runBranch, this, numBranches);
+        }
+        else {
+            for (int b = 0; b < numBranches; ++b)
+                runBranch(this, b);
+        }
+
+        //branches aren't latency compensated, an oversampled stage next to a plain one
+        //with linear phase filters will comb a little
+        for (size_t b = 1; b < group.numBranches; ++b)
+            input.add(branchTasks[b].block);
+
+        input.multiplyBy(1.f / static_cast<float>(numBranches));
+    }
+
+    //the mix is the input of whatever comes next
+    if (metering)
+        currentLevel = MeterLevel::measure(block);
+}
+
+void MultieffectsAudioProcessor::runBranch(void* processor, int branchIndex)
+{
+    auto& self = *static_cast<MultieffectsAudioProcessor*>(processor);
+    auto& task = self.branchTasks[static_cast<size_t>(branchIndex)];
+
+    //the workers do audio thread work, so they're held to the same rules
+    const RealtimeSafety::ScopedRealtime realtimeScope;
+
+    self.processSlot(task.slot, juce::dsp::ProcessContextReplacing<float>(task.block), task.level);
+}
+
+juce::dsp::ProcessorBase* MultieffectsAudioProcessor::getStage(DSP_Option option, size_t instance)
+{
+    if (instance >= numInstances)
+        return nullptr;
+
+    switch (option)
+    {
+    case DSP_Option::Phase:
+        return &getInstance(phaser, stagePool.phasers, instance);
+    case DSP_Option::Chorus:
+        return &getInstance(chorus, stagePool.choruses, instance);
+    case DSP_Option::Overdrive:
+        return &getInstance(overdrive, stagePool.overdrives, instance);
+    case DSP_Option::LadderFilter:
+        return &getInstance(ladderFilter, stagePool.ladderFilters, instance);
+    case DSP_Option::GeneralFilter:
+        if (rampingCoefficients)
+            return &getInstance(rampedGeneralFilter, stagePool.rampedGeneralFilters, instance);
+
+        return &getInstance(generalFilter, stagePool.generalFilters, instance);
+    case DSP_Option::Delay:
+        return &getInstance(delay, stagePool.delays, instance);
+    case DSP_Option::END_OF_LIST:
+        jassertfalse;
+        break;
+    }
+
+    return nullptr;
+}
+
+template <typename DSP>
+void MultieffectsAudioProcessor::resizeInstances(StageInstances<DSP>& pool, size_t size, const juce::dsp::ProcessSpec& spec)
+{
+    pool.resize(size);
+
+    for (auto& instance : pool) {
+        if (instance == nullptr)
+            instance = std::make_unique<DSP_Choice<DSP>>();
+
+        instance->prepare(spec);
+        instance->reset();
+    }
+}
+
+//==============================================================================
+bool MultieffectsAudioProcessor::hasEditor() const
+{
+    return true; // (change this to false if you choose to not supply an editor)
+}
+
+juce::AudioProcessorEditor* MultieffectsAudioProcessor::createEditor()
+{
+    return new MultieffectsAudioProcessorEditor (*this);
+}
+
+//==============================================================================
+namespace
+{
+    //the chain's child of the state, see getChainState
+    const juce::Identifier chainStateType{ "CHAIN" }, slotStateType{ "SLOT" };
+    const juce::Identifier optionID{ "option" }, linkedID{ "linked" };
+}
+
+void MultieffectsAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    // You should use this method to store your parameters in the memory block.
+    // You could do that either as raw data, or use the XML or ValueTree classes
+    // as intermediaries to make it easy to save and load complex data.
+
+    //the chain and the slots' parameters go along, or a session would come back with the default chain
+    auto state = apvts.copyState();
+    state.appendChild(getChainState(), nullptr);
+
+    juce::MemoryOutputStream mos(destData, false);
+    state.writeToStream(mos);
+
+}
+
+void MultieffectsAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    // You should use this method to restore your parameters from this memory block,
+    // whose contents will have been created by the getStateInformation() call.
+
+    //binary presets (see BinaryPreset.h) are accepted here as well as the apvts state
+    if (BinaryPreset::hasMagic(data, static_cast<size_t>(sizeInBytes))) {
+        juce::String error;
+        int numRecords = 0;
+        std::vector<BinaryPreset::Record> converted;
+
+        if (auto* record = BinaryPreset::read(data, static_cast<size_t>(sizeInBytes), getParameters(),
+                                              numRecords, error, converted)) {
+            //the host's memory doesn't have to be aligned for the record
+            auto preset = BinaryPreset::Record();
+            std::memcpy(&preset, record, sizeof(preset));
+            applyPreset(preset);
+        }
+
+        return;
+    }
+
+    auto tree= juce::ValueTree::readFromData(data, sizeInBytes);
+    if (tree.isValid()) {
+        //states saved before the chain was stored keep the current one
+        const auto chainState = tree.getChildWithName(chainStateType);
+        tree.removeChild(chainState, nullptr);
+
+        //like applyPresetParameters, what the audio thread still had on its way to the host is
+        //older than this and updateHost would write it over the state
+        for (auto& pending : pendingHostValues)
+            pending.store(std::numeric_limits<float>::quiet_NaN(), std::memory_order_relaxed);
+
+        apvts.replaceState(tree);
+
+        if (chainState.isValid())
+            setChainState(chainState);
+    }
+}
+
+juce::ValueTree MultieffectsAudioProcessor::getChainState() const
+{
+    auto chainState = juce::ValueTree(chainStateType);
+    const auto& parameters = getParameters();
+
+    //every slot, like createPreset, so they come back if the chain grows again
+    for (size_t slot = 0; slot < maxSlots; ++slot) {
+        auto slotState = juce::ValueTree(slotStateType);
+
+        if (slot < requestedChain.numSlots) {
+            slotState.setProperty(optionID, static_cast<int>(requestedChain.options[slot]), nullptr);
+            slotState.setProperty(linkedID, requestedChain.links[slot], nullptr);
+        }
+
+        for (int i = 0; i < juce::jmin(parameters.size(), BinaryPreset::maxParameters); ++i)
+            if (auto* param = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameters.getUnchecked(i)))
+                slotState.setProperty(param->paramID, getSlotParameter(slot, i), nullptr);
+
+        chainState.appendChild(slotState, nullptr);
+    }
+
+    return chainState;
+}
+
+void MultieffectsAudioProcessor::setChainState(const juce::ValueTree& chainState)
+{
+    const auto& parameters = getParameters();
+    auto chain = DSP_Chain();
+
+    for (int slot = 0; slot < juce::jmin(chainState.getNumChildren(), static_cast<int>(maxSlots)); ++slot) {
+        const auto slotState = chainState.getChild(slot);
+
+        for (int i = 0; i < juce::jmin(parameters.size(), BinaryPreset::maxParameters); ++i) {
+            auto* param = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameters.getUnchecked(i));
+
+            if (param != nullptr && slotState.hasProperty(param->paramID))
+                setSlotParameter(static_cast<size_t>(slot), i, static_cast<float>(slotState.getProperty(param->paramID)));
+        }
+
+        //the slots in the chain come first
+        const auto option = static_cast<int>(slotState.getProperty(optionID, -1));
+
+        if (static_cast<size_t>(slot) == chain.numSlots && juce::isPositiveAndBelow(option, static_cast<int>(numOptions))) {
+            chain.options[chain.numSlots] = static_cast<DSP_Option>(option);
+            chain.links[chain.numSlots] = static_cast<bool>(slotState.getProperty(linkedID, false));
+            ++chain.numSlots;
+        }
+    }
+
+    if (chain.numSlots == 0)
+        return;
+
+    //a session with more repeats than this pool has grows it. the pool only allocates in
+    //prepareToPlay and the repeats would pass their input through until the host calls it
+    //again, so a prepared processor is prepared again here with the audio callback held off
+    auto poolSize = getStagePoolSize();
+
+    for (size_t option = 0; option < numOptions; ++option)
+        poolSize = juce::jmax(poolSize, chain.count(static_cast<DSP_Option>(option)));
+
+    const auto growsPool = poolSize != getStagePoolSize();
+
+    if (growsPool)
+        setStagePoolSize(poolSize);
+
+    setDSPChain(chain);
+
+    if (growsPool && getSampleRate() > 0.0 && getBlockSize() > 0) {
+        suspendProcessing(true);
+        prepareToPlay(getSampleRate(), getBlockSize());
+        suspendProcessing(false);
     }
 }
 
@@ -10,12 +10,30 @@
 
 #include <JuceHeader.h>
 
-#include <C:\Users\ricky\multieffects\SimpleMultiBandComp\Source\DSP\Fifo.h>
+#include "DSP/FilterCoefficientCache.h"
+#include "DSP/SIMDBiquad.h"
+#include "DSP/SIMDStateVariableFilter.h"
+#include "DSP/SIMDLadderFilter.h"
+#include "DSP/SIMDOverdrive.h"
+#include "DSP/LFOPhaser.h"
+#include "DSP/LFOChorus.h"
+#include "DSP/FeedbackDelay.h"
+#include "DSP/Oversampled.h"
+#include "DSP/StageMeters.h"
+#include "DSP/TailModel.h"
+#include "Utility/RealtimeWorkerPool.h"
+#include "Utility/LatestValueMailbox.h"
+#include "Utility/RealtimeSafety.h"
+#include "Utility/StageProfiler.h"
+#include "Utility/AudioTap.h"
+#include "Utility/ParameterEventList.h"
+#include "Preset/BinaryPreset.h"
 
 //==============================================================================
 /**
 */
-class MultieffectsAudioProcessor  : public juce::AudioProcessor
+class MultieffectsAudioProcessor  : public juce::AudioProcessor,
+                                    private juce::Timer
 {
 public:
     //==============================================================================
@@ -55,12 +73,16 @@ public:
     void getStateInformation (juce::MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    //the widest bus, a 3rd order ambisonic one. the phaser and chorus give every channel its own lfo phase up to here
+    static constexpr int maxChannels = ControlRateLFO::maxPhases;
+
     enum class DSP_Option {
         Phase,
         Chorus,
         Overdrive,
         LadderFilter,
         GeneralFilter,
+        Delay,
         END_OF_LIST
     };
 
@@ -69,7 +91,137 @@ public:
 
     using DSP_Order = std::array<DSP_Option, static_cast<size_t>(DSP_Option::END_OF_LIST)>;
 
-    SimpleMBComp::Fifo<DSP_Order> dspOrderFifo;
+    //parallel routing: links[i] runs slot i side by side with slot i - 1 instead of after it.
+    //each run of linked slots gets a copy of the same input and their outputs are averaged,
+    //so phaser|chorus is { false, true, false, ... }. all false is the plain serial chain
+    using DSP_Links = std::array<bool, static_cast<size_t>(DSP_Option::END_OF_LIST)>;
+
+    //the audio thread picks up the latest order and links at the start of the next block.
+    //call these from one thread, the getters return what was set last, not what's playing yet.
+    //both set a chain with every option once, see setDSPChain, and the getters return the
+    //last one of those
+    void setDSPOrder(const DSP_Order& newOrder);
+    void setDSPLinks(const DSP_Links& newLinks);
+    DSP_Order getDSPOrder() const { return requestedOrder; }
+    DSP_Links getDSPLinks() const { return requestedLinks; }
+
+    //variable length chains: up to maxSlots slots, with any option as often as the stage pool
+    //has instances of it. the k-th slot of an option runs instance k of that stage. the first
+    //one is the stage the host parameters drive, the others take their parameters from
+    //setSlotParameter. links work like DSP_Links, links[0] is ignored
+    static constexpr size_t maxSlots = BinaryPreset::maxSlots;
+
+    struct DSP_Chain
+    {
+        std::array<DSP_Option, maxSlots> options{};
+        std::array<bool, maxSlots> links{};
+        size_t numSlots = 0;
+
+        //every option once, in order
+        static DSP_Chain fromOrder(const DSP_Order& order, const DSP_Links& orderLinks = {});
+
+        //false when the chain doesn't have every option exactly once
+        bool toOrder(DSP_Order& order, DSP_Links& orderLinks) const;
+
+        int count(DSP_Option option) const;
+    };
+
+    //returns false and changes nothing when the chain is empty, has an invalid option or needs
+    //more instances of an option than getStagePoolSize. same thread rules as setDSPOrder
+    bool setDSPChain(const DSP_Chain& newChain);
+    DSP_Chain getDSPChain() const { return requestedChain; }
+
+    //instances of every stage, allocated and prepared in prepareToPlay so changing the chain
+    //never allocates on the audio thread. a new size takes effect at the next prepareToPlay,
+    //until then slots past what was allocated pass their input through
+    static constexpr int defaultStagePoolSize = 2;
+    void setStagePoolSize(int instancesPerOption);
+    int getStagePoolSize() const { return stagePoolSize.load(); }
+
+    //the parameters of a slot whose stage isn't the first of its option, normalised and indexed
+    //like getParameters(). they start on the defaults and stay with the slot when the chain
+    //changes. oversampling, its filter and the saturation accuracy are the host's for every
+    //instance. any thread, the audio thread picks them up at the next block
+    void setSlotParameter(size_t slot, int parameterIndex, float normalisedValue);
+    float getSlotParameter(size_t slot, int parameterIndex) const;
+
+    //binary presets, see BinaryPreset.h. createPreset reads the current parameters and order.
+    //applyPreset sets them right away, like setStateInformation. queuePreset hands the whole
+    //preset to the audio thread as one snapshot that's applied at the start of the next block,
+    //so switching presets while playing costs the calling thread a single copy. the audio thread
+    //plays it from there, the parameters and the host catch up in updateHost
+    BinaryPreset::Record createPreset(const juce::String& name = {}) const;
+    bool applyPreset(const BinaryPreset::Record& preset);
+    void queuePreset(const BinaryPreset::Record& preset);
+    juce::uint32 getPresetLayoutHash() const;
+
+    //parallel branches run on worker threads, off runs them one after the other on the audio thread.
+    //the workers are started in prepareToPlay, so turn this off before it to not start them at all
+    void setParallelProcessing(bool shouldRunInParallel);
+    bool isParallelProcessing() const { return parallelProcessing.load(); }
+
+    //once the input is silent, every stage whose tail has died out is skipped, and the whole chain
+    //once every tail has. on by default, off runs every stage on every block like before
+    void setTailSkipping(bool shouldSkipTails);
+    bool isTailSkipping() const { return tailSkipping.load(); }
+
+    //per stage and per block load histograms, stage indices are DSP_Option values.
+    //off by default, turn it on with getProfiler().setEnabled(true) from the message thread
+    StageProfiler& getProfiler() { return profiler; }
+    const StageProfiler& getProfiler() const { return profiler; }
+
+    //peak and rms in front of and behind every stage, stage indices are DSP_Option values.
+    //off by default, the editor turns them on while it's open and reads them with getLatest
+    StageMeters& getMeters() { return meters; }
+
+    //the chain's input and output for the spectrum analyzer, a memcpy per block while it's open
+    AudioTap& getPreChainTap() { return preChainTap; }
+    AudioTap& getPostChainTap() { return postChainTap; }
+
+    //returns the stage that processes an option, used by processBlock and the benchmark.
+    //instance picks one from the stage pool, 0 is the one the host parameters drive,
+    //nullptr when it wasn't allocated
+    juce::dsp::ProcessorBase* getStage(DSP_Option option, size_t instance = 0);
+
+    //for offline renderers that run the stages themselves, see StagePipeline. does what the start
+    //of processBlock does, pushing parameters and pulling the order, then fills stages with the
+    //serial chain. returns false when slots are linked, parallel branches only run in processBlock,
+    //and while tail skipping is on, the stages alone can't skip what processBlock would
+    bool prepareSerialStages(std::vector<juce::dsp::ProcessorBase*>& stages);
+
+    //tiled processing: blocks larger than the tile size are split and the whole chain
+    //runs on each tile before moving on. 0 turns it off, autoTileSize picks an L1 sized tile
+    static constexpr int autoTileSize = -1;
+    void setTileSize(int numSamples);
+    int getTileSize() const { return tileSize.load(); }
+    int getEffectiveTileSize(int numChannels) const;
+
+    //processBlock runs in control blocks of this many samples. parameters are applied at every
+    //boundary, and the ones that set filter coefficients glide there instead of jumping once
+    //per host block. 0 applies them once per host block, the chain runs in tiles either way
+    static constexpr int defaultControlBlockSize = 32;
+    void setControlBlockSize(int numSamples);
+    int getControlBlockSize() const { return controlBlockSize.load(); }
+
+    //sample accurate automation: a change at a sample offset into the next processBlock, which
+    //ends a control block there. call from the thread that calls processBlock, before it.
+    //host automation still arrives once per block, returns false when the block is full.
+    //offsets below 0 land at the start of the block, offsets at or past its end hold from the
+    //start of the next one. the parameters and the host see the change in updateHost, like a
+    //queued preset's
+    bool addParameterEvent(int sampleOffset, int parameterIndex, float normalisedValue);
+
+    //coefficient ramping: the filters get exact coefficients at every control block boundary and
+    //move there linearly sample by sample. the general filter runs as a state variable filter for
+    //it, which stays stable in between. off, the general filter is a biquad from the coefficient
+    //cache that steps once per control block and the ladder uses its own 50 ms smoothing. off by default,
+    //so renders match the biquad the BatchChain runs
+    void setCoefficientRamping(bool shouldRamp);
+    bool isCoefficientRamping() const { return coefficientRamping.load(); }
+
+    //samples between two lfo updates of the phaser and chorus, the modulation is interpolated in between
+    void setModulationInterval(int numSamples);
+    int getModulationInterval() const { return modulationInterval.load(); }
 
 //phaser 
 // rate: hz
@@ -83,12 +235,14 @@ public:
     juce::AudioParameterFloat* phaserDepthPercent = nullptr;
     juce::AudioParameterFloat* phaserFeedbackPercent = nullptr;
     juce::AudioParameterFloat* phaserMixPercent = nullptr;
+    juce::AudioParameterChoice* phaserModulation = nullptr;
 
     juce::AudioParameterFloat* chorusRateHz = nullptr;
     juce::AudioParameterFloat* chorusDepthPercent = nullptr;
     juce::AudioParameterFloat* chorusCenterDelayMs = nullptr;
     juce::AudioParameterFloat* chorusFeedbackPercent = nullptr;
     juce::AudioParameterFloat* chorusMixPercent = nullptr;
+    juce::AudioParameterChoice* chorusModulation = nullptr;
 
     juce::AudioParameterFloat* overdriveSaturation = nullptr;
 
@@ -102,9 +256,39 @@ public:
     juce::AudioParameterFloat* generalFilterQuality = nullptr;
     juce::AudioParameterFloat* generalFilterGain = nullptr;
 
+    juce::AudioParameterChoice* oversampling = nullptr;
+    juce::AudioParameterChoice* oversamplingFilter = nullptr;
+
+    juce::AudioParameterChoice* saturationAccuracy = nullptr;
+
+    juce::AudioParameterFloat* delayTimeMs = nullptr;
+    juce::AudioParameterFloat* delayFeedbackPercent = nullptr;
+    juce::AudioParameterFloat* delayMixPercent = nullptr;
+    juce::AudioParameterChoice* delaySync = nullptr;
+
+    //the delay time in ms after tempo sync, at the last tempo the host reported
+    float getDelayTimeMs() const;
+
+    //what the audio thread changed on its own reaches the host here, so processBlock never calls
+    //into it. a timer calls this on the message thread, offline drivers without a message loop
+    //call it between blocks
+    static constexpr int hostUpdateRateHz = 30;
+    void updateHost();
+
 
 private:
-    DSP_Order dspOrder;
+    static constexpr DSP_Order defaultOrder{
+        DSP_Option::Phase,
+        DSP_Option::Chorus,
+        DSP_Option::Overdrive,
+        DSP_Option::LadderFilter,
+        DSP_Option::GeneralFilter,
+        DSP_Option::Delay,
+    };
+
+    //what the audio thread runs, and the instance of its option every slot runs
+    DSP_Chain dspChain = DSP_Chain::fromOrder(defaultOrder);
+    std::array<size_t, maxSlots> slotInstances{};
 
     template <typename DSP>
 struct DSP_Choice  : public juce::dsp::ProcessorBase
@@ -127,14 +311,363 @@ struct DSP_Choice  : public juce::dsp::ProcessorBase
     DSP dsp;
 };
 
-    DSP_Choice<juce::dsp::DelayLine<float>> delay;
-    DSP_Choice<juce::dsp::Phaser<float>> phaser;
-    DSP_Choice<juce::dsp::Chorus<float>> chorus;
-    DSP_Choice<juce::dsp::LadderFilter<float>> overdrive, ladderFilter;
-    DSP_Choice<juce::dsp::IIR::Filter<float>> generalFilter;
+    DSP_Choice<FeedbackDelay> delay;
+    DSP_Choice<LFOPhaser> phaser;
+    DSP_Choice<LFOChorus> chorus;
+    //the two nonlinear stages are the only ones that get oversampled
+    DSP_Choice<Oversampled<SIMDOverdrive>> overdrive;
+    DSP_Choice<Oversampled<SIMDLadderFilter>> ladderFilter;
+    DSP_Choice<SIMDBiquad> generalFilter;
+    DSP_Choice<SIMDStateVariableFilter> rampedGeneralFilter;
+
+    //instances 1 and up of every stage, the members above are instance 0. only prepareToPlay
+    //resizes them, the audio thread picks from what's there
+    template <typename DSP>
+    using StageInstances = std::vector<std::unique_ptr<DSP_Choice<DSP>>>;
+
+    struct StagePool
+    {
+        StageInstances<LFOPhaser> phasers;
+        StageInstances<LFOChorus> choruses;
+        StageInstances<Oversampled<SIMDOverdrive>> overdrives;
+        StageInstances<Oversampled<SIMDLadderFilter>> ladderFilters;
+        StageInstances<SIMDBiquad> generalFilters;
+        StageInstances<SIMDStateVariableFilter> rampedGeneralFilters;
+        StageInstances<FeedbackDelay> delays;
+    };
+
+    StagePool stagePool;
+    std::atomic<int> stagePoolSize{ defaultStagePoolSize };
+
+    //instances per option that prepareToPlay allocated
+    size_t numInstances = 1;
+
+    template <typename DSP>
+    static DSP_Choice<DSP>& getInstance(DSP_Choice<DSP>& first, const StageInstances<DSP>& pool, size_t instance)
+    {
+        return instance == 0 ? first : *pool[instance - 1];
+    }
+
+    template <typename DSP>
+    static void resizeInstances(StageInstances<DSP>& pool, size_t size, const juce::dsp::ProcessSpec& spec);
+
+    using ProcessContext = juce::dsp::ProcessContextReplacing<float>;
+
+    //processBlock calls the chain through one of these, picked when the routing changes
+    using ChainFunction = void (MultieffectsAudioProcessor::*)(const ProcessContext&);
+
+    //a serial chain with every option once calls each slot's stage through its own
+    //processStage, which calls the concrete dsp directly. the slots pick theirs when the
+    //routing changes, so there are six of them instead of a chain function per order
+    using StageFunction = void (MultieffectsAudioProcessor::*)(const ProcessContext&, size_t);
+
+    template <DSP_Option Option>
+    void processStage(const ProcessContext& context, size_t slot);
+
+    void processStages(const ProcessContext& context);
+    void processChainInOrder(const ProcessContext& context);
+
+    //the stage of a slot through DSP_Choice, for the paths that pick stages at run time.
+    //level is the stage's input level when metering, and its output level afterwards
+    void processSlot(size_t slot, const ProcessContext& context, MeterLevel& level);
+
+    //the chain function for one tile, with the chain input and output metered
+    void runChain(const ProcessContext& context);
+    void meterStage(DSP_Option option, const ProcessContext& context, MeterLevel& level);
+
+    template <size_t... Options>
+    static constexpr auto makeStageTable(std::index_sequence<Options...>);
+
+    static StageFunction getStageFunction(DSP_Option option);
+
+    ChainFunction chainFunction = nullptr;
+    std::array<StageFunction, maxSlots> slotFunctions{};
+
+    //the serial chains above only run when nothing is linked, otherwise the chain function
+    //is processRouted, which walks the groups of linked slots
+    struct RoutingGroup
+    {
+        size_t firstSlot = 0;
+        size_t numBranches = 1;
+
+        //two branches of one option share a profiler and a meter row, so they can't run on two threads while those run
+        bool repeatsOption = false;
+    };
+
+    static constexpr size_t maxBranches = maxSlots;
+
+    std::array<RoutingGroup, maxSlots> routingGroups;
+    size_t numRoutingGroups = 0;
+
+    void updateRouting();
+    void processRouted(const ProcessContext& context);
+    void processParallelGroup(const RoutingGroup& group, juce::dsp::AudioBlock<float>& block);
+
+    struct BranchTask
+    {
+        size_t slot = 0;
+        juce::dsp::AudioBlock<float> block;
+        MeterLevel level;
+    };
+
+    //worker pool entry point, the context is the processor
+    static void runBranch(void* processor, int branchIndex);
+
+    //filled by the audio thread before the pool runs, one per branch of the current group
+    std::array<BranchTask, maxBranches> branchTasks;
+
+    //the input copies for every branch but the first, which runs in place
+    juce::AudioBuffer<float> branchBuffer;
+    std::unique_ptr<RealtimeWorkerPool> workerPool;
+    std::atomic<bool> parallelProcessing{ true };
+
+    StageProfiler profiler{ static_cast<int>(DSP_Option::END_OF_LIST) };
+
+    StageMeters meters{ static_cast<int>(DSP_Option::END_OF_LIST) };
+
+    AudioTap preChainTap, postChainTap;
+
+    //copied from the profiler and the meters at the start of every block, the workers read them too
+    bool profiling = false;
+    bool metering = false;
+
+    //level of the signal in the tile the chain is working on, see runChain
+    MeterLevel currentLevel;
+
+    //silence detection, see updateTails. a slot sleeps once the input has been silent for longer
+    //than the tails of everything up to and including it, its sleepAfter in seconds
+    static constexpr size_t numOptions = static_cast<size_t>(DSP_Option::END_OF_LIST);
+
+    std::array<double, maxSlots> stageSleepAfter{};
+    std::array<bool, maxSlots> stageAsleep{};
+    double chainSleepAfter = 0.0;
+    juce::int64 silentSamples = 0;
+
+    std::atomic<bool> tailSkipping{ true };
+
+    //the tail of the whole chain for the host, from the audio thread
+    std::atomic<double> tailLengthSeconds{ 0.0 };
+
+    double getStageTailSeconds(size_t slot) const;
+    void updateTails(bool keepLongest);
+
+    //true when the whole block is below TailModel's threshold
+    static bool isSilent(const juce::AudioBuffer<float>& buffer);
+
+    std::atomic<int> tileSize{ 0 };
+    std::atomic<int> controlBlockSize{ defaultControlBlockSize };
+
+    //the parameters that set filter coefficients, smoothed at control rate. the ladder smooths
+    //per sample on top, the general filter gets new coefficients once per control block
+    static constexpr double controlSmoothingSeconds = 0.02;
+
+    struct ControlSmoothers
+    {
+        juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> ladderCutoff, filterFreq;
+        juce::SmoothedValue<float> filterQuality, filterGain;
+    };
+
+    ControlSmoothers controlSmoothers;
+
+    //the first control block after prepareToPlay starts at the targets instead of gliding to them
+    bool snapControlSmoothers = true;
+
+    ParameterEventList parameterEvents;
+
+    //splits a block at control block, tile and event boundaries and runs the chain on each piece
+    void processControlBlocks(juce::dsp::AudioBlock<float>& block, size_t tile);
+
+    //applies the events up to and including offset, returns the index of the next one
+    int applyParameterEvents(int firstEvent, int offset);
+
+    //advances the smoothers by numSamples and pushes the values they reach
+    void updateControlRate(int numSamples);
+
+    //the same for the ladder or the general filter of one instance, snap starts on the targets
+    void updateSmoothedControls(DSP_Option option, size_t instance, ControlSmoothers& smoothers,
+                                bool snap, int filterMode, int numSamples);
+
+    std::atomic<bool> coefficientRamping{ false };
+
+    //audio thread copy, picks the general filter stage and how updateControlRate pushes coefficients
+    bool rampingCoefficients = false;
+
+    //takes a changed setCoefficientRamping, the stage that takes over starts from silence on the targets
+    void updateCoefficientRamping();
+
+    std::atomic<int> modulationInterval{ ControlRateLFO::defaultControlInterval };
+
+    //from the play head, 120 when the host doesn't say
+    std::atomic<double> hostBpm{ 120.0 };
+
+    //runs once per block on the audio thread, only pushes parameters that changed
+    void updateDSPFromParams();
+    void pullDSPRouting();
+
+    //a chain and a preset pushed around the same time can arrive in either order, so both carry
+    //a number from one count. the audio thread only takes a routing newer than the one it runs
+    struct ChainUpdate
+    {
+        DSP_Chain chain;
+        juce::uint64 sequence = 0;
+    };
+
+    //routingSequence is 0 when the preset's routing isn't a valid chain, it then keeps the current one
+    struct PresetUpdate
+    {
+        BinaryPreset::Record preset;
+        juce::uint64 routingSequence = 0;
+    };
+
+    LatestValueMailbox<ChainUpdate> dspChainMailbox;
+    LatestValueMailbox<PresetUpdate> presetMailbox;
+
+    //the writer's count and the audio thread's newest routing
+    juce::uint64 numRoutingChanges = 0;
+    juce::uint64 routingSequence = 0;
+
+    //where the audio thread pulls a queued preset to, a few kB that stay off its stack
+    PresetUpdate queuedPreset;
+
+    //what was pushed last, for saving the state off the audio thread
+    DSP_Chain requestedChain = dspChain;
+    DSP_Order requestedOrder = defaultOrder;
+    DSP_Links requestedLinks{};
+
+    bool isValidChain(const DSP_Chain& chain) const;
+
+    //the chain stored in a preset, false when it isn't a valid one
+    bool getRouting(const BinaryPreset::Record& preset, DSP_Chain& chain) const;
+
+    //the chain and every slot's parameters for getStateInformation, a child of the apvts tree.
+    //slot parameters are stored by ID, so a session survives a changed parameter layout. a chain
+    //with more repeats than the pool has grows the pool and prepares a prepared processor again
+    juce::ValueTree getChainState() const;
+    void setChainState(const juce::ValueTree& chainState);
+
+    //sets every parameter that differs from the preset, returns false if the layout doesn't match.
+    //the host values version is the audio thread's, for queued presets
+    bool applyPresetParameters(const BinaryPreset::Record& preset);
+    bool applyPresetHostValues(const BinaryPreset::Record& preset);
+    void applyPresetSlotParameters(const BinaryPreset::Record& preset);
+
+    //0 jumps, the biquad always does
+    void updateGeneralFilterCoefficients(size_t instance, const ControlSmoothers& smoothers, int filterMode, int rampLength = 0);
+    void updateOversampling(int factorIndex, int filterIndex);
+
+    //the oversampled slots of the chain add up. the audio thread only works it out,
+    //reportLatency hands it to the host
+    void updateLatency();
+    void reportLatency();
+
+    std::atomic<int> chainLatencySamples{ 0 };
+
+    void timerCallback() override;
+
+    //remembers the last value pushed into a dsp object
+    struct ParamWatcher
+    {
+        bool hasChanged(float newValue) noexcept
+        {
+            if (newValue == lastValue)
+                return false;
+
+            lastValue = newValue;
+            return true;
+        }
+
+        //NaN never compares equal, so a fresh watcher always reports a change
+        float lastValue = std::numeric_limits<float>::quiet_NaN();
+    };
+
+    struct ParamWatchers
+    {
+        ParamWatcher phaserRate, phaserCenterFreq, phaserDepth, phaserFeedback, phaserMix, phaserModulation;
+        ParamWatcher chorusRate, chorusDepth, chorusCenterDelay, chorusFeedback, chorusMix, chorusModulation;
+        ParamWatcher overdriveSaturation;
+        ParamWatcher ladderMode, ladderCutoff, ladderResonance, ladderDrive;
+        ParamWatcher filterMode, filterFreq, filterQuality, filterGain;
+        ParamWatcher oversampling, oversamplingFilter;
+        ParamWatcher saturationAccuracy;
+        ParamWatcher modulationInterval;
+        ParamWatcher delayTime, delayFeedback, delayMix;
+    };
+
+    ParamWatchers paramWatchers;
+
+    //where an instance takes its parameters from, the host parameters, the audio thread's copy
+    //of them (getHostSource) or the values of a slot
+    using SlotValues = std::array<std::atomic<float>, BinaryPreset::maxParameters>;
+
+    struct ParameterSource
+    {
+        const SlotValues* slotValues = nullptr;
+
+        float get(const juce::AudioParameterFloat& param) const;
+        int getIndex(const juce::AudioParameterChoice& param) const;
+    };
+
+    ParameterSource getParameterSource(size_t slot) const;
+    ParameterSource getHostSource() const { return { &hostValues }; }
+    float getDelayTimeMs(const ParameterSource& source) const;
+
+    //starts the smoothers on the parameters, without a ramp
+    void startControlSmoothers(ControlSmoothers& smoothers, const ParameterSource& source);
+
+    std::array<SlotValues, maxSlots> slotValues;
+
+    //the host parameters as the audio thread runs them, so processBlock never has to call
+    //setValueNotifyingHost. host changes are pulled in at the start of every block, queued
+    //presets and parameter events write here and leave the value in pendingHostValues for updateHost
+    SlotValues hostValues;
+
+    //set by the audio thread, taken by updateHost, NaN when there's nothing to hand over
+    SlotValues pendingHostValues;
+
+    //takes every parameter that differs from what the audio thread runs. a value the host doesn't
+    //have yet wins, updateHost hands it over right after. everything, and drops what's pending, when all is set
+    void pullHostParameters(bool all);
+    void setHostValue(size_t index, float normalisedValue);
+
+    //pushes one instance's parameters, the ones every instance shares are left to updateDSPFromParams
+    void updateStageFromParams(DSP_Option option, size_t instance, ParamWatchers& w,
+                               ControlSmoothers& smoothers, const ParameterSource& source);
+
+    //what the audio thread pushed into the instance a slot past the first of its option runs.
+    //a slot that gets a different instance starts over, with everything pushed again
+    struct SlotState
+    {
+        DSP_Option option = DSP_Option::END_OF_LIST;
+        size_t instance = 0;
+        ParamWatchers watchers;
+        ControlSmoothers smoothers;
+        bool snapSmoothers = true;
+    };
+
+    std::array<SlotState, maxSlots> slotStates;
+
+    //how many slots of every option the chain had at the last updateRouting, an instance that
+    //leaves use is reset there so it comes back silent
+    std::array<size_t, numOptions> instancesInUse{};
+
+    //the delay lines of the chorus and the delay are megabytes at high rates, one that left use is
+    //cleared this many samples per block instead of all at once in the block that changed the chain
+    static constexpr size_t idleClearSamplesPerBlock = 1 << 16;
+    void clearIdleDelayLines();
+
+    //starts clearing the instances that leave use and finishes the ones that come back
+    template <typename DSP>
+    void updateClearing(DSP_Choice<DSP>& first, const StageInstances<DSP>& pool, size_t inUse, size_t newInUse);
+
+    //one piece of the first idle instance that isn't clear yet, false when they all are
+    template <typename DSP>
+    bool clearIdleInstance(DSP_Choice<DSP>& first, const StageInstances<DSP>& pool, size_t inUse);
+
+    //true for the slots that run an instance of the pool, false for the first of their option
+    //and for the ones past what was allocated
+    bool isPoolSlot(size_t slot) const { return slotInstances[slot] > 0 && slotInstances[slot] < numInstances; }
 
-    using DSP_Pointers = std::array<juce::dsp::ProcessorBase*,
-        static_cast<size_t>(DSP_Option::END_OF_LIST)>;
+    juce::SharedResourcePointer<FilterCoefficientCache> filterCoefficientCache;
 
 
 
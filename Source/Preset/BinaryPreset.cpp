@@ -0,0 +1,204 @@
+/*
+  ==============================================================================
+
+    BinaryPreset.cpp
+
+  ==============================================================================
+*/
+
+#include "BinaryPreset.h"
+
+namespace BinaryPreset
+{
+    namespace
+    {
+        //version 1, without the slot parameters
+        struct RecordV1
+        {
+            char name[maxNameLength];
+
+            juce::uint32 numParameters;
+            juce::uint32 numSlots;
+
+            float values[maxParameters];
+
+            juce::uint8 order[maxSlots];
+            juce::uint8 links[maxSlots];
+        };
+
+        static_assert (sizeof (RecordV1) % 4 == 0);
+
+        size_t getRecordSize (juce::uint32 version)
+        {
+            return version == 1 ? sizeof (RecordV1) : sizeof (Record);
+        }
+
+        Record convert (const RecordV1& old)
+        {
+            auto record = Record();
+
+            std::memcpy (record.name, old.name, sizeof (old.name));
+            record.numParameters = old.numParameters;
+            record.numSlots = old.numSlots;
+            std::memcpy (record.values, old.values, sizeof (old.values));
+            std::memcpy (record.order, old.order, sizeof (old.order));
+            std::memcpy (record.links, old.links, sizeof (old.links));
+
+            //a slot that repeats an effect starts where the preset's own one is
+            for (auto& slot : record.slotValues)
+                std::memcpy (slot, old.values, sizeof (old.values));
+
+            return record;
+        }
+
+        //the parameters appended to the layout since the record was written start on their defaults
+        void extend (Record& record, const juce::Array<juce::AudioProcessorParameter*>& parameters)
+        {
+            const auto numParameters = juce::jmin (parameters.size(), maxParameters);
+
+            for (auto i = (int) record.numParameters; i < numParameters; ++i)
+            {
+                const auto value = parameters.getUnchecked (i)->getDefaultValue();
+                record.values[i] = value;
+
+                for (auto& slot : record.slotValues)
+                    slot[i] = value;
+            }
+
+            record.numParameters = (juce::uint32) numParameters;
+        }
+    }
+
+    juce::String Record::getName() const
+    {
+        return juce::String::fromUTF8 (name, (int) strnlen (name, sizeof (name)));
+    }
+
+    void Record::setName (const juce::String& newName)
+    {
+        std::fill (std::begin (name), std::end (name), '\0');
+
+        //cut on a character boundary so the name stays valid utf8
+        auto text = newName;
+
+        while (text.getNumBytesAsUTF8() > sizeof (name))
+            text = text.dropLastCharacters (1);
+
+        std::memcpy (name, text.toRawUTF8(), text.getNumBytesAsUTF8());
+    }
+
+    juce::uint32 getLayoutHash (const juce::Array<juce::AudioProcessorParameter*>& parameters, int numParameters)
+    {
+        juce::uint32 hash = 2166136261u;
+
+        auto add = [&hash] (juce::uint8 byte)
+        {
+            hash = (hash ^ byte) * 16777619u;
+        };
+
+        if (numParameters < 0 || numParameters > parameters.size())
+            numParameters = parameters.size();
+
+        for (int i = 0; i < numParameters; ++i)
+        {
+            auto* param = parameters.getUnchecked (i);
+            auto id = juce::String();
+
+            if (auto* withID = dynamic_cast<juce::AudioProcessorParameterWithID*> (param))
+                id = withID->paramID;
+
+            for (auto* c = id.toRawUTF8(); *c != 0; ++c)
+                add ((juce::uint8) *c);
+
+            //keeps "ab","c" apart from "a","bc"
+            add (0);
+        }
+
+        return hash;
+    }
+
+    bool write (juce::OutputStream& output, juce::uint32 layoutHash, const Record* records, int numRecords)
+    {
+        jassert (numRecords > 0);
+
+        Header header;
+        std::copy (std::begin (magic), std::end (magic), header.magic);
+        header.version = currentVersion;
+        header.layoutHash = layoutHash;
+        header.numRecords = (juce::uint32) numRecords;
+
+        return output.write (&header, sizeof (header))
+            && output.write (records, sizeof (Record) * (size_t) numRecords);
+    }
+
+    const Record* read (const void* data, size_t size, const juce::Array<juce::AudioProcessorParameter*>& parameters,
+                        int& numRecords, juce::String& error, std::vector<Record>& converted)
+    {
+        if (! hasMagic (data, size) || size < sizeof (Header))
+        {
+            error = "Not a binary preset";
+            return nullptr;
+        }
+
+        Header header;
+        std::memcpy (&header, data, sizeof (header));
+
+        if (header.version < oldestVersion || header.version > currentVersion)
+        {
+            error = "Unsupported preset version " + juce::String (header.version);
+            return nullptr;
+        }
+
+        if (header.numRecords == 0 || (size - sizeof (Header)) / getRecordSize (header.version) < header.numRecords)
+        {
+            error = "Preset data is truncated";
+            return nullptr;
+        }
+
+        const auto* records = static_cast<const char*> (data) + sizeof (Header);
+
+        //every record of a file has the parameters of the build that wrote it, at the same
+        //place in both versions. fewer than now is fine when they're the first ones
+        juce::uint32 numParameters = 0;
+        std::memcpy (&numParameters, records + offsetof (Record, numParameters), sizeof (numParameters));
+
+        const auto currentParameters = (juce::uint32) juce::jmin (parameters.size(), maxParameters);
+
+        if (numParameters > currentParameters || header.layoutHash != getLayoutHash (parameters, (int) numParameters))
+        {
+            error = "Preset was written for different parameters";
+            return nullptr;
+        }
+
+        numRecords = (int) header.numRecords;
+
+        //the header is 16 bytes and records are whole words, so a mapped file keeps them aligned
+        if (header.version == currentVersion && numParameters == currentParameters)
+            return reinterpret_cast<const Record*> (records);
+
+        converted.resize (header.numRecords);
+
+        for (size_t i = 0; i < converted.size(); ++i)
+        {
+            if (header.version == currentVersion)
+            {
+                std::memcpy (&converted[i], records + i * sizeof (Record), sizeof (Record));
+            }
+            else
+            {
+                RecordV1 old;
+                std::memcpy (&old, records + i * sizeof (RecordV1), sizeof (old));
+                converted[i] = convert (old);
+            }
+
+            extend (converted[i], parameters);
+        }
+
+        return converted.data();
+    }
+
+    bool hasMagic (const void* data, size_t size)
+    {
+        return data != nullptr && size >= sizeof (magic) && std::memcmp (data, magic, sizeof (magic)) == 0;
+    }
+}
@@ -0,0 +1,93 @@
+/*
+  ==============================================================================
+
+    BinaryPreset.h
+
+    Fixed layout binary presets. A preset file and a preset bank are the same
+    format, a header followed by one or more records.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    A record holds every parameter as its normalised value, in the order of
+    AudioProcessor::getParameters(), plus the dsp chain, the parallel links and
+    the parameters of every slot.
+    Records have a fixed size and no pointers, so a bank can be used straight
+    from a memory mapped file and a record can go through a LatestValueMailbox
+    as it is.
+
+    The header carries a hash of the parameter IDs in order. A file written by
+    a build with different parameters is rejected instead of loading values
+    into the wrong parameters, unless its parameters are the first ones of the
+    current layout: new parameters are only ever appended, and they start on
+    their defaults. Everything is stored little endian, like every
+    platform the plugin builds for. Files of older versions are still read,
+    their records are converted to the current layout.
+*/
+namespace BinaryPreset
+{
+    inline constexpr char magic[4] = { 'M', 'F', 'X', 'P' };
+    //2 added the slot parameters
+    inline constexpr juce::uint32 currentVersion = 2;
+    inline constexpr juce::uint32 oldestVersion = 1;
+
+    inline constexpr int maxParameters = 64;
+    inline constexpr int maxSlots = 16;
+    inline constexpr int maxNameLength = 32;
+
+    struct Header
+    {
+        char magic[4];
+        juce::uint32 version;
+        juce::uint32 layoutHash;
+        juce::uint32 numRecords;
+    };
+
+    struct Record
+    {
+        //utf8, zero padded, not terminated when it uses all of it
+        char name[maxNameLength];
+
+        juce::uint32 numParameters;
+        juce::uint32 numSlots;
+
+        float values[maxParameters];
+
+        //DSP_Option values, and 1 where a slot runs in parallel with the slot before it
+        juce::uint8 order[maxSlots];
+        juce::uint8 links[maxSlots];
+
+        //what a slot that repeats an option runs with, laid out like values
+        float slotValues[maxSlots][maxParameters];
+
+        juce::String getName() const;
+        void setName (const juce::String& newName);
+    };
+
+    static_assert (std::is_trivially_copyable_v<Record>);
+    static_assert (sizeof (Header) == 16 && sizeof (Record) % 4 == 0);
+
+    /** FNV-1a over the IDs of the first numParameters parameters, in order, -1 hashes all of them. */
+    juce::uint32 getLayoutHash (const juce::Array<juce::AudioProcessorParameter*>& parameters, int numParameters = -1);
+
+    /** Writes a header and the records. One record makes a preset, more make a bank. */
+    bool write (juce::OutputStream& output, juce::uint32 layoutHash, const Record* records, int numRecords);
+
+    /** Checks the header and the size of data, returns the first record or
+        nullptr with the reason in error. numRecords is set on success.
+        Records of the current version and layout are used where they are in
+        data, older ones are converted into converted and the result points
+        there. Slots of a version 1 record start on the preset's own parameters.
+    */
+    const Record* read (const void* data, size_t size, const juce::Array<juce::AudioProcessorParameter*>& parameters,
+                        int& numRecords, juce::String& error, std::vector<Record>& converted);
+
+    /** True when data starts like a binary preset, says nothing about whether it's valid. */
+    bool hasMagic (const void* data, size_t size);
+}
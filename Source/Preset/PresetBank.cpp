@@ -0,0 +1,75 @@
+/*
+  ==============================================================================
+
+    PresetBank.cpp
+
+  ==============================================================================
+*/
+
+#include "PresetBank.h"
+
+juce::Result PresetBank::open (const juce::File& bankFile, const juce::Array<juce::AudioProcessorParameter*>& parameters)
+{
+    close();
+
+    auto file = std::make_unique<juce::MemoryMappedFile> (bankFile, juce::MemoryMappedFile::readOnly);
+
+    if (file->getData() == nullptr)
+        return juce::Result::fail ("Could not map " + bankFile.getFullPathName());
+
+    juce::String error;
+    int count = 0;
+    auto* first = BinaryPreset::read (file->getData(), file->getSize(), parameters, count, error, convertedRecords);
+
+    if (first == nullptr)
+        return juce::Result::fail (error + ": " + bankFile.getFullPathName());
+
+    mappedFile = std::move (file);
+    records = first;
+    numRecords = count;
+
+    return juce::Result::ok();
+}
+
+void PresetBank::close()
+{
+    indexByName.clear();
+    records = nullptr;
+    numRecords = 0;
+    convertedRecords.clear();
+    mappedFile.reset();
+}
+
+int PresetBank::indexOf (const juce::String& name) const
+{
+    //a bank has at least one record, so an empty index hasn't been built yet
+    if (indexByName.empty() && numRecords > 0)
+    {
+        //the first preset with a name wins, later duplicates are still reachable by index
+        indexByName.reserve ((size_t) numRecords);
+
+        for (int i = 0; i < numRecords; ++i)
+            indexByName.emplace (records[i].getName(), i);
+    }
+
+    auto found = indexByName.find (name);
+    return found != indexByName.end() ? found->second : -1;
+}
+
+juce::Result PresetBank::write (const juce::File& bankFile, juce::uint32 layoutHash,
+                                const std::vector<BinaryPreset::Record>& presets)
+{
+    if (presets.empty())
+        return juce::Result::fail ("A bank needs at least one preset");
+
+    bankFile.getParentDirectory().createDirectory();
+    bankFile.deleteFile();
+
+    auto stream = bankFile.createOutputStream();
+
+    if (stream == nullptr || stream->failedToOpen()
+        || ! BinaryPreset::write (*stream, layoutHash, presets.data(), (int) presets.size()))
+        return juce::Result::fail ("Could not write " + bankFile.getFullPathName());
+
+    return juce::Result::ok();
+}
@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    PresetBank.h
+
+    Thousands of binary presets in one memory mapped file.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "BinaryPreset.h"
+
+//==============================================================================
+/**
+    Maps a bank written by BinaryPreset::write() read only. Opening a bank only
+    checks the header, the records are paged in by the os when they are first
+    used. Looking a preset up by index is a pointer offset, by name a hash map
+    lookup once the first indexOf() has read the names.
+*/
+class PresetBank
+{
+public:
+    PresetBank() = default;
+
+    /** Maps the file and checks it against the processor's parameters, see BinaryPreset::read. */
+    juce::Result open (const juce::File& bankFile, const juce::Array<juce::AudioProcessorParameter*>& parameters);
+
+    void close();
+
+    bool isOpen() const { return records != nullptr; }
+    int getNumPresets() const { return numRecords; }
+
+    /** O(1), the record lives in the mapped file, or in memory for a bank of an
+        older version or layout, see BinaryPreset::read.
+    */
+    const BinaryPreset::Record& getPreset (int index) const
+    {
+        jassert (juce::isPositiveAndBelow (index, numRecords));
+        return records[index];
+    }
+
+    /** -1 when there's no preset with that name. The first call reads the name
+        of every record to build the index, which pages in the whole file, so a
+        bank shouldn't be shared between threads before it has been called.
+    */
+    int indexOf (const juce::String& name) const;
+
+    /** Writes presets to a bank file, replacing it. */
+    static juce::Result write (const juce::File& bankFile, juce::uint32 layoutHash,
+                               const std::vector<BinaryPreset::Record>& presets);
+
+private:
+    std::unique_ptr<juce::MemoryMappedFile> mappedFile;
+    const BinaryPreset::Record* records = nullptr;
+    int numRecords = 0;
+
+    //the records of an older bank, converted
+    std::vector<BinaryPreset::Record> convertedRecords;
+
+    //built by the first indexOf
+    mutable std::unordered_map<juce::String, int> indexByName;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PresetBank)
+};
@@ -0,0 +1,800 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.cpp
+
+  ==============================================================================
+*/
+
+#include "OfflineRenderer.h"
+#include "StagePipeline.h"
+
+namespace
+{
+    //the whole text has to be one finite number, getFloatValue would take "" or "1O" as 0 and 1
+    bool parseNumber (const juce::String& text, float& result)
+    {
+        const auto* start = text.toRawUTF8();
+        char* end = nullptr;
+        const auto number = std::strtod (start, &end);
+
+        if (text.isEmpty() || end == start || *end != 0 || ! std::isfinite (number))
+            return false;
+
+        result = (float) number;
+        return true;
+    }
+
+    //a real parameter value as text to the normalised value, choices take the index or the name.
+    //anything that isn't a value of the parameter fails instead of being clamped or read as 0
+    juce::Result parseParameterValue (juce::RangedAudioParameter& param, const juce::String& parameterID,
+                                      const juce::String& value, float& normalisedValue)
+    {
+        const auto text = value.trim();
+        const auto& range = param.getNormalisableRange();
+        float realValue = 0.f;
+
+        if (auto* choice = dynamic_cast<juce::AudioParameterChoice*> (&param))
+        {
+            auto index = choice->choices.indexOf (text, true);
+
+            if (index < 0 && text.isNotEmpty() && text.containsOnly ("0123456789"))
+                index = text.getIntValue();
+
+            if (! juce::isPositiveAndBelow (index, choice->choices.size()))
+                return juce::Result::fail ("Unknown choice '" + value + "' for " + parameterID);
+
+            realValue = (float) index;
+        }
+        else if (! parseNumber (text, realValue))
+        {
+            return juce::Result::fail ("'" + value + "' is not a number, for " + parameterID);
+        }
+        else if (realValue < range.start || realValue > range.end)
+        {
+            return juce::Result::fail ("'" + value + "' is outside " + juce::String (range.start) + " to "
+                                       + juce::String (range.end) + " for " + parameterID);
+        }
+
+        normalisedValue = param.convertTo0to1 (realValue);
+        return juce::Result::ok();
+    }
+}
+
+OfflineRenderer::OfflineRenderer()
+{
+    formatManager.registerBasicFormats();
+    processor.setNonRealtime (true);
+
+    //offline blocks are large, so by default the chain runs tile by tile
+    processor.setTileSize (MultieffectsAudioProcessor::autoTileSize);
+
+    //the pipeline can't skip stages, so neither does processBlock, and both render the same
+    processor.setTailSkipping (false);
+}
+
+OfflineRenderer::~OfflineRenderer()
+{
+}
+
+//==============================================================================
+void OfflineRenderer::setBlockSize (int newBlockSize)
+{
+    jassert (newBlockSize > 0);
+    blockSize = juce::jmax (1, newBlockSize);
+}
+
+juce::Result OfflineRenderer::loadPreset (const juce::File& presetFile)
+{
+    if (! presetFile.existsAsFile())
+        return juce::Result::fail ("Preset not found: " + presetFile.getFullPathName());
+
+    //xml presets are the apvts state written out with ValueTree::toXmlString
+    if (auto xml = juce::parseXML (presetFile))
+    {
+        auto tree = juce::ValueTree::fromXml (*xml);
+
+        if (! tree.hasType (processor.apvts.state.getType()))
+            return juce::Result::fail ("Preset is not a multieffects state: " + presetFile.getFullPathName());
+
+        processor.apvts.replaceState (tree);
+        return juce::Result::ok();
+    }
+
+    //anything else is treated as a getStateInformation blob
+    juce::MemoryBlock data;
+
+    if (! presetFile.loadFileAsData (data) || data.isEmpty())
+        return juce::Result::fail ("Could not read preset: " + presetFile.getFullPathName());
+
+    if (BinaryPreset::hasMagic (data.getData(), data.getSize()))
+    {
+        juce::String error;
+        int numRecords = 0;
+        std::vector<BinaryPreset::Record> converted;
+        auto* record = BinaryPreset::read (data.getData(), data.getSize(), processor.getParameters(),
+                                           numRecords, error, converted);
+
+        if (record == nullptr)
+            return juce::Result::fail (error + ": " + presetFile.getFullPathName());
+
+        auto preset = BinaryPreset::Record();
+        std::memcpy (&preset, record, sizeof (preset));
+
+        if (! processor.applyPreset (preset))
+            return juce::Result::fail ("Preset doesn't match the parameters: " + presetFile.getFullPathName());
+
+        return juce::Result::ok();
+    }
+
+    if (! juce::ValueTree::readFromData (data.getData(), data.getSize()).isValid())
+        return juce::Result::fail ("Preset is not a multieffects state: " + presetFile.getFullPathName());
+
+    processor.setStateInformation (data.getData(), (int) data.getSize());
+    return juce::Result::ok();
+}
+
+juce::Result OfflineRenderer::loadPresetFromBank (const juce::File& bankFile, const juce::String& nameOrIndex)
+{
+    PresetBank bank;
+    auto result = bank.open (bankFile, processor.getParameters());
+
+    if (result.failed())
+        return result;
+
+    auto index = bank.indexOf (nameOrIndex);
+
+    if (index < 0 && nameOrIndex.containsOnly ("0123456789"))
+        index = nameOrIndex.getIntValue();
+
+    if (! juce::isPositiveAndBelow (index, bank.getNumPresets()))
+        return juce::Result::fail ("No preset '" + nameOrIndex + "' in " + bankFile.getFullPathName());
+
+    if (! processor.applyPreset (bank.getPreset (index)))
+        return juce::Result::fail ("Preset doesn't match the parameters: " + nameOrIndex);
+
+    return juce::Result::ok();
+}
+
+juce::Result OfflineRenderer::savePreset (const juce::File& presetFile, const juce::String& name)
+{
+    return PresetBank::write (presetFile, processor.getPresetLayoutHash(), { processor.createPreset (name) });
+}
+
+juce::Result OfflineRenderer::writeBank (const juce::Array<juce::File>& presetFiles, const juce::File& bankFile)
+{
+    std::vector<BinaryPreset::Record> presets;
+    presets.reserve ((size_t) presetFiles.size());
+
+    for (auto& file : presetFiles)
+    {
+        auto result = loadPreset (file);
+
+        if (result.failed())
+            return result;
+
+        presets.push_back (processor.createPreset (file.getFileNameWithoutExtension()));
+    }
+
+    return PresetBank::write (bankFile, processor.getPresetLayoutHash(), presets);
+}
+
+juce::Result OfflineRenderer::setParameter (const juce::String& parameterID, const juce::String& value)
+{
+    auto* param = processor.apvts.getParameter (parameterID);
+
+    if (param == nullptr)
+        return juce::Result::fail ("Unknown parameter: " + parameterID);
+
+    float normalisedValue = 0.f;
+    auto result = parseParameterValue (*param, parameterID, value, normalisedValue);
+
+    if (result.wasOk())
+        param->setValueNotifyingHost (normalisedValue);
+
+    return result;
+}
+
+juce::Result OfflineRenderer::setSlotParameter (int slot, const juce::String& parameterID, const juce::String& value)
+{
+    if (! juce::isPositiveAndBelow (slot, (int) MultieffectsAudioProcessor::maxSlots))
+        return juce::Result::fail ("No slot " + juce::String (slot) + ", the chain has up to "
+                                   + juce::String ((int) MultieffectsAudioProcessor::maxSlots));
+
+    auto* param = processor.apvts.getParameter (parameterID);
+
+    if (param == nullptr)
+        return juce::Result::fail ("Unknown parameter: " + parameterID);
+
+    float normalisedValue = 0.f;
+    auto result = parseParameterValue (*param, parameterID, value, normalisedValue);
+
+    if (result.wasOk())
+        processor.setSlotParameter ((size_t) slot, processor.getParameters().indexOf (param), normalisedValue);
+
+    return result;
+}
+
+juce::Result OfflineRenderer::loadAutomation (const juce::File& automationFile)
+{
+    if (! automationFile.existsAsFile())
+        return juce::Result::fail ("Automation not found: " + automationFile.getFullPathName());
+
+    juce::StringArray lines;
+    automationFile.readLines (lines);
+
+    std::vector<AutomationPoint> points;
+
+    for (int i = 0; i < lines.size(); ++i)
+    {
+        auto line = lines[i].upToFirstOccurrenceOf ("#", false, false).trim();
+
+        if (line.isEmpty())
+            continue;
+
+        auto tokens = juce::StringArray::fromTokens (line, " \t", "\"");
+        tokens.removeEmptyStrings();
+
+        const auto where = automationFile.getFileName() + ":" + juce::String (i + 1);
+
+        if (tokens.size() != 3 || ! tokens[0].containsOnly ("0123456789.eE+-"))
+            return juce::Result::fail ("Expected <seconds> <parameter id> <value> at " + where);
+
+        auto* param = processor.apvts.getParameter (tokens[1]);
+
+        if (param == nullptr)
+            return juce::Result::fail ("Unknown parameter '" + tokens[1] + "' at " + where);
+
+        AutomationPoint point;
+        point.seconds = juce::jmax (0.0, tokens[0].getDoubleValue());
+        point.parameterIndex = processor.getParameters().indexOf (param);
+
+        auto result = parseParameterValue (*param, tokens[1], tokens[2].unquoted(), point.value);
+
+        if (result.failed())
+            return juce::Result::fail (result.getErrorMessage() + " at " + where);
+
+        points.push_back (point);
+    }
+
+    //stable, so two changes at the same time keep the order of the file and the last one wins
+    std::stable_sort (points.begin(), points.end(),
+                      [] (const AutomationPoint& a, const AutomationPoint& b) { return a.seconds < b.seconds; });
+
+    automation = std::move (points);
+    return juce::Result::ok();
+}
+
+void OfflineRenderer::setControlBlockSize (int numSamples)
+{
+    processor.setControlBlockSize (numSamples);
+}
+
+void OfflineRenderer::setTileSize (int numSamples)
+{
+    processor.setTileSize (numSamples);
+}
+
+void OfflineRenderer::setDSPOrder (const DSP_Order& newOrder)
+{
+    processor.setDSPOrder (newOrder);
+}
+
+void OfflineRenderer::setDSPLinks (const DSP_Links& newLinks)
+{
+    processor.setDSPLinks (newLinks);
+}
+
+juce::Result OfflineRenderer::setDSPChain (const DSP_Chain& newChain)
+{
+    if (! processor.setDSPChain (newChain))
+        return juce::Result::fail ("The chain needs more instances of an effect than the stage pool has ("
+                                   + juce::String (processor.getStagePoolSize()) + "): " + getDSPChainName (newChain));
+
+    return juce::Result::ok();
+}
+
+void OfflineRenderer::setStagePoolSize (int instancesPerOption)
+{
+    processor.setStagePoolSize (instancesPerOption);
+}
+
+void OfflineRenderer::setParallelProcessing (bool shouldRunInParallel)
+{
+    processor.setParallelProcessing (shouldRunInParallel);
+}
+
+void OfflineRenderer::setProfiling (bool shouldProfile)
+{
+    processor.getProfiler().setEnabled (shouldProfile);
+}
+
+juce::String OfflineRenderer::getProfile() const
+{
+    juce::StringArray names;
+
+    for (int i = 0; i < static_cast<int> (DSP_Option::END_OF_LIST); ++i)
+        names.add (getDSPOptionName (static_cast<DSP_Option> (i)));
+
+    return processor.getProfiler().toString (names);
+}
+
+//==============================================================================
+juce::Result OfflineRenderer::render (const juce::File& input, const juce::File& output, RenderStats* stats)
+{
+    std::unique_ptr<juce::AudioFormatReader> reader (formatManager.createReaderFor (input));
+
+    if (reader == nullptr)
+        return juce::Result::fail ("Could not open " + input.getFullPathName());
+
+    const auto numChannels = (int) reader->numChannels;
+    const auto sampleRate = reader->sampleRate;
+
+    if (numChannels < 1 || numChannels > MultieffectsAudioProcessor::maxChannels)
+        return juce::Result::fail ("Only files with up to " + juce::String (MultieffectsAudioProcessor::maxChannels)
+                                   + " channels are supported: " + input.getFullPathName());
+
+    juce::String error;
+    auto writer = createWriter (output, sampleRate, numChannels, (int) reader->bitsPerSample, error);
+
+    if (writer == nullptr)
+        return juce::Result::fail (error);
+
+    //automation moves the parameters, the next render starts from where this one did
+    const auto presetBeforeAutomation = processor.createPreset();
+
+    processor.setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+    processor.prepareToPlay (sampleRate, blockSize);
+    processor.getProfiler().reset();
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    const auto inputLength = reader->lengthInSamples;
+    const auto tailSeconds = juce::jmin (processor.getTailLengthSeconds(), maxTailSeconds);
+    const auto tailLength = renderTail ? (juce::int64) std::ceil (tailSeconds * sampleRate) : 0;
+
+    //oversampling delays the output, the file drops that much from the start and renders as
+    //much longer, so it lines up with the input
+    const auto latency = (juce::int64) processor.getLatencySamples();
+    const auto totalLength = inputLength + tailLength + latency;
+
+    juce::int64 position = 0;
+    juce::int64 samplesToSkip = latency;
+    bool ok = true;
+
+    auto readBlock = [&] (juce::AudioBuffer<float>& buffer)
+    {
+        auto numSamples = (int) juce::jmin ((juce::int64) blockSize, totalLength - position);
+
+        if (numSamples <= 0)
+            return 0;
+
+        //keeps the allocation, only the visible size changes on the last block
+        buffer.setSize (numChannels, numSamples, false, false, true);
+
+        if (position < inputLength)
+            reader->read (&buffer, 0, numSamples, position, true, numChannels > 1);
+        else
+            buffer.clear();
+
+        position += numSamples;
+        return numSamples;
+    };
+
+    auto writeBlock = [&] (const juce::AudioBuffer<float>& buffer)
+    {
+        const auto skip = (int) juce::jmin ((juce::int64) buffer.getNumSamples(), samplesToSkip);
+        samplesToSkip -= skip;
+
+        return skip == buffer.getNumSamples()
+            || writer->writeFromAudioSampleBuffer (buffer, skip, buffer.getNumSamples() - skip);
+    };
+
+    //hands the processor the automation inside a block as parameter events. when a block has more
+    //than fit into one processBlock call, it's split at the first one that didn't
+    size_t nextPoint = 0;
+
+    auto processAutomated = [&] (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi, juce::int64 blockStart)
+    {
+        const auto numSamples = buffer.getNumSamples();
+        auto done = 0;
+
+        while (done < numSamples)
+        {
+            auto end = numSamples;
+
+            for (; nextPoint < automation.size(); ++nextPoint)
+            {
+                const auto& point = automation[nextPoint];
+                const auto offset = (int) juce::jmax ((juce::int64) done, (juce::int64) std::llround (point.seconds * sampleRate) - blockStart);
+
+                if (offset >= end)
+                    break;
+
+                if (! processor.addParameterEvent (offset - done, point.parameterIndex, point.value))
+                {
+                    end = juce::jmax (done + 1, offset);
+                    break;
+                }
+            }
+
+            juce::AudioBuffer<float> part (buffer.getArrayOfWritePointers(), buffer.getNumChannels(), done, end - done);
+            processor.processBlock (part, midi);
+            done = end;
+        }
+    };
+
+    //parallel branches can't be split into pipeline stages, those orders render serially.
+    //the pipeline runs the stages without processBlock, so automation does too
+    std::vector<juce::dsp::ProcessorBase*> stages;
+
+    if (pipelined && automation.empty() && processor.prepareSerialStages (stages))
+    {
+        StagePipeline pipeline (stages, numChannels, blockSize,
+                                processor.getEffectiveTileSize (numChannels));
+
+        ok = pipeline.run (readBlock, writeBlock);
+    }
+    else
+    {
+        juce::AudioBuffer<float> buffer (numChannels, blockSize);
+        juce::MidiBuffer midi;
+
+        while (ok && readBlock (buffer) > 0)
+        {
+            if (automation.empty())
+                processor.processBlock (buffer, midi);
+            else
+                processAutomated (buffer, midi, position - buffer.getNumSamples());
+
+            ok = writeBlock (buffer);
+        }
+    }
+
+    const auto wallSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+    processor.releaseResources();
+    writer.reset();
+
+    if (! automation.empty())
+        processor.applyPreset (presetBeforeAutomation);
+
+    if (! ok)
+        return juce::Result::fail ("Failed writing " + output.getFullPathName());
+
+    if (stats != nullptr)
+    {
+        stats->numSamplesRendered = position;
+        stats->audioSeconds = (double) position / sampleRate;
+        stats->wallSeconds = wallSeconds;
+    }
+
+    return juce::Result::ok();
+}
+
+juce::Result OfflineRenderer::renderBatch (const juce::Array<juce::File>& inputs,
+                                          const juce::Array<juce::File>& outputs,
+                                          const std::vector<BatchChain::Parameters>& laneParameters,
+                                          RenderStats* stats)
+{
+    jassert (inputs.size() == outputs.size());
+
+    if (inputs.isEmpty() || inputs.size() != outputs.size())
+        return juce::Result::fail ("Every batch input needs an output");
+
+    DSP_Order order;
+    DSP_Links links;
+
+    //a batch lane has one instance of every stage
+    if (! processor.getDSPChain().toOrder (order, links))
+        return juce::Result::fail ("Batch renders only run chains with every effect once");
+
+    if (std::find (links.begin(), links.end(), true) != links.end())
+        return juce::Result::fail ("Batch renders don't support parallel branches");
+
+    //the lanes run at the base rate and step the general filter like the biquad, a render with
+    //either setting would come out different. the oversampling filter only matters with
+    //oversampling on, and per slot values only reach repeated effects
+    if (processor.oversampling->getIndex() != 0)
+        return juce::Result::fail ("Batch renders don't oversample");
+
+    if (processor.isCoefficientRamping())
+        return juce::Result::fail ("Batch renders don't ramp filter coefficients");
+
+    juce::OwnedArray<juce::AudioFormatReader> readers;
+    double sampleRate = 0.0;
+    int numChannels = 1;
+
+    for (auto& input : inputs)
+    {
+        auto* reader = readers.add (formatManager.createReaderFor (input));
+
+        if (reader == nullptr)
+            return juce::Result::fail ("Could not open " + input.getFullPathName());
+
+        if (reader->numChannels < 1 || reader->numChannels > 2)
+            return juce::Result::fail ("Only mono or stereo files are supported: " + input.getFullPathName());
+
+        if (sampleRate == 0.0)
+            sampleRate = reader->sampleRate;
+        else if (reader->sampleRate != sampleRate)
+            return juce::Result::fail ("All batch inputs need the same sample rate: " + input.getFullPathName());
+
+        numChannels = juce::jmax (numChannels, (int) reader->numChannels);
+    }
+
+    juce::OwnedArray<juce::AudioFormatWriter> writers;
+
+    for (int i = 0; i < outputs.size(); ++i)
+    {
+        juce::String error;
+        auto writer = createWriter (outputs[i], sampleRate, (int) readers[i]->numChannels,
+                                    (int) readers[i]->bitsPerSample, error);
+
+        if (writer == nullptr)
+            return juce::Result::fail (error);
+
+        writers.add (writer.release());
+    }
+
+    const auto numInstances = inputs.size();
+    const auto sharedParameters = BatchChain::Parameters::fromProcessor (processor);
+
+    BatchChain batch;
+    batch.setDSPOrder (order);
+    batch.setSaturationAccuracy (static_cast<SIMDHelpers::TanhAccuracy> (processor.saturationAccuracy->getIndex()));
+    batch.setControlInterval (processor.getModulationInterval());
+    batch.prepare (sampleRate, numInstances, numChannels);
+
+    //every instance rings for as long as its own parameters make it, the processor isn't
+    //prepared for a batch so its tail would be stale
+    std::vector<juce::int64> tailLengths;
+
+    for (int i = 0; i < numInstances; ++i)
+    {
+        const auto& parameters = (size_t) i < laneParameters.size() ? laneParameters[(size_t) i] : sharedParameters;
+        const auto tailSeconds = juce::jmin (parameters.getTailSeconds(), maxTailSeconds);
+
+        batch.setParameters (i, parameters);
+        tailLengths.push_back (renderTail ? (juce::int64) std::ceil (tailSeconds * sampleRate) : 0);
+    }
+
+    //parameters were set after prepare, start every instance on its targets instead of ramping
+    batch.reset();
+
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    juce::int64 totalLength = 0;
+
+    for (int i = 0; i < numInstances; ++i)
+        totalLength = juce::jmax (totalLength, readers[i]->lengthInSamples + tailLengths[(size_t) i]);
+
+    juce::OwnedArray<juce::AudioBuffer<float>> buffers;
+    std::vector<juce::dsp::AudioBlock<float>> blocks;
+
+    for (int i = 0; i < numInstances; ++i)
+        buffers.add (new juce::AudioBuffer<float> (numChannels, blockSize));
+
+    blocks.reserve ((size_t) numInstances);
+
+    juce::int64 position = 0, numSamplesRendered = 0;
+    bool ok = true;
+
+    while (position < totalLength && ok)
+    {
+        auto numSamples = (int) juce::jmin ((juce::int64) blockSize, totalLength - position);
+
+        blocks.clear();
+
+        for (int i = 0; i < numInstances; ++i)
+        {
+            auto& buffer = *buffers[i];
+            auto* reader = readers[i];
+
+            buffer.setSize (numChannels, numSamples, false, false, true);
+
+            if (position < reader->lengthInSamples)
+            {
+                reader->read (&buffer, 0, numSamples, position, true, reader->numChannels > 1);
+
+                if (reader->numChannels == 1 && numChannels > 1)
+                    buffer.copyFrom (1, 0, buffer, 0, 0, numSamples);
+            }
+            else
+            {
+                buffer.clear();
+            }
+
+            blocks.emplace_back (buffer);
+        }
+
+        batch.process (blocks.data(), numInstances);
+
+        //every file stops at its own length plus its own tail
+        for (int i = 0; i < numInstances && ok; ++i)
+        {
+            const auto end = readers[i]->lengthInSamples + tailLengths[(size_t) i];
+            const auto numToWrite = (int) juce::jlimit ((juce::int64) 0, (juce::int64) numSamples, end - position);
+
+            if (numToWrite > 0)
+            {
+                ok = writers[i]->writeFromAudioSampleBuffer (*buffers[i], 0, numToWrite);
+                numSamplesRendered += numToWrite;
+            }
+        }
+
+        position += numSamples;
+    }
+
+    const auto wallSeconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+    writers.clear();
+
+    if (! ok)
+        return juce::Result::fail ("Failed writing the batch outputs");
+
+    if (stats != nullptr)
+    {
+        stats->numSamplesRendered = numSamplesRendered;
+        stats->audioSeconds = (double) numSamplesRendered / sampleRate;
+        stats->wallSeconds = wallSeconds;
+    }
+
+    return juce::Result::ok();
+}
+
+std::unique_ptr<juce::AudioFormatWriter> OfflineRenderer::createWriter (const juce::File& output, double sampleRate,
+                                                                        int numChannels, int sourceBitsPerSample,
+                                                                        juce::String& error)
+{
+    auto* format = formatManager.findFormatForFileExtension (output.getFileExtension());
+
+    if (format == nullptr || ! format->isChannelLayoutSupported (juce::AudioChannelSet::canonicalChannelSet (numChannels)))
+    {
+        error = "Unsupported output format: " + output.getFullPathName();
+        return {};
+    }
+
+    auto bits = bitsPerSample > 0 ? bitsPerSample : sourceBitsPerSample;
+    auto possibleBitDepths = format->getPossibleBitDepths();
+
+    if (! possibleBitDepths.contains (bits))
+        bits = possibleBitDepths.getLast();
+
+    output.getParentDirectory().createDirectory();
+    output.deleteFile();
+
+    auto stream = output.createOutputStream();
+
+    if (stream == nullptr || stream->failedToOpen())
+    {
+        error = "Could not create " + output.getFullPathName();
+        return {};
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> writer (format->createWriterFor (stream.get(),
+                                                                              sampleRate,
+                                                                              (unsigned int) numChannels,
+                                                                              bits,
+                                                                              {},
+                                                                              0));
+
+    if (writer == nullptr)
+    {
+        error = "Could not create a writer for " + output.getFullPathName();
+        return {};
+    }
+
+    //the writer owns the stream now
+    stream.release();
+    return writer;
+}
+
+//==============================================================================
+juce::String OfflineRenderer::getDSPOptionName (DSP_Option option)
+{
+    switch (option)
+    {
+    case DSP_Option::Phase:
+        return "phaser";
+    case DSP_Option::Chorus:
+        return "chorus";
+    case DSP_Option::Overdrive:
+        return "overdrive";
+    case DSP_Option::LadderFilter:
+        return "ladder";
+    case DSP_Option::GeneralFilter:
+        return "filter";
+    case DSP_Option::Delay:
+        return "delay";
+    case DSP_Option::END_OF_LIST:
+        break;
+    }
+
+    jassertfalse;
+    return {};
+}
+
+juce::String OfflineRenderer::getDSPOrderName (const DSP_Order& order, const DSP_Links& links)
+{
+    return getDSPChainName (DSP_Chain::fromOrder (order, links));
+}
+
+juce::String OfflineRenderer::getDSPChainName (const DSP_Chain& chain)
+{
+    juce::String name;
+
+    for (size_t i = 0; i < chain.numSlots; ++i)
+    {
+        if (i > 0)
+            name << (chain.links[i] ? "|" : ",");
+
+        name << getDSPOptionName (chain.options[i]);
+    }
+
+    return name;
+}
+
+std::optional<OfflineRenderer::DSP_Order> OfflineRenderer::parseDSPOrder (const juce::String& text, DSP_Links* links)
+{
+    auto chain = parseDSPChain (text);
+    DSP_Order order;
+    DSP_Links parsedLinks;
+
+    if (! chain.has_value() || ! chain->toOrder (order, parsedLinks))
+        return std::nullopt;
+
+    if (links != nullptr)
+        *links = parsedLinks;
+
+    return order;
+}
+
+std::optional<OfflineRenderer::DSP_Chain> OfflineRenderer::parseDSPChain (const juce::String& text)
+{
+    auto tokens = juce::StringArray::fromTokens (text, ",|", "");
+    tokens.trim();
+
+    DSP_Chain chain;
+
+    if (tokens.isEmpty() || tokens.size() > (int) chain.options.size())
+        return std::nullopt;
+
+    chain.numSlots = (size_t) tokens.size();
+
+    //the separators in order, a '|' links the effect after it to the one before
+    for (size_t i = 0, slot = 1; i < (size_t) text.length(); ++i)
+    {
+        const auto c = text[(int) i];
+
+        if (c != '|' && c != ',')
+            continue;
+
+        if (slot >= chain.numSlots)
+            return std::nullopt;
+
+        chain.links[slot++] = c == '|';
+    }
+
+    for (size_t i = 0; i < chain.numSlots; ++i)
+    {
+        auto found = false;
+
+        for (size_t o = 0; o < (size_t) DSP_Option::END_OF_LIST; ++o)
+        {
+            auto option = static_cast<DSP_Option> (o);
+
+            if (tokens[(int) i].equalsIgnoreCase (getDSPOptionName (option)))
+            {
+                chain.options[i] = option;
+                found = true;
+                break;
+            }
+        }
+
+        if (! found)
+            return std::nullopt;
+    }
+
+    return chain;
+}
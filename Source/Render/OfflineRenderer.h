@@ -0,0 +1,204 @@
+/*
+  ==============================================================================
+
+    OfflineRenderer.h
+
+    Headless render engine: streams audio files through a
+    MultieffectsAudioProcessor with no audio device and no editor.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../PluginProcessor.h"
+#include "../Batch/BatchChain.h"
+#include "../Preset/PresetBank.h"
+
+//==============================================================================
+/**
+    Drives a MultieffectsAudioProcessor from audio files as fast as the CPU
+    allows. The processor is prepared in non-realtime mode with a large internal
+    block size, so a render node spends its time in processBlock instead of
+    waiting on a device callback.
+*/
+class OfflineRenderer
+{
+public:
+    using DSP_Option = MultieffectsAudioProcessor::DSP_Option;
+    using DSP_Order = MultieffectsAudioProcessor::DSP_Order;
+    using DSP_Links = MultieffectsAudioProcessor::DSP_Links;
+    using DSP_Chain = MultieffectsAudioProcessor::DSP_Chain;
+
+    struct RenderStats
+    {
+        juce::int64 numSamplesRendered = 0;
+        double audioSeconds = 0.0;
+        double wallSeconds = 0.0;
+
+        double getRealtimeFactor() const { return wallSeconds > 0.0 ? audioSeconds / wallSeconds : 0.0; }
+    };
+
+    OfflineRenderer();
+    ~OfflineRenderer();
+
+    //==============================================================================
+    /** Number of samples pushed through processBlock per call. */
+    void setBlockSize (int newBlockSize);
+    int getBlockSize() const { return blockSize; }
+
+    /** Size of the tiles the chain runs on inside each block, 0 processes whole
+        blocks stage by stage and MultieffectsAudioProcessor::autoTileSize (the
+        default) picks an L1 sized tile.
+    */
+    void setTileSize (int numSamples);
+
+    /** Bit depth of the written file, 0 keeps the bit depth of the source. */
+    void setBitsPerSample (int newBitsPerSample) { bitsPerSample = newBitsPerSample; }
+
+    /** When enabled the output is extended by the processor's tail length, up to
+        maxTailSeconds. A self oscillating chain has an infinite tail.
+    */
+    static constexpr double maxTailSeconds = 60.0;
+    void setRenderTail (bool shouldRenderTail) { renderTail = shouldRenderTail; }
+
+    /** Runs every stage of the chain on its own thread, see StagePipeline. The
+        output is the same as without, orders with parallel branches ignore it.
+        Renders run every stage on every block, tail skipping is for idle tracks
+        in a session and would make the two differ on silence.
+    */
+    void setPipelined (bool shouldPipeline) { pipelined = shouldPipeline; }
+
+    //==============================================================================
+    /** Loads an XML preset (the apvts state as XML), a BinaryPreset file or a
+        binary state blob as written by getStateInformation().
+    */
+    juce::Result loadPreset (const juce::File& presetFile);
+
+    /** Loads one preset of a PresetBank, by name or by index. */
+    juce::Result loadPresetFromBank (const juce::File& bankFile, const juce::String& nameOrIndex);
+
+    /** Writes the current parameters and order as a BinaryPreset file. */
+    juce::Result savePreset (const juce::File& presetFile, const juce::String& name);
+
+    /** Loads every preset file in turn and writes them all to one bank, named after the files. */
+    juce::Result writeBank (const juce::Array<juce::File>& presetFiles, const juce::File& bankFile);
+
+    /** Sets a parameter by its ID using its real (not normalised) value.
+        Choice parameters take the choice index or the choice name.
+    */
+    juce::Result setParameter (const juce::String& parameterID, const juce::String& value);
+
+    /** Like setParameter, for a slot that repeats an effect, see
+        MultieffectsAudioProcessor::setSlotParameter.
+    */
+    juce::Result setSlotParameter (int slot, const juce::String& parameterID, const juce::String& value);
+
+    /** Loads parameter changes for render() from a text file, one per line:
+        "<seconds> <parameter id> <value>", values like setParameter() takes them
+        and # starts a comment. They're handed to the processor as parameter
+        events at the sample they fall on, so pipelined renders go through
+        processBlock while there's automation. Each render starts from the
+        parameters before it, batch renders ignore the automation.
+    */
+    juce::Result loadAutomation (const juce::File& automationFile);
+
+    /** See MultieffectsAudioProcessor::setControlBlockSize. */
+    void setControlBlockSize (int numSamples);
+
+    void setDSPOrder (const DSP_Order& newOrder);
+
+    /** Runs linked slots as parallel branches, see MultieffectsAudioProcessor::DSP_Links.
+        Batch renders only do serial chains.
+    */
+    void setDSPLinks (const DSP_Links& newLinks);
+
+    /** A chain of any length that can repeat effects, see MultieffectsAudioProcessor::setDSPChain.
+        Fails when it needs more instances than the stage pool has. Batch renders only do
+        chains with every effect once.
+    */
+    juce::Result setDSPChain (const DSP_Chain& newChain);
+
+    /** Instances of every effect, takes effect when the next render prepares the processor. */
+    void setStagePoolSize (int instancesPerOption);
+
+    /** Turns the worker threads for parallel branches on or off. */
+    void setParallelProcessing (bool shouldRunInParallel);
+
+    /** Times every stage of processBlock, see StageProfiler. Each render starts
+        from empty histograms. Pipelined and batch renders don't go through
+        processBlock, so they leave them empty.
+    */
+    void setProfiling (bool shouldProfile);
+
+    /** The profiler's table for the last render, with the stages named. */
+    juce::String getProfile() const;
+
+    //==============================================================================
+    /** Renders one file of up to MultieffectsAudioProcessor::maxChannels channels, the
+        processor's bus takes the file's channel count. The output format is picked
+        from the output file extension. The processor's latency (linear phase
+        oversampling) is compensated, the output lines up with the input.
+    */
+    juce::Result render (const juce::File& input, const juce::File& output, RenderStats* stats = nullptr);
+
+    /** Renders several files at once through a BatchChain, one instance per
+        file. Every instance uses the renderer's current parameters (preset and
+        setParameter()) unless laneParameters has an entry for it. All inputs
+        need the same sample rate and be mono or stereo, mono inputs are rendered
+        as dual mono when stereo files are in the batch. With setRenderTail every
+        file gets the tail of its own instance's parameters. Fails with oversampling
+        or coefficient ramping on, the lanes only do what render() does without them.
+    */
+    juce::Result renderBatch (const juce::Array<juce::File>& inputs,
+                              const juce::Array<juce::File>& outputs,
+                              const std::vector<BatchChain::Parameters>& laneParameters = {},
+                              RenderStats* stats = nullptr);
+
+    MultieffectsAudioProcessor& getProcessor() { return processor; }
+    juce::AudioFormatManager& getFormatManager() { return formatManager; }
+
+    //==============================================================================
+    static juce::String getDSPOptionName (DSP_Option option);
+    static juce::String getDSPOrderName (const DSP_Order& order, const DSP_Links& links = {});
+    static juce::String getDSPChainName (const DSP_Chain& chain);
+
+    /** Parses a comma separated list like "phaser,chorus,overdrive,ladder,filter,delay".
+        Every effect has to appear exactly once. A '|' instead of a comma puts two
+        effects side by side, "phaser|chorus,overdrive,..." runs the phaser and the
+        chorus in parallel, and the links are written to links when it isn't null.
+    */
+    static std::optional<DSP_Order> parseDSPOrder (const juce::String& text, DSP_Links* links = nullptr);
+
+    /** The same list with 1 to MultieffectsAudioProcessor::maxSlots effects in any
+        order, repeats included, like "filter,overdrive,filter". Doesn't check the
+        chain against the stage pool.
+    */
+    static std::optional<DSP_Chain> parseDSPChain (const juce::String& text);
+
+private:
+    std::unique_ptr<juce::AudioFormatWriter> createWriter (const juce::File& output, double sampleRate,
+                                                           int numChannels, int sourceBitsPerSample,
+                                                           juce::String& error);
+
+    struct AutomationPoint
+    {
+        double seconds = 0.0;
+        int parameterIndex = 0;
+        float value = 0.f;
+    };
+
+    juce::AudioFormatManager formatManager;
+    MultieffectsAudioProcessor processor;
+
+    //sorted by time
+    std::vector<AutomationPoint> automation;
+
+    int blockSize = 16384;
+    int bitsPerSample = 0;
+    bool renderTail = true;
+    bool pipelined = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OfflineRenderer)
+};
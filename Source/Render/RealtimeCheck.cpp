@@ -0,0 +1,387 @@
+/*
+  ==============================================================================
+
+    RealtimeCheck.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeCheck.h"
+
+//==============================================================================
+//runs on whichever thread broke the rules, the audio thread or a branch worker,
+//with the checks lifted, so it can lock and allocate
+struct RealtimeCheck::Collector
+{
+    struct Entry
+    {
+        juce::String scenario;
+        juce::String what;
+        juce::String backtrace;
+        int count = 0;
+    };
+
+    static void handle (const RealtimeSafety::Violation& violation, void* context)
+    {
+        auto& self = *static_cast<Collector*> (context);
+        const juce::ScopedLock sl (self.lock);
+
+        const auto key = juce::String (violation.what) + violation.backtrace;
+        auto found = self.indexByKey.find (key);
+
+        if (found == self.indexByKey.end())
+        {
+            found = self.indexByKey.emplace (key, self.entries.size()).first;
+            self.entries.push_back ({ self.scenario, violation.what, violation.backtrace, 0 });
+        }
+
+        ++self.entries[found->second].count;
+    }
+
+    void setScenario (const juce::String& name)
+    {
+        const juce::ScopedLock sl (lock);
+        scenario = name;
+    }
+
+    juce::CriticalSection lock;
+    juce::String scenario;
+    std::vector<Entry> entries;
+    std::unordered_map<juce::String, size_t> indexByKey;
+};
+
+//==============================================================================
+RealtimeCheck::RealtimeCheck (MultieffectsAudioProcessor& processorToCheck)
+    : processor (processorToCheck)
+{
+}
+
+juce::Result RealtimeCheck::run (Report& report)
+{
+    if (! RealtimeSafety::isEnabled())
+        return juce::Result::fail ("The realtime checks are compiled out, build with MULTIEFFECTS_ENABLE_RT_CHECKS=1");
+
+    report = Report();
+
+    Collector violations;
+    collector = &violations;
+    currentReport = &report;
+
+    const auto savedPreset = processor.createPreset();
+    const auto savedParallel = processor.isParallelProcessing();
+    const auto savedNonRealtime = processor.isNonRealtime();
+    const auto violationsBefore = RealtimeSafety::getNumViolations();
+
+    RealtimeSafety::setViolationHandler (&Collector::handle, &violations);
+
+    //prepared like a host prepares it, not like the offline renderer
+    processor.setNonRealtime (false);
+
+    struct Pass
+    {
+        const char* name;
+        bool parallel;
+        int numChannels;
+    };
+
+    //stereo with and without workers, and a 7.1.4 bus for the lane packing past one register
+    for (auto pass : { Pass { "workers", true, 2 }, Pass { "no workers", false, 2 }, Pass { "7.1.4, workers", true, 12 } })
+    {
+        passName = pass.name;
+        numChannels = pass.numChannels;
+
+        processor.setPlayConfigDetails (numChannels, numChannels, sampleRate, blockSize);
+        buffer.setSize (numChannels, blockSize);
+
+        processor.setParallelProcessing (pass.parallel);
+        processor.applyPreset (savedPreset);
+        processor.prepareToPlay (sampleRate, blockSize);
+
+        checkOrders();
+        checkLinks();
+        checkChoices();
+        checkAutomation();
+        checkPresets();
+        checkChains();
+
+        processor.releaseResources();
+    }
+
+    RealtimeSafety::setViolationHandler (nullptr, nullptr);
+
+    report.numViolations = RealtimeSafety::getNumViolations() - violationsBefore;
+
+    for (auto& entry : violations.entries)
+        report.details.add (entry.what + " x" + juce::String (entry.count)
+                            + " (first in " + entry.scenario + ")\n" + entry.backtrace);
+
+    processor.setNonRealtime (savedNonRealtime);
+    processor.setParallelProcessing (savedParallel);
+    processor.applyPreset (savedPreset);
+
+    collector = nullptr;
+    currentReport = nullptr;
+
+    return juce::Result::ok();
+}
+
+//==============================================================================
+void RealtimeCheck::runScenario (const juce::String& name, int numBlocks, const std::function<void (int)>& beforeBlock)
+{
+    collector->setScenario (name + " (" + passName + ")");
+
+    //hosts don't promise full blocks, so the size changes every block
+    const int blockSizes[] = { blockSize, 1, juce::jmax (1, blockSize / 3), juce::jmax (1, blockSize - 1) };
+
+    for (int i = 0; i < numBlocks; ++i)
+    {
+        //parameters change between blocks like host automation, off the audio thread, and
+        //what the last block changed reaches the host like the processor's timer hands it over
+        if (beforeBlock != nullptr)
+            beforeBlock (i);
+
+        processor.updateHost();
+
+        const auto numSamples = blockSizes[(size_t) i % std::size (blockSizes)];
+        buffer.setSize (numChannels, numSamples, false, false, true);
+
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            for (int sample = 0; sample < numSamples; ++sample)
+                buffer.setSample (channel, sample, random.nextFloat() * 2.f - 1.f);
+
+        processor.processBlock (buffer, midi);
+    }
+
+    ++currentReport->numScenarios;
+    currentReport->numBlocks += numBlocks;
+}
+
+void RealtimeCheck::checkOrders()
+{
+    using DSP_Option = MultieffectsAudioProcessor::DSP_Option;
+    using DSP_Order = MultieffectsAudioProcessor::DSP_Order;
+
+    DSP_Order order;
+
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = static_cast<DSP_Option> (i);
+
+    //every effect gets a turn at the front of the chain, the first block after a
+    //change also runs the switch to the new chain function
+    for (size_t first = 0; first < order.size(); ++first)
+    {
+        processor.setDSPLinks ({});
+        processor.setDSPOrder (order);
+
+        runScenario ("order " + juce::String ((int) first), 16, nullptr);
+
+        std::rotate (order.begin(), order.begin() + 1, order.end());
+    }
+}
+
+void RealtimeCheck::checkLinks()
+{
+    using DSP_Links = MultieffectsAudioProcessor::DSP_Links;
+
+    //every pair of neighbours side by side, then everything in parallel
+    for (size_t slot = 1; slot < std::tuple_size_v<DSP_Links>; ++slot)
+    {
+        DSP_Links links{};
+        links[slot] = true;
+
+        processor.setDSPLinks (links);
+        runScenario ("parallel slots " + juce::String ((int) slot - 1) + "|" + juce::String ((int) slot), 16, nullptr);
+    }
+
+    DSP_Links allLinked;
+    allLinked.fill (true);
+
+    processor.setDSPLinks (allLinked);
+    runScenario ("all parallel", 16, nullptr);
+
+    processor.setDSPLinks ({});
+}
+
+void RealtimeCheck::checkChoices()
+{
+    //filter modes, oversampling, saturation accuracy and delay sync, while the rest moves
+    for (auto* param : processor.getParameters())
+    {
+        auto* choice = dynamic_cast<juce::AudioParameterChoice*> (param);
+
+        if (choice == nullptr)
+            continue;
+
+        const auto savedValue = choice->getValue();
+
+        for (int index = 0; index < choice->choices.size(); ++index)
+        {
+            choice->setValueNotifyingHost (choice->convertTo0to1 ((float) index));
+
+            runScenario (choice->getParameterID() + " = " + choice->choices[index], 8,
+                         [this] (int) { randomiseFloatParameters(); });
+        }
+
+        choice->setValueNotifyingHost (savedValue);
+    }
+}
+
+void RealtimeCheck::checkAutomation()
+{
+    constexpr int numSteps = 32;
+
+    for (auto* param : processor.getParameters())
+    {
+        auto* ranged = dynamic_cast<juce::AudioParameterFloat*> (param);
+
+        if (ranged == nullptr)
+            continue;
+
+        const auto savedValue = ranged->getValue();
+
+        //one sweep across the whole range, a new value every block
+        runScenario ("automating " + ranged->getParameterID(), numSteps, [ranged] (int block)
+        {
+            ranged->setValueNotifyingHost ((float) block / (float) (numSteps - 1));
+        });
+
+        ranged->setValueNotifyingHost (savedValue);
+    }
+
+    //everything at once, choices too
+    runScenario ("automating everything", 64, [this] (int)
+    {
+        for (auto* param : processor.getParameters())
+            param->setValueNotifyingHost (random.nextFloat());
+    });
+
+    //sample accurate automation, up to a full event list per block at random offsets. the
+    //parameters catch up in updateHost between blocks
+    const auto numParameters = processor.getParameters().size();
+
+    runScenario ("parameter events", 32, [this, numParameters] (int block)
+    {
+        const auto numEvents = block % 4 == 3 ? ParameterEventList::capacity : 1 + random.nextInt (32);
+
+        for (int i = 0; i < numEvents; ++i)
+            processor.addParameterEvent (random.nextInt (blockSize), random.nextInt (numParameters), random.nextFloat());
+    });
+
+    //the filters on stepped coefficients, switched over while they're moving
+    const auto savedRamping = processor.isCoefficientRamping();
+
+    runScenario ("automating with coefficient ramping switched", 32, [this] (int block)
+    {
+        processor.setCoefficientRamping (block % 8 >= 4);
+        randomiseFloatParameters();
+    });
+
+    processor.setCoefficientRamping (savedRamping);
+}
+
+void RealtimeCheck::checkPresets()
+{
+    const auto savedPreset = processor.createPreset();
+
+    //a new preset every block, with its own order and links
+    runScenario ("queued presets", 32, [this, &savedPreset] (int)
+    {
+        processor.queuePreset (makeRandomPreset (savedPreset));
+    });
+
+    //presets and chains pushed in either order around the same block, the routing set last wins
+    runScenario ("queued presets and chains", 32, [this, &savedPreset] (int)
+    {
+        const auto chainFirst = random.nextBool();
+
+        if (chainFirst)
+            processor.setDSPChain (makeRandomChain());
+
+        processor.queuePreset (makeRandomPreset (savedPreset));
+
+        if (! chainFirst)
+            processor.setDSPChain (makeRandomChain());
+    });
+
+    processor.applyPreset (savedPreset);
+}
+
+void RealtimeCheck::checkChains()
+{
+    const auto savedPreset = processor.createPreset();
+    const auto numParameters = processor.getParameters().size();
+
+    //a new chain every block, any length with every effect as often as the pool allows,
+    //so instances go in and out of use while the slots' own parameters move
+    runScenario ("variable chains", 64, [this, numParameters] (int)
+    {
+        const auto chain = makeRandomChain();
+        processor.setDSPChain (chain);
+
+        for (size_t slot = 0; slot < chain.numSlots; ++slot)
+            processor.setSlotParameter (slot, random.nextInt (numParameters), random.nextFloat());
+    });
+
+    processor.applyPreset (savedPreset);
+}
+
+BinaryPreset::Record RealtimeCheck::makeRandomPreset (const BinaryPreset::Record& layout)
+{
+    using DSP_Order = MultieffectsAudioProcessor::DSP_Order;
+
+    auto preset = layout;
+
+    for (juce::uint32 i = 0; i < preset.numParameters; ++i)
+        preset.values[i] = random.nextFloat();
+
+    std::array<int, std::tuple_size_v<DSP_Order>> slots;
+    std::iota (slots.begin(), slots.end(), 0);
+
+    for (size_t i = slots.size() - 1; i > 0; --i)
+        std::swap (slots[i], slots[(size_t) random.nextInt ((int) i + 1)]);
+
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+        preset.order[i] = (juce::uint8) slots[i];
+        preset.links[i] = (juce::uint8) (i > 0 && random.nextBool() ? 1 : 0);
+    }
+
+    return preset;
+}
+
+MultieffectsAudioProcessor::DSP_Chain RealtimeCheck::makeRandomChain()
+{
+    using DSP_Option = MultieffectsAudioProcessor::DSP_Option;
+
+    const auto numOptions = (int) DSP_Option::END_OF_LIST;
+    const auto poolSize = processor.getStagePoolSize();
+    const auto numSlots = 1 + random.nextInt ((int) MultieffectsAudioProcessor::maxSlots);
+
+    MultieffectsAudioProcessor::DSP_Chain chain;
+    std::array<int, (size_t) DSP_Option::END_OF_LIST> counts{};
+
+    while (chain.numSlots < (size_t) numSlots)
+    {
+        const auto option = random.nextInt (numOptions);
+
+        //the pool fills up before the chain does when it's small
+        if (std::all_of (counts.begin(), counts.end(), [poolSize] (int c) { return c >= poolSize; }))
+            break;
+
+        if (counts[(size_t) option] >= poolSize)
+            continue;
+
+        ++counts[(size_t) option];
+        chain.links[chain.numSlots] = chain.numSlots > 0 && random.nextInt (4) == 0;
+        chain.options[chain.numSlots++] = static_cast<DSP_Option> (option);
+    }
+
+    return chain;
+}
+
+void RealtimeCheck::randomiseFloatParameters()
+{
+    for (auto* param : processor.getParameters())
+        if (dynamic_cast<juce::AudioParameterFloat*> (param) != nullptr)
+            param->setValueNotifyingHost (random.nextFloat());
+}
@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+    RealtimeCheck.h
+
+    Drives a MultieffectsAudioProcessor through every effect, mode and
+    automation path with the realtime safety checks on.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../PluginProcessor.h"
+#include "../Utility/RealtimeSafety.h"
+
+//==============================================================================
+/**
+    Prepares the processor like a host would, realtime and with small blocks
+    of changing size, and runs a list of scenarios through processBlock while
+    parameters change between blocks the way host automation changes them:
+
+    - every effect first in the chain, and every pair of neighbours in parallel
+    - every choice of every choice parameter, filter modes, oversampling,
+      saturation accuracy and delay sync, with the other parameters automated
+    - every float parameter ramped across its range on its own, and sample
+      accurate parameter events at random offsets
+    - a new preset queued every block, with random values and routing, also
+      with a new chain pushed before or after it
+    - a new chain every block, of any length and with effects repeated from the
+      stage pool
+
+    Everything runs in stereo with the parallel branch workers and without, and
+    once more on a 12 channel (7.1.4) bus.
+    Any allocation, lock or blocking call inside processBlock is a violation,
+    see RealtimeSafety. Needs a build with MULTIEFFECTS_ENABLE_RT_CHECKS.
+    The processor passes all of it, a violation is a regression.
+*/
+class RealtimeCheck
+{
+public:
+    struct Report
+    {
+        int numScenarios = 0;
+        int numBlocks = 0;
+        juce::uint64 numViolations = 0;
+
+        //one entry per distinct backtrace, with the scenario it first showed up in
+        juce::StringArray details;
+    };
+
+    explicit RealtimeCheck (MultieffectsAudioProcessor& processorToCheck);
+
+    void setSampleRate (double newSampleRate) { sampleRate = newSampleRate; }
+    void setBlockSize (int newBlockSize) { blockSize = juce::jmax (1, newBlockSize); }
+
+    /** Fails when the checks are compiled out. A run with violations still
+        succeeds, they're in the report. The processor's parameters and chain are
+        put back afterwards.
+    */
+    juce::Result run (Report& report);
+
+private:
+    struct Collector;
+
+    void runScenario (const juce::String& name, int numBlocks, const std::function<void (int)>& beforeBlock);
+
+    void checkOrders();
+    void checkLinks();
+    void checkChoices();
+    void checkAutomation();
+    void checkPresets();
+    void checkChains();
+
+    void randomiseFloatParameters();
+
+    //a preset with layout's parameter layout, random values and a random order with links
+    BinaryPreset::Record makeRandomPreset (const BinaryPreset::Record& layout);
+
+    //any length, every effect as often as the stage pool allows
+    MultieffectsAudioProcessor::DSP_Chain makeRandomChain();
+
+    MultieffectsAudioProcessor& processor;
+    Collector* collector = nullptr;
+    Report* currentReport = nullptr;
+
+    juce::String passName;
+    juce::AudioBuffer<float> buffer;
+    juce::MidiBuffer midi;
+    juce::Random random { 0x5eed };
+
+    double sampleRate = 48000.0;
+    int blockSize = 256, numChannels = 2;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RealtimeCheck)
+};
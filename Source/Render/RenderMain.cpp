@@ -0,0 +1,377 @@
+/*
+  ==============================================================================
+
+    RenderMain.cpp
+
+    Command line front end for the OfflineRenderer.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "OfflineRenderer.h"
+#include "RealtimeCheck.h"
+
+namespace
+{
+    void printUsage()
+    {
+        std::cout
+            << "usage: multieffects-render [options] <input>... \n"
+               "\n"
+               "  -o, --output <file>        output file (single input only)\n"
+               "  --output-dir <dir>         output directory, keeps the input file names\n"
+               "  --format <wav|flac>        output format when using --output-dir (default: input format)\n"
+               "  --preset <file>            xml, binary preset or binary state to load before rendering\n"
+               "  --preset-bank <file>       binary preset bank to take the --bank-preset from\n"
+               "  --bank-preset <name|index> preset in the bank to load before rendering\n"
+               "  --save-preset <file>       write the settings as a binary preset, inputs are optional\n"
+               "  --make-bank <file>         write the input files, which are presets, to one bank and exit\n"
+               "  --order <a,b,c,...>        dsp chain, e.g. phaser,chorus,overdrive,ladder,filter,delay\n"
+               "                             a | instead of a comma runs two effects in parallel, e.g. phaser|chorus,...\n"
+               "                             up to 16 effects, a repeated one gets its own instance, e.g. filter,overdrive,filter\n"
+               "  --stage-pool <n>           instances of every effect a chain can use (default 2)\n"
+               "  --slot-set <slot>:<id>=<value>  set a parameter of a repeated effect, slots count from 0, can be repeated\n"
+               "  --serial                   run parallel branches one after the other on one thread\n"
+               "  --pipeline                 run each effect on its own thread, same output as without\n"
+               "  --set <id>=<value>         set a parameter, can be repeated\n"
+               "  --automation <file>        sample accurate parameter changes, one '<seconds> <id> <value>' per line\n"
+               "  --control-block <samples>  how often parameters are applied and filter sweeps step, 0 once per block (default 32)\n"
+               "  --block-size <samples>     internal block size (default 16384)\n"
+               "  --tile-size <samples|auto> run the chain on cache sized tiles, 0 turns it off (default auto)\n"
+               "  --bits <n>                 output bit depth (default: same as input)\n"
+               "  --no-tail                  don't render the effect tail after the input ends\n"
+               "  --batch                    render all inputs together, one simd lane per input\n"
+               "  --lane-preset <file>       preset for the next batch input, can be repeated\n"
+               "  --list-params              print all parameter IDs and exit\n"
+               "  --profile                  print the time every effect took, as a share of the block's duration\n"
+               "  --rt-check                 run every effect, mode and automation through processBlock and report\n"
+               "                             anything that allocates, locks or blocks, needs MULTIEFFECTS_ENABLE_RT_CHECKS\n"
+               "                             (uses --block-size if given, otherwise 256)\n"
+            << std::endl;
+    }
+
+    int fail (const juce::String& message)
+    {
+        std::cerr << "error: " << message << std::endl;
+        return 1;
+    }
+
+    void listParameters (MultieffectsAudioProcessor& processor)
+    {
+        for (auto* param : processor.getParameters())
+        {
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*> (param))
+            {
+                auto range = ranged->getNormalisableRange();
+                std::cout << ranged->getParameterID() << "  ["
+                          << range.start << " .. " << range.end << "]  default "
+                          << range.convertFrom0to1 (ranged->getDefaultValue()) << std::endl;
+            }
+        }
+    }
+
+    int runRealtimeCheck (MultieffectsAudioProcessor& processor, int blockSize)
+    {
+        RealtimeCheck check (processor);
+        check.setBlockSize (blockSize);
+
+        RealtimeCheck::Report report;
+        auto result = check.run (report);
+
+        if (result.failed())
+            return fail (result.getErrorMessage());
+
+        for (auto& detail : report.details)
+            std::cout << detail << std::endl;
+
+        std::cout << report.numScenarios << " scenarios, " << report.numBlocks << " blocks, "
+                  << (juce::int64) report.numViolations << " realtime violations at "
+                  << report.details.size() << " call sites" << std::endl;
+
+        return report.numViolations == 0 ? 0 : 1;
+    }
+}
+
+int main (int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args (argc, argv);
+
+    if (args.size() == 0 || args.containsOption ("--help|-h"))
+    {
+        printUsage();
+        return args.size() == 0 ? 1 : 0;
+    }
+
+    OfflineRenderer renderer;
+
+    if (args.removeOptionIfFound ("--list-params"))
+    {
+        listParameters (renderer.getProcessor());
+        return 0;
+    }
+
+    juce::File outputFile, outputDir;
+    juce::String outputFormat;
+    juce::Array<juce::File> lanePresets;
+
+    if (args.containsOption ("--output|-o"))
+        outputFile = juce::File::getCurrentWorkingDirectory().getChildFile (args.removeValueForOption ("--output|-o"));
+
+    if (args.containsOption ("--output-dir"))
+        outputDir = juce::File::getCurrentWorkingDirectory().getChildFile (args.removeValueForOption ("--output-dir"));
+
+    if (args.containsOption ("--format"))
+        outputFormat = args.removeValueForOption ("--format").trimCharactersAtStart (".");
+
+    const auto hasBlockSize = args.containsOption ("--block-size");
+
+    if (hasBlockSize)
+        renderer.setBlockSize (args.removeValueForOption ("--block-size").getIntValue());
+
+    if (args.containsOption ("--tile-size"))
+    {
+        auto tile = args.removeValueForOption ("--tile-size");
+
+        if (tile != "auto" && (tile.isEmpty() || ! tile.containsOnly ("0123456789")))
+            return fail ("Invalid --tile-size, expected a number of samples or auto: " + tile);
+
+        renderer.setTileSize (tile == "auto" ? MultieffectsAudioProcessor::autoTileSize : tile.getIntValue());
+    }
+
+    if (args.containsOption ("--control-block"))
+        renderer.setControlBlockSize (args.removeValueForOption ("--control-block").getIntValue());
+
+    if (args.containsOption ("--bits"))
+        renderer.setBitsPerSample (args.removeValueForOption ("--bits").getIntValue());
+
+    if (args.removeOptionIfFound ("--no-tail"))
+        renderer.setRenderTail (false);
+
+    if (args.removeOptionIfFound ("--serial"))
+        renderer.setParallelProcessing (false);
+
+    if (args.removeOptionIfFound ("--pipeline"))
+        renderer.setPipelined (true);
+
+    //before the preset and --order, the chains in them are checked against it
+    if (args.containsOption ("--stage-pool"))
+        renderer.setStagePoolSize (args.removeValueForOption ("--stage-pool").getIntValue());
+
+    const auto batch = args.removeOptionIfFound ("--batch");
+    const auto profile = args.removeOptionIfFound ("--profile");
+
+    if (profile)
+        renderer.setProfiling (true);
+    const auto rtCheck = args.removeOptionIfFound ("--rt-check");
+
+    while (args.containsOption ("--lane-preset"))
+        lanePresets.add (juce::File::getCurrentWorkingDirectory().getChildFile (args.removeValueForOption ("--lane-preset")));
+
+    if (args.containsOption ("--make-bank"))
+    {
+        auto bankFile = juce::File::getCurrentWorkingDirectory().getChildFile (args.removeValueForOption ("--make-bank"));
+        juce::Array<juce::File> presetFiles;
+
+        for (auto& arg : args.arguments)
+            presetFiles.add (arg.resolveAsFile());
+
+        auto result = renderer.writeBank (presetFiles, bankFile);
+
+        if (result.failed())
+            return fail (result.getErrorMessage());
+
+        std::cout << presetFiles.size() << " presets -> " << bankFile.getFullPathName() << std::endl;
+        return 0;
+    }
+
+    //the preset goes first so --set, --order and --slot-set can override it
+    if (args.containsOption ("--preset"))
+    {
+        auto result = renderer.loadPreset (juce::File::getCurrentWorkingDirectory()
+                                               .getChildFile (args.removeValueForOption ("--preset")));
+
+        if (result.failed())
+            return fail (result.getErrorMessage());
+    }
+
+    if (args.containsOption ("--preset-bank"))
+    {
+        auto bankFile = juce::File::getCurrentWorkingDirectory().getChildFile (args.removeValueForOption ("--preset-bank"));
+
+        if (! args.containsOption ("--bank-preset"))
+            return fail ("--preset-bank needs a --bank-preset");
+
+        auto result = renderer.loadPresetFromBank (bankFile, args.removeValueForOption ("--bank-preset"));
+
+        if (result.failed())
+            return fail (result.getErrorMessage());
+    }
+
+    while (args.containsOption ("--set"))
+    {
+        auto assignment = args.removeValueForOption ("--set");
+        auto result = renderer.setParameter (assignment.upToFirstOccurrenceOf ("=", false, false).trim(),
+                                             assignment.fromFirstOccurrenceOf ("=", false, false).trim());
+
+        if (result.failed())
+            return fail (result.getErrorMessage());
+    }
+
+    if (args.containsOption ("--order"))
+    {
+        auto orderText = args.removeValueForOption ("--order");
+        auto chain = OfflineRenderer::parseDSPChain (orderText);
+
+        if (! chain.has_value())
+            return fail ("Invalid dsp order: " + orderText);
+
+        auto result = renderer.setDSPChain (*chain);
+
+        if (result.failed())
+            return fail (result.getErrorMessage());
+    }
+
+    while (args.containsOption ("--slot-set"))
+    {
+        auto assignment = args.removeValueForOption ("--slot-set");
+        auto slot = assignment.upToFirstOccurrenceOf (":", false, false).trim();
+        auto parameter = assignment.fromFirstOccurrenceOf (":", false, false);
+
+        if (slot.isEmpty() || ! slot.containsOnly ("0123456789") || ! parameter.contains ("="))
+            return fail ("Invalid --slot-set, expected <slot>:<id>=<value>: " + assignment);
+
+        auto result = renderer.setSlotParameter (slot.getIntValue(),
+                                                 parameter.upToFirstOccurrenceOf ("=", false, false).trim(),
+                                                 parameter.fromFirstOccurrenceOf ("=", false, false).trim());
+
+        if (result.failed())
+            return fail (result.getErrorMessage());
+    }
+
+    //parameter ids are checked here, the values are applied while rendering
+    if (args.containsOption ("--automation"))
+    {
+        auto result = renderer.loadAutomation (juce::File::getCurrentWorkingDirectory()
+                                                   .getChildFile (args.removeValueForOption ("--automation")));
+
+        if (result.failed())
+            return fail (result.getErrorMessage());
+    }
+
+    //starts from the preset, --set and --order values, then goes through everything
+    if (rtCheck)
+        return runRealtimeCheck (renderer.getProcessor(), hasBlockSize ? renderer.getBlockSize() : 256);
+
+    juce::File savePresetFile;
+
+    if (args.containsOption ("--save-preset"))
+        savePresetFile = juce::File::getCurrentWorkingDirectory().getChildFile (args.removeValueForOption ("--save-preset"));
+
+    juce::Array<juce::File> inputs;
+
+    for (auto& arg : args.arguments)
+    {
+        if (arg.isOption())
+            return fail ("Unknown option: " + arg.text);
+
+        inputs.add (arg.resolveAsFile());
+    }
+
+    if (savePresetFile != juce::File())
+    {
+        auto result = renderer.savePreset (savePresetFile, savePresetFile.getFileNameWithoutExtension());
+
+        if (result.failed())
+            return fail (result.getErrorMessage());
+
+        if (inputs.isEmpty())
+            return 0;
+    }
+
+    if (inputs.isEmpty())
+        return fail ("No input files");
+
+    if (outputFile != juce::File() && inputs.size() > 1)
+        return fail ("--output only works with a single input, use --output-dir");
+
+    if (outputFile == juce::File() && outputDir == juce::File())
+        return fail ("Either --output or --output-dir is required");
+
+    juce::Array<juce::File> outputs;
+
+    for (auto& input : inputs)
+    {
+        auto output = outputFile;
+
+        if (output == juce::File())
+        {
+            auto extension = outputFormat.isNotEmpty() ? "." + outputFormat : input.getFileExtension();
+            output = outputDir.getChildFile (input.getFileNameWithoutExtension() + extension);
+        }
+
+        outputs.add (output);
+    }
+
+    if (batch)
+    {
+        if (lanePresets.size() > inputs.size())
+            return fail ("More --lane-preset options than inputs");
+
+        //every lane preset is loaded into the processor once to read its values back,
+        //lanes without one keep the shared preset and --set values
+        const auto sharedParameters = BatchChain::Parameters::fromProcessor (renderer.getProcessor());
+        const auto sharedPreset = renderer.getProcessor().createPreset();
+        std::vector<BatchChain::Parameters> laneParameters ((size_t) inputs.size(), sharedParameters);
+
+        for (int i = 0; i < lanePresets.size(); ++i)
+        {
+            auto result = renderer.loadPreset (lanePresets[i]);
+
+            if (result.failed())
+                return fail (result.getErrorMessage());
+
+            laneParameters[(size_t) i] = BatchChain::Parameters::fromProcessor (renderer.getProcessor());
+        }
+
+        renderer.getProcessor().applyPreset (sharedPreset);
+
+        OfflineRenderer::RenderStats stats;
+        auto result = renderer.renderBatch (inputs, outputs, laneParameters, &stats);
+
+        if (result.failed())
+            return fail (result.getErrorMessage());
+
+        std::cout << inputs.size() << " files in one batch  (" << juce::String (stats.audioSeconds, 2)
+                  << " s of audio in " << juce::String (stats.wallSeconds, 2) << " s, "
+                  << juce::String (stats.getRealtimeFactor(), 1) << "x realtime)" << std::endl;
+
+        return 0;
+    }
+
+    if (! lanePresets.isEmpty())
+        return fail ("--lane-preset only works with --batch");
+
+    for (int i = 0; i < inputs.size(); ++i)
+    {
+        auto& input = inputs.getReference (i);
+        auto& output = outputs.getReference (i);
+
+        OfflineRenderer::RenderStats stats;
+        auto result = renderer.render (input, output, &stats);
+
+        if (result.failed())
+            return fail (result.getErrorMessage());
+
+        std::cout << input.getFileName() << " -> " << output.getFullPathName()
+                  << "  (" << juce::String (stats.audioSeconds, 2) << " s of audio in "
+                  << juce::String (stats.wallSeconds, 2) << " s, "
+                  << juce::String (stats.getRealtimeFactor(), 1) << "x realtime)" << std::endl;
+
+        if (profile)
+            std::cout << renderer.getProfile() << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,198 @@
+/*
+  ==============================================================================
+
+    StagePipeline.cpp
+
+  ==============================================================================
+*/
+
+#include "StagePipeline.h"
+
+//==============================================================================
+StagePipeline::BlockQueue::BlockQueue (int capacity)
+    : fifo (capacity + 1),
+      indices ((size_t) capacity + 1)
+{
+}
+
+void StagePipeline::BlockQueue::push (int blockIndex) noexcept
+{
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+    //the queues are sized for every block plus the end marker, so this never fills up
+    jassert (size1 + size2 == 1);
+
+    indices[(size_t) (size1 > 0 ? start1 : start2)] = blockIndex;
+    fifo.finishedWrite (1);
+
+    pushCount.fetch_add (1, std::memory_order_release);
+    pushCount.notify_one();
+}
+
+int StagePipeline::BlockQueue::pop() noexcept
+{
+    for (;;)
+    {
+        //read the count before looking, a push in between changes it and the wait returns straight away
+        const auto count = pushCount.load (std::memory_order_acquire);
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (1, start1, size1, start2, size2);
+
+        if (size1 + size2 > 0)
+        {
+            const auto blockIndex = indices[(size_t) (size1 > 0 ? start1 : start2)];
+            fifo.finishedRead (1);
+            return blockIndex;
+        }
+
+        pushCount.wait (count, std::memory_order_acquire);
+    }
+}
+
+//==============================================================================
+class StagePipeline::StageThread  : public juce::Thread
+{
+public:
+    StageThread (int index, juce::dsp::ProcessorBase& stageToRun, StagePipeline& owner, int tile)
+        : juce::Thread ("multieffects stage " + juce::String (index)),
+          stage (stageToRun),
+          blocks (owner.blocks),
+          input (*owner.queues[index]),
+          output (*owner.queues[index + 1]),
+          tileSize ((size_t) juce::jmax (0, tile))
+    {
+    }
+
+    void run() override
+    {
+        //processBlock runs with denormals off, the same has to hold here for the same output
+        juce::ScopedNoDenormals noDenormals;
+
+        for (;;)
+        {
+            const auto index = input.pop();
+
+            if (index != endOfRender)
+                process (*blocks.getUnchecked (index));
+
+            output.push (index);
+
+            if (index == endOfRender)
+                return;
+        }
+    }
+
+private:
+    //the same tiles as processBlock, each stage keeps its state from one tile to the next
+    void process (juce::AudioBuffer<float>& buffer)
+    {
+        auto block = juce::dsp::AudioBlock<float> (buffer);
+
+        if (tileSize == 0 || block.getNumSamples() <= tileSize)
+        {
+            stage.process (juce::dsp::ProcessContextReplacing<float> (block));
+            return;
+        }
+
+        for (size_t start = 0; start < block.getNumSamples(); start += tileSize)
+        {
+            auto subBlock = block.getSubBlock (start, juce::jmin (tileSize, block.getNumSamples() - start));
+            stage.process (juce::dsp::ProcessContextReplacing<float> (subBlock));
+        }
+    }
+
+    juce::dsp::ProcessorBase& stage;
+    juce::OwnedArray<juce::AudioBuffer<float>>& blocks;
+    BlockQueue& input;
+    BlockQueue& output;
+    const size_t tileSize;
+};
+
+//==============================================================================
+StagePipeline::StagePipeline (const std::vector<juce::dsp::ProcessorBase*>& stages,
+                              int numChannels, int maxBlockSize, int tileSize)
+{
+    jassert (! stages.empty());
+
+    //one block per stage plus one being read and one being written keeps every thread busy
+    const auto numBlocks = (int) stages.size() + 2;
+
+    for (int i = 0; i < numBlocks; ++i)
+        blocks.add (new juce::AudioBuffer<float> (numChannels, maxBlockSize));
+
+    freeBlocks.reserve ((size_t) numBlocks);
+
+    for (size_t i = 0; i <= stages.size(); ++i)
+        queues.add (new BlockQueue (numBlocks + 1));
+
+    for (size_t i = 0; i < stages.size(); ++i)
+        stageThreads.add (new StageThread ((int) i, *stages[i], *this, tileSize));
+}
+
+StagePipeline::~StagePipeline()
+{
+}
+
+bool StagePipeline::run (const FillFunction& fill, const DrainFunction& drain)
+{
+    freeBlocks.clear();
+
+    for (int i = blocks.size(); --i >= 0;)
+        freeBlocks.push_back (i);
+
+    for (auto* thread : stageThreads)
+        thread->startThread (juce::Thread::Priority::high);
+
+    auto& first = *queues.getFirst();
+    auto& last = *queues.getLast();
+
+    int numInFlight = 0;
+    bool inputFinished = false, ok = true;
+
+    for (;;)
+    {
+        //keep the pipeline full, then wait for the oldest block to come out the other end
+        while (! inputFinished && ! freeBlocks.empty())
+        {
+            const auto index = freeBlocks.back();
+
+            if (fill (*blocks.getUnchecked (index)) <= 0)
+            {
+                inputFinished = true;
+                break;
+            }
+
+            freeBlocks.pop_back();
+            first.push (index);
+            ++numInFlight;
+        }
+
+        if (numInFlight == 0)
+            break;
+
+        const auto index = last.pop();
+        --numInFlight;
+
+        //after a failed write the blocks still in flight are only drained, not written
+        if (ok)
+            ok = drain (*blocks.getUnchecked (index));
+
+        if (! ok)
+            inputFinished = true;
+
+        freeBlocks.push_back (index);
+    }
+
+    //the end marker passes every stage, each thread returns once it has forwarded it
+    first.push (endOfRender);
+
+    [[maybe_unused]] const auto marker = last.pop();
+    jassert (marker == endOfRender);
+
+    for (auto* thread : stageThreads)
+        thread->waitForThreadToExit (-1);
+
+    return ok;
+}
@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    StagePipeline.h
+
+    Runs every stage of a serial chain on its own thread for offline renders,
+    so consecutive blocks overlap across the stages.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    A render pipeline with one thread per chain stage. While stage k works on
+    block n, stage k + 1 works on block n - 1. The blocks come from a pool
+    allocated up front and travel between the stages as indices through single
+    producer, single consumer queues, so nothing is copied or allocated while
+    rendering.
+
+    Every stage sees the same blocks, split into the same tiles, in the same
+    order as in MultieffectsAudioProcessor::processBlock, and the stages don't
+    share any state. The output is bit identical to the serial chain with tail
+    skipping off, processBlock then runs every stage on every block as well.
+    The bench's pipeline suite checks that.
+
+    The calling thread reads and writes the audio: run() keeps the pipeline
+    full and returns when the last block has been written.
+*/
+class StagePipeline
+{
+public:
+    /** Fills the buffer with the next block, sized with setSize() to the number
+        of samples in it, and returns that number. 0 ends the render.
+    */
+    using FillFunction = std::function<int (juce::AudioBuffer<float>&)>;
+
+    /** Takes a processed block, false stops the render. */
+    using DrainFunction = std::function<bool (const juce::AudioBuffer<float>&)>;
+
+    /** The stages must be prepared and stay alive until the pipeline is gone.
+        tileSize is the processor's effective tile size, 0 for whole blocks.
+    */
+    StagePipeline (const std::vector<juce::dsp::ProcessorBase*>& stages,
+                   int numChannels, int maxBlockSize, int tileSize);
+    ~StagePipeline();
+
+    /** Streams blocks through all stages until fill returns 0. Returns false
+        when drain asked to stop.
+    */
+    bool run (const FillFunction& fill, const DrainFunction& drain);
+
+    int getNumStages() const { return stageThreads.size(); }
+
+private:
+    //block indices from one thread to the next, -1 marks the end of the render
+    class BlockQueue
+    {
+    public:
+        explicit BlockQueue (int capacity);
+
+        void push (int blockIndex) noexcept;
+        int pop() noexcept;
+
+    private:
+        juce::AbstractFifo fifo;
+        std::vector<int> indices;
+
+        //bumped on every push, a consumer with nothing to read sleeps on it
+        std::atomic<juce::uint32> pushCount { 0 };
+    };
+
+    class StageThread;
+
+    static constexpr int endOfRender = -1;
+
+    //the buffers keep their allocation, only their visible size follows the block
+    juce::OwnedArray<juce::AudioBuffer<float>> blocks;
+    std::vector<int> freeBlocks;
+
+    //queues[k] feeds stage k, the last one goes back to run()
+    juce::OwnedArray<BlockQueue> queues;
+    juce::OwnedArray<StageThread> stageThreads;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StagePipeline)
+};
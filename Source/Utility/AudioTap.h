@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    AudioTap.h
+
+    Copies audio off the audio thread for analysis, wait free on both sides.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    A lock free ring of the last samples that went past some point of the
+    chain, up to two channels, for a reader like the spectrum analyzer.
+
+    The audio thread only pays for a relaxed load while nobody reads, and for a
+    memcpy per channel while someone does. The ring is allocated once in the
+    constructor, and when the reader falls behind the samples that don't fit
+    are dropped, the audio thread never waits for it.
+
+    One thread pushes, one other thread pulls.
+*/
+class AudioTap
+{
+public:
+    static constexpr int maxChannels = 2;
+    static constexpr int capacity = 1 << 15;
+
+    AudioTap()
+        : fifo (capacity),
+          ring (maxChannels, capacity)
+    {
+        ring.clear();
+    }
+
+    //==============================================================================
+    /** The reader turns the tap on while it looks, see drain(). */
+    void setEnabled (bool shouldBeEnabled) noexcept { enabled.store (shouldBeEnabled, std::memory_order_release); }
+    bool isEnabled() const noexcept { return enabled.load (std::memory_order_relaxed); }
+
+    /** From prepareToPlay, for the reader to map bins to frequencies. */
+    void prepare (double newSampleRate) noexcept { sampleRate.store (newSampleRate, std::memory_order_relaxed); }
+    double getSampleRate() const noexcept { return sampleRate.load (std::memory_order_relaxed); }
+
+    //==============================================================================
+    /** Audio thread. A mono buffer goes into both channels, channels past the second are left out. */
+    void push (const juce::AudioBuffer<float>& buffer) noexcept
+    {
+        if (! enabled.load (std::memory_order_acquire) || buffer.getNumChannels() == 0)
+            return;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (buffer.getNumSamples(), start1, size1, start2, size2);
+
+        for (int ch = 0; ch < maxChannels; ++ch)
+        {
+            const auto source = juce::jmin (ch, buffer.getNumChannels() - 1);
+
+            if (size1 > 0)
+                ring.copyFrom (ch, start1, buffer, source, 0, size1);
+
+            if (size2 > 0)
+                ring.copyFrom (ch, start2, buffer, source, size1, size2);
+        }
+
+        fifo.finishedWrite (size1 + size2);
+    }
+
+    //==============================================================================
+    /** Reader. Copies up to destination's length of the oldest samples into its
+        first two channels and returns how many there were.
+    */
+    int pull (juce::AudioBuffer<float>& destination) noexcept
+    {
+        jassert (destination.getNumChannels() >= maxChannels);
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (destination.getNumSamples(), start1, size1, start2, size2);
+
+        for (int ch = 0; ch < maxChannels; ++ch)
+        {
+            if (size1 > 0)
+                destination.copyFrom (ch, 0, ring, ch, start1, size1);
+
+            if (size2 > 0)
+                destination.copyFrom (ch, size1, ring, ch, start2, size2);
+        }
+
+        fifo.finishedRead (size1 + size2);
+        return size1 + size2;
+    }
+
+    /** Reader. Throws away whatever was left over from the last time someone looked. */
+    void drain() noexcept
+    {
+        fifo.finishedRead (fifo.getNumReady());
+    }
+
+private:
+    juce::AbstractFifo fifo;
+    juce::AudioBuffer<float> ring;
+
+    std::atomic<bool> enabled { false };
+    std::atomic<double> sampleRate { 44100.0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AudioTap)
+};
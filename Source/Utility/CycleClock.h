@@ -0,0 +1,63 @@
+/*
+  ==============================================================================
+
+    CycleClock.h
+
+    Cheap cycle counter for timing audio code.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+//==============================================================================
+/**
+    Reads the CPU timestamp counter where there is one (rdtsc on x86, the
+    virtual counter on aarch64) and falls back to the high resolution ticks
+    everywhere else. The counter runs at a constant rate, so convert to time
+    with getTicksPerSecond() rather than assuming the core clock.
+*/
+struct CycleClock
+{
+    static inline juce::uint64 now() noexcept
+    {
+       #if JUCE_INTEL
+        return (juce::uint64) __rdtsc();
+       #elif JUCE_ARM && defined (__aarch64__)
+        juce::uint64 ticks;
+        asm volatile ("mrs %0, cntvct_el0" : "=r" (ticks));
+        return ticks;
+       #else
+        return (juce::uint64) juce::Time::getHighResolutionTicks();
+       #endif
+    }
+
+    /** Counter rate, measured once against the high resolution clock. */
+    static double getTicksPerSecond()
+    {
+        static const double ticksPerSecond = []
+        {
+            const auto hiResStart = juce::Time::getHighResolutionTicks();
+            const auto start = now();
+
+            juce::Thread::sleep (50);
+
+            const auto hiResEnd = juce::Time::getHighResolutionTicks();
+            const auto end = now();
+
+            return (double) (end - start) / juce::Time::highResolutionTicksToSeconds (hiResEnd - hiResStart);
+        }();
+
+        return ticksPerSecond;
+    }
+};
@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    LatestValueMailbox.h
+
+    Hands the latest value of some state from one thread to another, wait
+    free on both sides.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    A triple buffer for small, trivially copyable state like a DSP_Order or a
+    parameter snapshot. One thread pushes, another pulls, and the reader only
+    ever sees the most recent push: values pushed in between are overwritten,
+    not queued, so there is nothing to drain.
+
+    The writer fills its own slot and swaps it into the middle with a single
+    exchange, the reader swaps the middle slot for its own when the new flag is
+    set. Neither side waits for the other or touches a slot the other one owns,
+    so a value can't tear. pull() is O(1) whatever the writer did, and it says
+    whether anything arrived, so no value, the default one included, is ever
+    mistaken for "nothing new".
+
+    Every push gets a sequence number, starting at 1, that the reader can look
+    at to tell how many pushes it skipped.
+*/
+template <typename ValueType>
+class LatestValueMailbox
+{
+public:
+    static_assert (std::is_trivially_copyable_v<ValueType>, "the slots are copied around while the other side runs");
+
+    LatestValueMailbox() = default;
+
+    /** Writer side. Only one thread at a time may push. */
+    void push (const ValueType& value) noexcept
+    {
+        auto& slot = slots[(size_t) writeIndex];
+        slot.value = value;
+        slot.sequence = ++numPushed;
+
+        writeIndex = middle.exchange (writeIndex | newFlag, std::memory_order_acq_rel) & indexMask;
+    }
+
+    /** Reader side. Copies the latest value to result and returns true when
+        something was pushed since the last pull, otherwise leaves result alone.
+    */
+    bool pull (ValueType& result) noexcept
+    {
+        if ((middle.load (std::memory_order_relaxed) & newFlag) == 0)
+            return false;
+
+        readIndex = middle.exchange (readIndex, std::memory_order_acq_rel) & indexMask;
+
+        const auto& slot = slots[(size_t) readIndex];
+        result = slot.value;
+        lastSequence = slot.sequence;
+        return true;
+    }
+
+    /** Reader side, true when a pull would return something. */
+    bool hasNewValue() const noexcept { return (middle.load (std::memory_order_relaxed) & newFlag) != 0; }
+
+    /** Reader side, the sequence number of the value the last pull returned, 0 before the first. */
+    juce::uint64 getLastSequence() const noexcept { return lastSequence; }
+
+    /** Writer side, the number of pushes so far. */
+    juce::uint64 getNumPushed() const noexcept { return numPushed; }
+
+private:
+    struct Slot
+    {
+        ValueType value{};
+        juce::uint64 sequence = 0;
+    };
+
+    static constexpr int indexMask = 3, newFlag = 4;
+
+    std::array<Slot, 3> slots;
+
+    //the middle slot's index plus the new flag, the only thing both threads touch
+    alignas (64) std::atomic<int> middle { 2 };
+
+    //each side's own slot, kept on separate cache lines
+    alignas (64) int writeIndex = 0;
+    juce::uint64 numPushed = 0;
+
+    alignas (64) int readIndex = 1;
+    juce::uint64 lastSequence = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (LatestValueMailbox)
+};
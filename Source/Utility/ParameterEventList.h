@@ -0,0 +1,73 @@
+/*
+  ==============================================================================
+
+    ParameterEventList.h
+
+    Parameter changes at sample offsets into the next block.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+/**
+    A fixed size list of parameter changes for one block, kept sorted by
+    sample offset as they're added. Changes at the same offset stay in the
+    order they came in, so the last one wins. Nothing allocates, so it lives
+    on the audio thread.
+*/
+class ParameterEventList
+{
+public:
+    static constexpr int capacity = 256;
+
+    struct Event
+    {
+        int sampleOffset = 0;
+        int parameterIndex = 0;
+
+        //normalised, like AudioProcessorParameter::setValue
+        float value = 0.f;
+    };
+
+    ParameterEventList() = default;
+
+    /** Returns false when the list is full and the event was dropped. */
+    bool add (int sampleOffset, int parameterIndex, float value) noexcept
+    {
+        jassert (sampleOffset >= 0);
+
+        if (numEvents >= capacity)
+            return false;
+
+        //an insertion sort step, hosts and the renderer add events in order so this rarely moves anything
+        auto index = numEvents;
+
+        for (; index > 0 && events[(size_t) index - 1].sampleOffset > sampleOffset; --index)
+            events[(size_t) index] = events[(size_t) index - 1];
+
+        events[(size_t) index] = { sampleOffset, parameterIndex, value };
+        ++numEvents;
+        return true;
+    }
+
+    void clear() noexcept { numEvents = 0; }
+
+    int size() const noexcept { return numEvents; }
+    bool isEmpty() const noexcept { return numEvents == 0; }
+
+    const Event& operator[] (int index) const noexcept
+    {
+        jassert (juce::isPositiveAndBelow (index, numEvents));
+        return events[(size_t) index];
+    }
+
+private:
+    std::array<Event, capacity> events;
+    int numEvents = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (ParameterEventList)
+};
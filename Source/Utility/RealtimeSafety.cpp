@@ -0,0 +1,268 @@
+/*
+  ==============================================================================
+
+    RealtimeSafety.cpp
+
+  ==============================================================================
+*/
+
+#include "RealtimeSafety.h"
+
+#if MULTIEFFECTS_ENABLE_RT_CHECKS
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if JUCE_LINUX || JUCE_BSD
+ #include <dlfcn.h>
+ #include <pthread.h>
+ #include <semaphore.h>
+ #include <time.h>
+ #include <unistd.h>
+#endif
+
+#if JUCE_LINUX
+ #include <linux/futex.h>
+ #include <sys/syscall.h>
+#endif
+
+namespace RealtimeSafety
+{
+    namespace
+    {
+        //plain ints with constant initialisation, reading them can't allocate or recurse
+        thread_local int realtimeDepth = 0;
+        thread_local int suspendDepth = 0;
+
+        std::atomic<juce::uint64> numViolations { 0 };
+        std::atomic<ViolationHandler> handler { nullptr };
+        std::atomic<void*> handlerContext { nullptr };
+
+        void printViolation (const Violation& violation, void*)
+        {
+            std::fprintf (stderr, "realtime violation: %s on the audio thread\n%s\n",
+                          violation.what, violation.backtrace.toRawUTF8());
+        }
+    }
+
+    ScopedRealtime::ScopedRealtime() noexcept      { ++realtimeDepth; }
+    ScopedRealtime::~ScopedRealtime() noexcept     { --realtimeDepth; }
+
+    ScopedNonRealtime::ScopedNonRealtime() noexcept  { ++suspendDepth; }
+    ScopedNonRealtime::~ScopedNonRealtime() noexcept { --suspendDepth; }
+
+    bool isRealtimeThread() noexcept
+    {
+        return realtimeDepth > 0 && suspendDepth == 0;
+    }
+
+    void check (const char* what) noexcept
+    {
+        if (! isRealtimeThread())
+            return;
+
+        numViolations.fetch_add (1, std::memory_order_relaxed);
+
+        //building the report allocates, which would land right back here
+        const ScopedNonRealtime suspend;
+
+        Violation violation;
+        violation.what = what;
+        violation.backtrace = juce::SystemStats::getStackBacktrace();
+
+        auto* report = handler.load (std::memory_order_acquire);
+        (report != nullptr ? report : printViolation) (violation, handlerContext.load (std::memory_order_acquire));
+    }
+
+    void setViolationHandler (ViolationHandler newHandler, void* context)
+    {
+        handlerContext.store (context, std::memory_order_release);
+        handler.store (newHandler, std::memory_order_release);
+    }
+
+    juce::uint64 getNumViolations() noexcept
+    {
+        return numViolations.load (std::memory_order_relaxed);
+    }
+}
+
+//==============================================================================
+//the global allocation functions. every form ends up in allocate and release,
+//windows needs the aligned heap for all of them so any delete can free any new
+namespace
+{
+    void* allocate (std::size_t size, std::size_t alignment, const char* what) noexcept
+    {
+        RealtimeSafety::check (what);
+
+        size = juce::jmax ((std::size_t) 1, size);
+
+       #if JUCE_WINDOWS
+        return _aligned_malloc (size, alignment);
+       #else
+        if (alignment <= alignof (std::max_align_t))
+            return std::malloc (size);
+
+        void* memory = nullptr;
+        return posix_memalign (&memory, alignment, size) == 0 ? memory : nullptr;
+       #endif
+    }
+
+    void* allocateOrThrow (std::size_t size, std::size_t alignment, const char* what)
+    {
+        if (auto* memory = allocate (size, alignment, what))
+            return memory;
+
+        throw std::bad_alloc();
+    }
+
+    void release (void* memory, const char* what) noexcept
+    {
+        if (memory == nullptr)
+            return;
+
+        RealtimeSafety::check (what);
+
+       #if JUCE_WINDOWS
+        _aligned_free (memory);
+       #else
+        std::free (memory);
+       #endif
+    }
+
+    constexpr auto defaultAlignment = (std::size_t) __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+}
+
+void* operator new   (std::size_t size)                                   { return allocateOrThrow (size, defaultAlignment, "operator new"); }
+void* operator new[] (std::size_t size)                                   { return allocateOrThrow (size, defaultAlignment, "operator new[]"); }
+void* operator new   (std::size_t size, const std::nothrow_t&) noexcept   { return allocate (size, defaultAlignment, "operator new"); }
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept   { return allocate (size, defaultAlignment, "operator new[]"); }
+
+void* operator new   (std::size_t size, std::align_val_t alignment)       { return allocateOrThrow (size, (std::size_t) alignment, "operator new"); }
+void* operator new[] (std::size_t size, std::align_val_t alignment)       { return allocateOrThrow (size, (std::size_t) alignment, "operator new[]"); }
+void* operator new   (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate (size, (std::size_t) alignment, "operator new"); }
+void* operator new[] (std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return allocate (size, (std::size_t) alignment, "operator new[]"); }
+
+void operator delete   (void* memory) noexcept                                          { release (memory, "operator delete"); }
+void operator delete[] (void* memory) noexcept                                          { release (memory, "operator delete[]"); }
+void operator delete   (void* memory, std::size_t) noexcept                             { release (memory, "operator delete"); }
+void operator delete[] (void* memory, std::size_t) noexcept                             { release (memory, "operator delete[]"); }
+void operator delete   (void* memory, const std::nothrow_t&) noexcept                   { release (memory, "operator delete"); }
+void operator delete[] (void* memory, const std::nothrow_t&) noexcept                   { release (memory, "operator delete[]"); }
+
+void operator delete   (void* memory, std::align_val_t) noexcept                        { release (memory, "operator delete"); }
+void operator delete[] (void* memory, std::align_val_t) noexcept                        { release (memory, "operator delete[]"); }
+void operator delete   (void* memory, std::size_t, std::align_val_t) noexcept           { release (memory, "operator delete"); }
+void operator delete[] (void* memory, std::size_t, std::align_val_t) noexcept           { release (memory, "operator delete[]"); }
+void operator delete   (void* memory, std::align_val_t, const std::nothrow_t&) noexcept { release (memory, "operator delete"); }
+void operator delete[] (void* memory, std::align_val_t, const std::nothrow_t&) noexcept { release (memory, "operator delete[]"); }
+
+//==============================================================================
+//locks and blocking calls. on linux a definition in the program wins over the one in
+//libc, so these check and then forward to the real function found with RTLD_NEXT.
+//std::mutex, juce::CriticalSection and juce::WaitableEvent all end up in here, and so
+//do the futex waits of std::atomic::wait and std::counting_semaphore::acquire through
+//syscall. other platforms only get the allocation checks
+#if JUCE_LINUX || JUCE_BSD
+namespace
+{
+    //the caches are constant initialised atomics, a static initialised from dlsym would
+    //take a guard lock the first time and could recurse into these hooks. dlsym with
+    //RTLD_NEXT can hand back the oldest version of a versioned symbol, which for the
+    //condition variables is the compat one with the old pthread_cond_t, so those ask for
+    //the version they were declared with
+    template <typename Function>
+    Function getNext (std::atomic<void*>& cache, const char* name, const char* version = nullptr) noexcept
+    {
+        auto* function = cache.load (std::memory_order_relaxed);
+
+        if (function == nullptr)
+        {
+           #if defined (__GLIBC__)
+            if (version != nullptr)
+                function = dlvsym (RTLD_NEXT, name, version);
+           #else
+            juce::ignoreUnused (version);
+           #endif
+
+            //architectures newer than the version only have the one
+            if (function == nullptr)
+                function = dlsym (RTLD_NEXT, name);
+
+            cache.store (function, std::memory_order_relaxed);
+        }
+
+        return reinterpret_cast<Function> (function);
+    }
+}
+
+#define MULTIEFFECTS_RT_VERSIONED_HOOK(returnType, name, version, parameters, arguments) \
+    returnType name parameters                                                            \
+    {                                                                                     \
+        RealtimeSafety::check (#name);                                                    \
+        static std::atomic<void*> next { nullptr };                                       \
+        return getNext<returnType (*) parameters> (next, #name, version) arguments;       \
+    }
+
+#define MULTIEFFECTS_RT_HOOK(returnType, name, parameters, arguments) \
+    MULTIEFFECTS_RT_VERSIONED_HOOK (returnType, name, nullptr, parameters, arguments)
+
+extern "C"
+{
+    MULTIEFFECTS_RT_HOOK (int, pthread_mutex_lock, (pthread_mutex_t* mutex), (mutex))
+    MULTIEFFECTS_RT_HOOK (int, pthread_rwlock_rdlock, (pthread_rwlock_t* lock), (lock))
+    MULTIEFFECTS_RT_HOOK (int, pthread_rwlock_wrlock, (pthread_rwlock_t* lock), (lock))
+    MULTIEFFECTS_RT_VERSIONED_HOOK (int, pthread_cond_wait, "GLIBC_2.3.2", (pthread_cond_t* condition, pthread_mutex_t* mutex), (condition, mutex))
+    MULTIEFFECTS_RT_VERSIONED_HOOK (int, pthread_cond_timedwait, "GLIBC_2.3.2", (pthread_cond_t* condition, pthread_mutex_t* mutex, const timespec* time), (condition, mutex, time))
+    MULTIEFFECTS_RT_HOOK (int, pthread_join, (pthread_t thread, void** result), (thread, result))
+    MULTIEFFECTS_RT_HOOK (int, sem_wait, (sem_t* semaphore), (semaphore))
+    MULTIEFFECTS_RT_HOOK (int, nanosleep, (const timespec* duration, timespec* remaining), (duration, remaining))
+    MULTIEFFECTS_RT_HOOK (int, usleep, (useconds_t microseconds), (microseconds))
+
+   #if JUCE_LINUX
+    //only the futex operations that wait are violations. a wake, like the one
+    //RealtimeWorkerPool posts to a parked worker or atomic::notify_one, doesn't block.
+    //syscall reads six arguments whatever the call, so they're forwarded the same way
+    long syscall (long number, ...)
+    {
+        long arguments[6];
+
+        va_list list;
+        va_start (list, number);
+
+        for (auto& argument : arguments)
+            argument = va_arg (list, long);
+
+        va_end (list);
+
+        if (number == SYS_futex)
+        {
+            switch (arguments[1] & FUTEX_CMD_MASK)
+            {
+                case FUTEX_WAIT:
+                case FUTEX_WAIT_BITSET:
+                case FUTEX_WAIT_REQUEUE_PI:
+                case FUTEX_LOCK_PI:
+                    RealtimeSafety::check ("futex wait");
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        static std::atomic<void*> next { nullptr };
+        return getNext<long (*) (long, ...)> (next, "syscall") (number, arguments[0], arguments[1], arguments[2],
+                                                                arguments[3], arguments[4], arguments[5]);
+    }
+   #endif
+}
+
+#undef MULTIEFFECTS_RT_HOOK
+#undef MULTIEFFECTS_RT_VERSIONED_HOOK
+#endif
+
+#endif
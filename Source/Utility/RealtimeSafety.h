@@ -0,0 +1,98 @@
+/*
+  ==============================================================================
+
+    RealtimeSafety.h
+
+    Debug instrumentation that catches the audio thread allocating, locking
+    or blocking.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+//1 replaces the global operator new and delete and, on linux, the pthread
+//locks and blocking calls with versions that check the calling thread.
+//the render tool turns it on in debug builds, keep it off in the plugin you ship
+#ifndef MULTIEFFECTS_ENABLE_RT_CHECKS
+ #define MULTIEFFECTS_ENABLE_RT_CHECKS 0
+#endif
+
+//==============================================================================
+/**
+    A thread inside a ScopedRealtime is treated as the audio thread. Anything it
+    does through the hooks, allocating or freeing with new and delete, locking
+    a mutex, waiting on a condition variable, a semaphore, a futex or another
+    thread, or sleeping, is reported as a violation with a backtrace.
+
+    Only waits are caught. Waking another thread (a semaphore release, an
+    atomic notify) is a syscall too but doesn't block, and neither is reported.
+    Neither are syscalls made straight from code that doesn't go through libc.
+
+    The hooks only cost a thread local read on other threads. With the checks
+    compiled out every function here is an empty inline.
+*/
+namespace RealtimeSafety
+{
+    struct Violation
+    {
+        //"operator new", "pthread_mutex_lock", ...
+        const char* what = nullptr;
+        juce::String backtrace;
+    };
+
+    using ViolationHandler = void (*) (const Violation&, void* context);
+
+    constexpr bool isEnabled() noexcept { return MULTIEFFECTS_ENABLE_RT_CHECKS != 0; }
+
+   #if MULTIEFFECTS_ENABLE_RT_CHECKS
+    /** Marks the calling thread as the audio thread until it goes out of scope, nests. */
+    struct ScopedRealtime
+    {
+        ScopedRealtime() noexcept;
+        ~ScopedRealtime() noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedRealtime)
+    };
+
+    /** Lifts the checks inside a ScopedRealtime, for code that's allowed to block. */
+    struct ScopedNonRealtime
+    {
+        ScopedNonRealtime() noexcept;
+        ~ScopedNonRealtime() noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedNonRealtime)
+    };
+
+    bool isRealtimeThread() noexcept;
+
+    /** Called by the hooks, reports what when the calling thread is being checked. */
+    void check (const char* what) noexcept;
+
+    /** The handler runs on the offending thread with the checks lifted, so it may
+        allocate and lock. nullptr restores the default, which prints to stderr.
+        Set it while nothing is processing.
+    */
+    void setViolationHandler (ViolationHandler newHandler, void* context);
+
+    /** Every violation since the program started. */
+    juce::uint64 getNumViolations() noexcept;
+   #else
+    struct ScopedRealtime
+    {
+        ScopedRealtime() noexcept {}
+    };
+
+    struct ScopedNonRealtime
+    {
+        ScopedNonRealtime() noexcept {}
+    };
+
+    inline bool isRealtimeThread() noexcept { return false; }
+    inline void check (const char*) noexcept {}
+    inline void setViolationHandler (ViolationHandler, void*) {}
+    inline juce::uint64 getNumViolations() noexcept { return 0; }
+   #endif
+}
@@ -0,0 +1,218 @@
+/*
+  ==============================================================================
+
+    RealtimeWorkerPool.h
+
+    A small fork/join pool the audio thread can hand work to without locks or
+    allocations.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include <semaphore>
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+//==============================================================================
+/**
+    A fixed set of worker threads, created and destroyed off the audio thread.
+
+    Every worker owns one task slot. runTasks() fills the slots with a plain
+    function pointer and an index, flips each slot to ready with an atomic
+    store, runs one task itself and then waits for the workers. Both sides claim
+    a ready task with a compare and swap, so a task a worker hasn't started by
+    then, because it was parked or descheduled, is run by the caller instead of
+    waited for. Nothing on that path locks, allocates or makes a syscall,
+    except the wake up of a parked worker.
+
+    An idle worker spins on its slot for a while so back to back blocks find it
+    awake, then parks on a semaphore. Before it parks it announces that it is
+    sleeping and checks its slot again, and a submitter only posts the
+    semaphore when it sees that flag, so a task can't be missed and a busy pool
+    never touches the semaphore.
+
+    runTasks() is meant to be called from one thread at a time, the audio
+    thread. When there are more tasks than workers the caller runs the rest.
+*/
+class RealtimeWorkerPool
+{
+public:
+    using TaskFunction = void (*) (void* context, int taskIndex);
+
+    /** Spins before an idle worker parks, roughly tens of microseconds. */
+    static constexpr int defaultSpinCount = 4096;
+
+    explicit RealtimeWorkerPool (int numWorkersToCreate)
+    {
+        jassert (numWorkersToCreate >= 0);
+
+        for (int i = 0; i < numWorkersToCreate; ++i)
+            workers.add (new Worker (i));
+
+        for (auto* worker : workers)
+        {
+            //workers only ever run audio, so they get the audio thread's priority when the os allows it
+            if (! worker->startRealtimeThread (juce::Thread::RealtimeOptions{}))
+                worker->startThread (juce::Thread::Priority::highest);
+        }
+    }
+
+    ~RealtimeWorkerPool()
+    {
+        for (auto* worker : workers)
+        {
+            worker->signalThreadShouldExit();
+            worker->wake();
+        }
+
+        for (auto* worker : workers)
+            worker->stopThread (1000);
+    }
+
+    int getNumWorkers() const noexcept { return workers.size(); }
+
+    /** How long an idle worker spins before it parks. */
+    void setSpinCount (int newSpinCount) noexcept
+    {
+        for (auto* worker : workers)
+            worker->spinCount.store (juce::jmax (0, newSpinCount), std::memory_order_relaxed);
+    }
+
+    /** Runs task (context, i) for every i in [0, numTasks) and returns once they
+        have all finished. Task 0 and whatever doesn't fit on the workers run on
+        the calling thread.
+    */
+    void runTasks (TaskFunction task, void* context, int numTasks) noexcept
+    {
+        jassert (task != nullptr);
+
+        const auto numHandedOff = juce::jlimit (0, workers.size(), numTasks - 1);
+
+        for (int i = 0; i < numHandedOff; ++i)
+            workers.getUnchecked (i)->submit (task, context, i + 1);
+
+        task (context, 0);
+
+        for (int i = numHandedOff + 1; i < numTasks; ++i)
+            task (context, i);
+
+        for (int i = 0; i < numHandedOff; ++i)
+            workers.getUnchecked (i)->join();
+    }
+
+    static inline void pause() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && defined (__aarch64__)
+        asm volatile ("yield");
+       #endif
+    }
+
+private:
+    class Worker  : public juce::Thread
+    {
+    public:
+        explicit Worker (int index)
+            : juce::Thread ("multieffects worker " + juce::String (index))
+        {
+        }
+
+        void submit (TaskFunction newTask, void* newContext, int newIndex) noexcept
+        {
+            jassert (state.load (std::memory_order_relaxed) == idle);
+
+            task = newTask;
+            context = newContext;
+            taskIndex = newIndex;
+
+            //seq_cst on both sides, either this sees the worker asleep or the worker sees the task
+            state.store (ready, std::memory_order_seq_cst);
+
+            if (sleeping.load (std::memory_order_seq_cst))
+                wake();
+        }
+
+        void join() noexcept
+        {
+            //a task the worker hasn't picked up yet, asleep or descheduled, is taken back and run here
+            int expected = ready;
+
+            if (state.compare_exchange_strong (expected, running, std::memory_order_acquire))
+            {
+                task (context, taskIndex);
+                state.store (idle, std::memory_order_relaxed);
+                return;
+            }
+
+            while (state.load (std::memory_order_acquire) != done)
+                pause();
+
+            state.store (idle, std::memory_order_relaxed);
+        }
+
+        void wake() noexcept
+        {
+            semaphore.release();
+        }
+
+        void run() override
+        {
+            int spins = 0;
+
+            while (! threadShouldExit())
+            {
+                int expected = ready;
+
+                if (state.compare_exchange_strong (expected, running, std::memory_order_acquire))
+                {
+                    task (context, taskIndex);
+                    state.store (done, std::memory_order_release);
+                    spins = 0;
+                    continue;
+                }
+
+                if (spins++ < spinCount.load (std::memory_order_relaxed))
+                {
+                    pause();
+                    continue;
+                }
+
+                sleeping.store (true, std::memory_order_seq_cst);
+
+                //an extra post from a submitter that raced with this check only costs one more loop
+                if (state.load (std::memory_order_seq_cst) != ready && ! threadShouldExit())
+                    semaphore.acquire();
+
+                sleeping.store (false, std::memory_order_relaxed);
+                spins = 0;
+            }
+        }
+
+        std::atomic<int> spinCount { defaultSpinCount };
+
+    private:
+        enum : int { idle, ready, running, done };
+
+        std::atomic<int> state { idle };
+        std::atomic<bool> sleeping { false };
+        std::counting_semaphore<> semaphore { 0 };
+
+        TaskFunction task = nullptr;
+        void* context = nullptr;
+        int taskIndex = 0;
+    };
+
+    juce::OwnedArray<Worker> workers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RealtimeWorkerPool)
+};
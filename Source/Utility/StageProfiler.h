@@ -0,0 +1,289 @@
+/*
+  ==============================================================================
+
+    StageProfiler.h
+
+    Per stage and per block timing of the audio thread, as load histograms.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CycleClock.h"
+
+//==============================================================================
+/**
+    Times every stage of the chain and the whole block with the CycleClock and
+    records each block as its load, the time it took over the time the block
+    lasts at the sample rate. 100% is the deadline, a block above it would drop
+    out on a live audio device.
+
+    Every histogram is preallocated and only written from the audio thread:
+    stages add their ticks in between beginBlock() and endBlock(), and
+    endBlock() turns the sums into one load per stage. Parallel branches may
+    add from their worker threads, each stage from one thread at a time. Any
+    other thread can read a Snapshot at any time, the counters are relaxed
+    atomics so a snapshot taken mid block can be one block off between fields.
+
+    Switched off, the audio thread pays for one relaxed load per block.
+*/
+class StageProfiler
+{
+public:
+    static constexpr int maxStages = 16;
+
+    //quarter octave bins from about 0.1% of the deadline up to about 340%,
+    //the first bin takes everything below and the last everything above
+    static constexpr int numBins = 48;
+    static constexpr int binsPerOctave = 4;
+    static constexpr int lowestOctave = -10;
+
+    /** A plain copy of one histogram, safe to keep and look at anywhere. */
+    struct Snapshot
+    {
+        std::array<juce::uint32, numBins> counts{};
+        juce::uint64 numBlocks = 0;
+        juce::uint64 numSamples = 0;
+        juce::uint64 totalTicks = 0;
+        juce::uint64 maxTicks = 0;
+        double maxLoad = 0.0;
+
+        double ticksPerSample = 0.0;
+
+        /** Mean load over every block, as a fraction of the deadline. */
+        double getMeanLoad() const
+        {
+            return numSamples > 0 && ticksPerSample > 0.0 ? (double) totalTicks / ((double) numSamples * ticksPerSample) : 0.0;
+        }
+
+        /** The load below which the given fraction of blocks stayed, from the bins. */
+        double getPercentile (double fraction) const
+        {
+            const auto target = (double) numBlocks * juce::jlimit (0.0, 1.0, fraction);
+            juce::uint64 sum = 0;
+
+            for (int bin = 0; bin < numBins; ++bin)
+            {
+                sum += counts[(size_t) bin];
+
+                if ((double) sum >= target && sum > 0)
+                    return getBinUpperLoad (bin);
+            }
+
+            return 0.0;
+        }
+
+        double getCyclesPerSample() const
+        {
+            return numSamples > 0 ? (double) totalTicks / (double) numSamples : 0.0;
+        }
+    };
+
+    explicit StageProfiler (int numStagesToUse)
+        : numStages (juce::jlimit (1, maxStages, numStagesToUse))
+    {
+    }
+
+    //==============================================================================
+    /** Call off the audio thread, the first time measures the clock for 50 ms. */
+    void setEnabled (bool shouldBeEnabled)
+    {
+        if (shouldBeEnabled)
+            ticksPerSecond.store (CycleClock::getTicksPerSecond(), std::memory_order_relaxed);
+
+        enabled.store (shouldBeEnabled, std::memory_order_release);
+    }
+
+    bool isEnabled() const noexcept { return enabled.load (std::memory_order_relaxed); }
+
+    /** From prepareToPlay, the deadline of a block depends on it. */
+    void prepare (double newSampleRate) noexcept
+    {
+        sampleRate.store (newSampleRate, std::memory_order_relaxed);
+    }
+
+    /** Clears every histogram at the start of the next block, from any thread. */
+    void reset() noexcept { resetRequested.store (true, std::memory_order_release); }
+
+    int getNumStages() const noexcept { return numStages; }
+
+    //==============================================================================
+    /** Audio thread. Returns false when profiling is off, skip the rest of the calls then. */
+    bool beginBlock() noexcept
+    {
+        if (! enabled.load (std::memory_order_acquire))
+            return false;
+
+        if (resetRequested.exchange (false, std::memory_order_acquire))
+        {
+            blockHistogram.clear();
+
+            for (auto& histogram : stageHistograms)
+                histogram.clear();
+        }
+
+        pendingTicks.fill (0);
+        blockStart = CycleClock::now();
+        return true;
+    }
+
+    /** Audio thread or a branch worker, between beginBlock() and endBlock(). */
+    void addStageTicks (int stage, juce::uint64 ticks) noexcept
+    {
+        jassert (juce::isPositiveAndBelow (stage, numStages));
+        pendingTicks[(size_t) stage] += ticks;
+    }
+
+    void endBlock (int numSamples) noexcept
+    {
+        const auto blockTicks = CycleClock::now() - blockStart;
+        const auto rate = sampleRate.load (std::memory_order_relaxed);
+
+        if (numSamples <= 0 || rate <= 0.0)
+            return;
+
+        const auto ticksPerSample = ticksPerSecond.load (std::memory_order_relaxed) / rate;
+        const auto deadlineTicks = ticksPerSample * (double) numSamples;
+
+        blockHistogram.add (blockTicks, deadlineTicks, numSamples);
+
+        for (int i = 0; i < numStages; ++i)
+            stageHistograms[(size_t) i].add (pendingTicks[(size_t) i], deadlineTicks, numSamples);
+    }
+
+    //==============================================================================
+    Snapshot getBlockSnapshot() const { return blockHistogram.getSnapshot (getTicksPerSample()); }
+
+    Snapshot getStageSnapshot (int stage) const
+    {
+        jassert (juce::isPositiveAndBelow (stage, numStages));
+        return stageHistograms[(size_t) stage].getSnapshot (getTicksPerSample());
+    }
+
+    /** A table of every stage and the whole block, stageNames in stage order. */
+    juce::String toString (const juce::StringArray& stageNames) const
+    {
+        juce::String text;
+        text << juce::String ("stage").paddedRight (' ', 12)
+             << juce::String ("blocks").paddedLeft (' ', 10)
+             << juce::String ("cyc/smp").paddedLeft (' ', 10)
+             << juce::String ("mean %").paddedLeft (' ', 10)
+             << juce::String ("p50 %").paddedLeft (' ', 10)
+             << juce::String ("p99 %").paddedLeft (' ', 10)
+             << juce::String ("max %").paddedLeft (' ', 10) << "\n";
+
+        auto addRow = [&text] (const juce::String& name, const Snapshot& snapshot)
+        {
+            text << name.paddedRight (' ', 12)
+                 << juce::String ((juce::int64) snapshot.numBlocks).paddedLeft (' ', 10)
+                 << juce::String (snapshot.getCyclesPerSample(), 1).paddedLeft (' ', 10)
+                 << juce::String (snapshot.getMeanLoad() * 100.0, 2).paddedLeft (' ', 10)
+                 << juce::String (snapshot.getPercentile (0.5) * 100.0, 2).paddedLeft (' ', 10)
+                 << juce::String (snapshot.getPercentile (0.99) * 100.0, 2).paddedLeft (' ', 10)
+                 << juce::String (snapshot.maxLoad * 100.0, 2).paddedLeft (' ', 10) << "\n";
+        };
+
+        for (int i = 0; i < numStages; ++i)
+            addRow (i < stageNames.size() ? stageNames[i] : juce::String (i), getStageSnapshot (i));
+
+        addRow ("block", getBlockSnapshot());
+        return text;
+    }
+
+    //==============================================================================
+    /** Upper edge of a bin as a fraction of the deadline. */
+    static double getBinUpperLoad (int bin) noexcept
+    {
+        return std::exp2 ((double) (bin + 1) / binsPerOctave + lowestOctave);
+    }
+
+    static int getBin (double load) noexcept
+    {
+        if (load <= 0.0)
+            return 0;
+
+        const auto bin = (int) std::floor ((std::log2 (load) - lowestOctave) * binsPerOctave);
+        return juce::jlimit (0, numBins - 1, bin);
+    }
+
+private:
+    //single writer, so plain load and store instead of read modify write
+    struct Histogram
+    {
+        void add (juce::uint64 ticks, double deadlineTicks, int numSamples) noexcept
+        {
+            const auto load = deadlineTicks > 0.0 ? (double) ticks / deadlineTicks : 0.0;
+
+            increment (counts[(size_t) getBin (load)], 1);
+            increment (numBlocks, 1);
+            increment (samples, (juce::uint64) numSamples);
+            increment (totalTicks, ticks);
+
+            if (ticks > maxTicks.load (std::memory_order_relaxed))
+                maxTicks.store (ticks, std::memory_order_relaxed);
+
+            if (load > maxLoad.load (std::memory_order_relaxed))
+                maxLoad.store (load, std::memory_order_relaxed);
+        }
+
+        void clear() noexcept
+        {
+            for (auto& count : counts)
+                count.store (0, std::memory_order_relaxed);
+
+            numBlocks.store (0, std::memory_order_relaxed);
+            samples.store (0, std::memory_order_relaxed);
+            totalTicks.store (0, std::memory_order_relaxed);
+            maxTicks.store (0, std::memory_order_relaxed);
+            maxLoad.store (0.0, std::memory_order_relaxed);
+        }
+
+        Snapshot getSnapshot (double ticksPerSample) const
+        {
+            Snapshot snapshot;
+
+            for (size_t i = 0; i < counts.size(); ++i)
+                snapshot.counts[i] = counts[i].load (std::memory_order_relaxed);
+
+            snapshot.numBlocks = numBlocks.load (std::memory_order_relaxed);
+            snapshot.numSamples = samples.load (std::memory_order_relaxed);
+            snapshot.totalTicks = totalTicks.load (std::memory_order_relaxed);
+            snapshot.maxTicks = maxTicks.load (std::memory_order_relaxed);
+            snapshot.maxLoad = maxLoad.load (std::memory_order_relaxed);
+            snapshot.ticksPerSample = ticksPerSample;
+            return snapshot;
+        }
+
+        template <typename Value, typename Amount>
+        static void increment (std::atomic<Value>& counter, Amount amount) noexcept
+        {
+            counter.store (counter.load (std::memory_order_relaxed) + (Value) amount, std::memory_order_relaxed);
+        }
+
+        std::array<std::atomic<juce::uint32>, numBins> counts{};
+        std::atomic<juce::uint64> numBlocks { 0 }, samples { 0 }, totalTicks { 0 }, maxTicks { 0 };
+        std::atomic<double> maxLoad { 0.0 };
+    };
+
+    double getTicksPerSample() const noexcept
+    {
+        const auto rate = sampleRate.load (std::memory_order_relaxed);
+        return rate > 0.0 ? ticksPerSecond.load (std::memory_order_relaxed) / rate : 0.0;
+    }
+
+    const int numStages;
+
+    std::atomic<bool> enabled { false }, resetRequested { false };
+    std::atomic<double> ticksPerSecond { 0.0 }, sampleRate { 0.0 };
+
+    Histogram blockHistogram;
+    std::array<Histogram, maxStages> stageHistograms;
+
+    //audio thread only, summed over the tiles of the current block
+    std::array<juce::uint64, maxStages> pendingTicks{};
+    juce::uint64 blockStart = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StageProfiler)
+};